@@ -0,0 +1,45 @@
+#include "BootTime.hpp"
+#include "WifiLink.hpp"
+#include <rom/rtc.h> //reset reason
+
+//=====================
+// class functions
+//=====================
+
+int64_t BootTime::s_us[PHASES];
+std::atomic<bool> BootTime::s_set[PHASES];
+
+//phases in the order reached, ms and the step from the one before
+void BootTime::print(WiFiClient& client)
+{
+    static const char* const names[] = {
+        "setup", "serial", "settings", "wifi start", "servers", "loop", "wifi join",
+        "wifi up", "first client", "first uart rx", "first byte",
+    };
+    static_assert(sizeof(names) / sizeof(names[0]) == PHASES, "phase names");
+    client.printf("boot timeline, reset reason %d, wifi %s\n",
+        rtc_get_reset_reason(0), WifiLink::fast_name());
+    int64_t us[PHASES];
+    bool set[PHASES];
+    for(uint8_t i = 0; i < PHASES; i++){
+        set[i] = s_set[i].load(std::memory_order_acquire);
+        us[i] = set[i] ? s_us[i] : 0;
+    }
+    int64_t last = 0;
+    bool left[PHASES];                          //reached, not printed yet
+    memcpy(left, set, sizeof(left));
+    for(;;){
+        int next = -1;                          //earliest not printed yet
+        for(uint8_t i = 0; i < PHASES; i++){
+            if(left[i] and (next < 0 or us[i] < us[next])) next = i;
+        }
+        if(next < 0) break;
+        client.printf("  %-14s %7u.%u ms  +%u ms\n", names[next], (unsigned)(us[next] / 1000),
+            (unsigned)(us[next] / 100 % 10), (unsigned)((us[next] - last) / 1000));
+        last = us[next];
+        left[next] = false;
+    }
+    for(uint8_t i = 0; i < PHASES; i++){
+        if(not set[i]) client.printf("  %-14s not yet\n", names[i]);
+    }
+}
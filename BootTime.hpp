@@ -0,0 +1,39 @@
+#pragma once
+
+#include <WiFi.h>
+#include <atomic>
+#include <esp_timer.h>
+
+//boot timeline- the time each boot phase was first reached, from setup()
+//to the first uart byte bridged to a client (sys timeline)
+//
+//  BootTime::mark(BootTime::SERVERS);
+//
+//a mark is kept only the first time (one load when already marked), so it
+//can sit in a hot path from any task- times are esp_timer_get_time() us
+//(64 bits, from app start or from the wake when the boot was a deep sleep),
+//so a phase first reached hours after boot is still right- two tasks
+//marking at once both store, either time is kept
+
+struct BootTime {
+
+    using phase_t = enum : uint8_t {
+        SETUP, SERIAL_UP, SETTINGS, WIFI_START, SERVERS, LOOP, WIFI_JOIN, WIFI_UP,
+        FIRST_CLIENT, FIRST_RX, FIRST_BYTE, PHASES
+    };
+
+    static void mark    (phase_t p)
+    {
+        if(s_set[p].load(std::memory_order_acquire)) return;
+        s_us[p] = esp_timer_get_time();
+        s_set[p].store(true, std::memory_order_release);
+    }
+
+    static void print   (WiFiClient&);
+
+    private:
+
+    static int64_t              s_us[PHASES];
+    static std::atomic<bool>    s_set[PHASES];  //time stored (phase reached)
+
+};
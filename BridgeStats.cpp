@@ -0,0 +1,27 @@
+#include "BridgeStats.hpp"
+#include <string.h>
+
+//=====================
+// class functions
+//=====================
+
+BridgeStats::BridgeStats()
+{
+    reset();
+}
+
+void BridgeStats::reset()
+{
+    memset(this, 0, sizeof(*this));
+    check_min = UINT32_MAX;
+}
+
+void BridgeStats::check_gap(uint32_t us)
+{
+    if(us < check_min) check_min = us;
+    if(us > check_max) check_max = us;
+    //bucket = log2(us), first bucket also holds 0-1us
+    uint8_t b = 0;
+    for(us >>= 1; us and b < HIST_N - 1; us >>= 1, b++);
+    check_hist[b]++;
+}
@@ -0,0 +1,36 @@
+#pragma once
+
+#include <stdint.h>
+
+//uart bridge counters, plain increments so can be left on
+//(written only by the network side, read by the info console which runs
+//from the same loop)
+
+struct BridgeStats {
+
+    static const uint8_t HIST_N = 16;   //check gap buckets, log2 us
+
+    uint32_t    uart_to_tcp;            //bytes sent to clients (all readers)
+    uint32_t    tcp_to_uart;            //bytes from writer to uart tx ring
+    uint32_t    tcp_writes;             //send calls that sent data
+    uint32_t    tcp_short;              //send calls that took some, less than offered
+    uint32_t    tcp_full;               //send calls that took nothing (socket full)
+    uint32_t    tcp_errors;             //send calls that failed (not socket full)
+    uint32_t    drops;                  //slow readers skipped/closed
+    uint32_t    lz_in;                  //uart bytes compressed
+    uint32_t    lz_out;                 //compressed bytes (IAC escaped)
+    uint32_t    lz_us;                  //time compressing
+    uint32_t    frames;                 //framing- frames (or max pieces) sent
+    uint32_t    frame_held;             //framing- partial frames sent (hold)
+    uint32_t    outage_held;            //most uart bytes held for clients, wifi down
+
+    //time between check() calls- a loop pass, plus any sleep (Reactor)
+    uint32_t    check_min;
+    uint32_t    check_max;
+    uint32_t    check_hist[HIST_N];     //[0] <2us, [1] <4us ... [15] >=32ms
+
+    BridgeStats ();
+    void        check_gap   (uint32_t); //add time between checks us
+    void        reset       ();
+
+};
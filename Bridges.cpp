@@ -0,0 +1,64 @@
+#include "Bridges.hpp"
+#include "NvsSettings.hpp"
+
+//=====================
+// local functions
+//=====================
+
+static const char* const names[Bridges::MAXN] = { "uart0", "uart1", "uart2" };
+static TelnetServer* servers[Bridges::MAXN];
+static bool started;
+
+//=====================
+// class functions
+//=====================
+
+void Bridges::start()
+{
+    started = true;
+    for(uint8_t n = 0; n < MAXN; n++) apply(n);
+}
+
+void Bridges::stop()
+{
+    for(auto s : servers) if(s and s->running()) s->stop();
+    started = false;
+}
+
+void Bridges::check()
+{
+    for(auto s : servers) if(s and s->running()) s->check();
+}
+
+void Bridges::apply(uint8_t n)
+{
+    if(n >= MAXN or not started) return;
+    NvsSettings settings;
+    TelnetServer*& s = servers[n];
+    if(s and s->running()) s->stop();
+    if(not settings.uartenable(n)) return;
+    if(not s) s = new TelnetServer(settings.uartport(n), names[n], (TelnetServer::serve_t)n);
+    s->port(settings.uartport(n));
+    s->start();
+}
+
+TelnetServer* Bridges::get(uint8_t n)
+{
+    if(n >= MAXN or not servers[n] or not servers[n]->running()) return nullptr;
+    return servers[n];
+}
+
+void Bridges::status(WiFiClient& client)
+{
+    for(uint8_t n = 0; n < MAXN; n++) if(get(n)) get(n)->status(client);
+}
+
+void Bridges::stats(WiFiClient& client)
+{
+    for(uint8_t n = 0; n < MAXN; n++) if(get(n)) get(n)->stats(client);
+}
+
+void Bridges::stats_reset()
+{
+    for(uint8_t n = 0; n < MAXN; n++) if(get(n)) get(n)->stats_reset();
+}
@@ -0,0 +1,32 @@
+#pragma once
+
+#include <WiFi.h>
+#include "TelnetServer.hpp"
+
+//the uart bridges, one TelnetServer per enabled uart port (0-2), each
+//port's tcp port, pins, baud, framing, polarity from nvs settings
+//(uart<n>...), all serviced by the one UartBridge task
+//
+//a bridge is created the first time its port is enabled and kept after
+//that (a disabled bridge is only stopped), so the uart task never sees a
+//bridge go away
+
+struct Bridges {
+
+    static const uint8_t MAXN = 3;
+
+    static void start   ();                 //start enabled bridges
+    static void stop    ();
+    static void check   ();
+
+    //port n enable or tcp port setting changed- stop, restart if enabled
+    //(only when started)
+    static void apply   (uint8_t);
+
+    static TelnetServer* get(uint8_t);      //-> running bridge n or nullptr
+
+    static void status  (WiFiClient&);      //all running bridges
+    static void stats   (WiFiClient&);
+    static void stats_reset();
+
+};
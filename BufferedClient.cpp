@@ -0,0 +1,48 @@
+#include "BufferedClient.hpp"
+
+//=====================
+// class functions
+//=====================
+
+BufferedClient::BufferedClient(WiFiClient& c) : WiFiClient(c), m_out(c)
+{
+}
+
+size_t BufferedClient::write(uint8_t c)
+{
+    return write(&c, 1);
+}
+
+size_t BufferedClient::write(const uint8_t* p, size_t n)
+{
+    for(size_t left = n; left;){
+        size_t k = SIZE - m_len < left ? SIZE - m_len : left;
+        memcpy(&m_buf[HEAD + m_len], p, k);
+        m_len += k;
+        p += k;
+        left -= k;
+        if(m_len == SIZE) push();
+    }
+    return n;
+}
+
+void BufferedClient::push()
+{
+    if(not m_len) return;
+    send(&m_buf[HEAD], m_len);
+    m_len = 0;
+}
+
+//the client write can take less than all (its send timeout ran out with
+//the socket still full)- the rest is written again, a write that takes
+//nothing means the reader is gone or stuck, so the client is stopped
+//rather than leaving a hole in the output
+void BufferedClient::send(uint8_t* p, size_t n)
+{
+    while(n){
+        size_t k = m_out.write(p, n);
+        if(not k){ m_out.stop(); return; }
+        p += k;
+        n -= k;
+    }
+}
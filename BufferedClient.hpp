@@ -0,0 +1,42 @@
+#pragma once
+
+#include <WiFi.h>
+
+//WiFiClient that collects what is printed to it and writes it on to the
+//client in large pieces, when the buffer is full or on push()- so the many
+//small prints of a command go out as a few full tcp segments (the servers
+//set no delay, so each write to the client would be a segment of its own)
+//
+//a copy of the client (shares the socket), so anything else done with it
+//works as on the client, only writes are buffered
+//
+//send() writes out one buffer full (all of it, or the client is stopped),
+//a subclass can frame it (http chunks)- HEAD bytes before the data and
+//TAIL bytes after it are free for that
+
+struct BufferedClient : WiFiClient {
+
+    BufferedClient      (WiFiClient&);
+
+    size_t      write       (uint8_t) override;
+    size_t      write       (const uint8_t*, size_t) override;
+    using WiFiClient::write;
+    void        push        ();             //write out what is buffered
+
+    //data bytes per write, so with chunk framing still one segment (mss 1436)
+    static const size_t SIZE = 1424;
+    static const size_t HEAD = 8;
+    static const size_t TAIL = 2;
+
+    protected:
+
+    virtual void send   (uint8_t*, size_t); //data (HEAD free before, TAIL after), bytes
+
+    WiFiClient&         m_out;
+
+    private:
+
+    uint8_t             m_buf[HEAD + SIZE + TAIL];
+    size_t              m_len{0};
+
+};
@@ -1,5 +1,6 @@
 #include "Button.hpp"
 #include "Arduino.h" //pin stuff
+#include "Reactor.hpp"
 
 Button::Button(uint8_t pin, uint16_t ms)
 : m_pin(pin), m_lastms(0), m_prev_state(UP), m_long_ms(ms)
@@ -9,7 +10,7 @@ Button::Button(uint8_t pin, uint16_t ms)
 
 uint16_t Button::pressed(){
     if(up()){
-        m_prev_state == UP;                     //save state
+        m_prev_state = UP;                      //save state
         return 0;                               //up always 0
     }
     if(m_prev_state == UP){                     //down, if just pressed-
@@ -23,3 +24,14 @@ auto Button::state() -> state_t { return (state_t)digitalRead(m_pin); }
 bool Button::down(){ return state() == DOWN; }
 bool Button::up(){ return state() == UP; }
 bool Button::long_press(){ return pressed() > m_long_ms; }
+
+void Button::arm()
+{
+    if(not m_armed){
+        attachInterrupt(m_pin, Reactor::wake_isr, CHANGE);
+        m_armed = true;
+    }
+    if(up() or m_prev_state == UP) return;
+    uint32_t ms = millis() - m_lastms;
+    Reactor::due(ms > m_long_ms ? 0 : (m_long_ms - ms + 1) * 1000);
+}
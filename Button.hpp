@@ -15,6 +15,10 @@ struct Button {
     bool        up          ();
     bool        long_press  ();
 
+    //main loop sleep (Reactor)- a pin change wakes the loop, while down
+    //it is also checked when a long press is due
+    void        arm         ();
+
     private:
 
     using state_t = enum : bool { DOWN, UP };
@@ -22,6 +26,7 @@ struct Button {
     uint32_t        m_lastms;
     state_t         m_prev_state;
     uint16_t        m_long_ms;
+    bool            m_armed{false};         //pin interrupt attached
 
     state_t         state();
 };
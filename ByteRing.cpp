@@ -0,0 +1,112 @@
+#include "ByteRing.hpp"
+#include <stdlib.h>
+
+//=====================
+// local functions
+//=====================
+
+//round up to power of 2
+static size_t pow2(size_t n)
+{
+    size_t p = 1;
+    while(p < n) p <<= 1;
+    return p;
+}
+
+//=====================
+// class functions
+//=====================
+
+ByteRing::ByteRing(size_t n)
+    : m_buf(n ? (uint8_t*)malloc(pow2(n)) : nullptr),
+    m_mask(m_buf ? pow2(n) - 1 : 0)
+{
+}
+
+ByteRing::~ByteRing()
+{
+    free(m_buf);
+}
+
+//as clear- only when neither side is active
+//(large buffers come from psram when the heap has it- malloc over the
+//internal threshold)
+bool ByteRing::resize(size_t n)
+{
+    if(n and pow2(n) == size()){ clear(); return true; }
+    free(m_buf);
+    m_buf = n ? (uint8_t*)malloc(pow2(n)) : nullptr;
+    m_mask = m_buf ? pow2(n) - 1 : 0;
+    m_head.store(0);
+    m_tail.store(0);
+    m_high.store(0);
+    return m_buf or not n;
+}
+
+size_t ByteRing::size(){ return m_buf ? m_mask + 1 : 0; }
+size_t ByteRing::used(){ return m_head.load(std::memory_order_acquire) - m_tail.load(std::memory_order_acquire); }
+size_t ByteRing::space(){ return size() - used(); }
+void ByteRing::clear(){ m_tail.store(m_head.load()); }
+size_t ByteRing::high_water(){ return m_high.load(std::memory_order_relaxed); }
+void ByteRing::high_water_reset(){ m_high.store(used(), std::memory_order_relaxed); }
+
+uint8_t* ByteRing::write_span(size_t& len)
+{
+    len = 0;
+    if(not m_buf) return nullptr;
+    size_t head = m_head.load(std::memory_order_relaxed);   //own index
+    size_t idx = head & m_mask;
+    size_t end = m_mask + 1 - idx;              //bytes to end of buffer
+    len = m_mask + 1 - (head - m_tail.load(std::memory_order_acquire));
+    if(len > end) len = end;                    //contiguous part only
+    return &m_buf[idx];
+}
+
+//release- data written into the span is visible before the new head
+void ByteRing::commit(size_t n)
+{
+    if(not n) return;
+    size_t head = m_head.load(std::memory_order_relaxed) + n;
+    m_head.store(head, std::memory_order_release);
+    size_t u = head - m_tail.load(std::memory_order_relaxed);
+    if(u > m_high.load(std::memory_order_relaxed)) m_high.store(u, std::memory_order_relaxed);
+}
+
+uint8_t* ByteRing::read_span(size_t& len)
+{
+    len = 0;
+    if(not m_buf) return nullptr;
+    size_t tail = m_tail.load(std::memory_order_relaxed);   //own index
+    size_t idx = tail & m_mask;
+    size_t end = m_mask + 1 - idx;              //bytes to end of buffer
+    len = m_head.load(std::memory_order_acquire) - tail;
+    if(len > end) len = end;                    //contiguous part only
+    return &m_buf[idx];
+}
+
+//release- span is done being read before the producer can reuse it
+void ByteRing::consume(size_t n)
+{
+    if(not n) return;
+    m_tail.store(m_tail.load(std::memory_order_relaxed) + n, std::memory_order_release);
+}
+
+size_t ByteRing::head(){ return m_head.load(std::memory_order_acquire); }
+size_t ByteRing::tail(){ return m_tail.load(std::memory_order_relaxed); }
+
+//cursor must be between tail and head
+uint8_t* ByteRing::read_span(size_t cur, size_t& len)
+{
+    len = 0;
+    if(not m_buf) return nullptr;
+    size_t idx = cur & m_mask;
+    size_t end = m_mask + 1 - idx;              //bytes to end of buffer
+    len = m_head.load(std::memory_order_acquire) - cur;
+    if(len > end) len = end;                    //contiguous part only
+    return &m_buf[idx];
+}
+
+void ByteRing::consume_to(size_t cur)
+{
+    m_tail.store(cur, std::memory_order_release);
+}
@@ -0,0 +1,63 @@
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include <atomic>
+
+//byte ring buffer, accessed in contiguous spans so data can be moved
+//directly from a source into the ring, and from the ring to a sink
+//(no intermediate bounce buffer)
+//
+//  producer-   p = write_span(n);  fill up to n bytes at p;  commit(count);
+//  consumer-   p = read_span(n);   use up to n bytes at p;   consume(count);
+//
+//size is rounded up to a power of 2, head/tail are free running indexes
+//
+//single producer/single consumer lock-free- the producer only writes the
+//head and the consumer only writes the tail, so one task (or core) can fill
+//while another drains without locking (clear only when neither side is active)
+//
+//the consumer side can also be shared by several readers (all run by the
+//same consumer task), each with its own cursor- data is read in place from
+//a cursor, and the tail is moved to the slowest reader with consume_to()
+
+struct ByteRing {
+
+    //size in bytes (0 = no buffer, ring unused)
+    ByteRing            (size_t);
+    ~ByteRing           ();
+
+    size_t      size        ();         //capacity
+    size_t      used        ();         //bytes stored
+    size_t      space       ();         //bytes free
+    void        clear       ();         //discard all data
+    bool        resize      (size_t);   //new buffer, data discarded (false = no memory)
+    size_t      high_water  ();         //max bytes stored since reset
+    void        high_water_reset();
+
+    //producer
+    uint8_t*    write_span  (size_t&);  //-> free span, arg set to its length
+    void        commit      (size_t);   //bytes written into write span
+
+    //consumer
+    uint8_t*    read_span   (size_t&);  //-> data span, arg set to its length
+    void        consume     (size_t);   //bytes used from read span
+
+    //consumer, multiple readers
+    size_t      head        ();         //write index (cursor of newest data)
+    size_t      tail        ();         //read index (cursor of oldest data)
+    uint8_t*    read_span   (size_t, size_t&); //cursor -> data span from cursor
+    void        consume_to  (size_t);   //move tail to cursor
+
+    private:
+
+    ByteRing            (const ByteRing&) = delete;
+    ByteRing& operator= (const ByteRing&) = delete;
+
+    uint8_t*    m_buf;
+    size_t      m_mask;
+    std::atomic<size_t> m_head{0};      //write index (producer)
+    std::atomic<size_t> m_tail{0};      //read index (consumer)
+    std::atomic<size_t> m_high{0};      //high water mark (producer)
+
+};
@@ -0,0 +1,94 @@
+#include "Capture.hpp"
+#include <Arduino.h>
+
+//=====================
+// local functions
+//=====================
+
+//-> bytes used
+static size_t varint(uint8_t* p, uint32_t v)
+{
+    size_t n = 0;
+    for(; v >= 0x80; v >>= 7) p[n++] = v | 0x80;
+    p[n++] = v;
+    return n;
+}
+
+static void put32(uint8_t* p, uint32_t v)
+{
+    for(auto i = 0; i < 4; i++) p[i] = v >> (8 * i);
+}
+
+//=====================
+// class functions
+//=====================
+
+Capture::~Capture()
+{
+    free(m_buf);
+}
+
+//buffer kept between captures, reallocated only for a new size- not while
+//a reader holds it (-> false)
+bool Capture::start(size_t size, uint32_t baud)
+{
+    if(m_readers) return false;
+    m_on = false;
+    if(size < HEADER + 64) size = HEADER + 64;
+    if(size != m_size){
+        free(m_buf);
+        m_buf = (uint8_t*)malloc(size);
+        m_size = m_buf ? size : 0;
+        if(not m_buf){ m_len = 0; return false; }
+    }
+    m_last_us = micros();
+    memcpy(m_buf, "U2CP\x01\0\0\0", 8);
+    put32(&m_buf[8], baud);
+    put32(&m_buf[12], m_last_us);
+    m_records = 0;
+    m_full = false;
+    m_len.store(HEADER, std::memory_order_release);
+    m_on = true;
+    return true;
+}
+
+void Capture::stop()
+{
+    m_on = false;
+}
+
+//record header at most 1 + 5 + 5 bytes
+void Capture::append(uint8_t dir, const uint8_t* p, size_t len)
+{
+    if(not len or not m_on.load(std::memory_order_relaxed)) return;
+    size_t pos = m_len.load(std::memory_order_relaxed);   //own index
+    if(pos + 11 + len > m_size){
+        m_full = true;
+        m_on = false;
+        return;
+    }
+    uint32_t now = micros();
+    uint8_t* d = &m_buf[pos];
+    *d++ = dir;
+    d += varint(d, now - m_last_us);
+    d += varint(d, len);
+    memcpy(d, p, len);
+    m_last_us = now;
+    m_records.store(m_records.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    m_len.store(d + len - m_buf, std::memory_order_release);
+}
+
+void Capture::hold(){ m_readers++; }
+void Capture::release(){ if(m_readers) m_readers--; }
+bool Capture::held(){ return m_readers; }
+
+bool Capture::on(){ return m_on; }
+bool Capture::full(){ return m_full; }
+size_t Capture::size(){ return m_size; }
+uint32_t Capture::records(){ return m_records; }
+
+const uint8_t* Capture::data(size_t& len)
+{
+    len = m_buf ? m_len.load(std::memory_order_acquire) : 0;
+    return m_buf;
+}
@@ -0,0 +1,62 @@
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include <atomic>
+
+//timestamped capture of uart traffic, both directions, into one buffer
+//
+//  header-     "U2CP" version(1) 0 0 0 baud(u32) start_us(u32)   16 bytes
+//  record-     dir(u8) delta_us(varint) len(varint) data[len]
+//
+//dir 0 = uart rx (target -> net), 1 = uart tx (net -> target), delta is
+//from the previous record (the first from start_us), varints are 7 bits per
+//byte low first, high bit set = more (all little endian)
+//
+//the uart task appends one record per span moved (not per byte), the
+//network side reads the records so far at any time- the buffer is only
+//appended to, the length is published after each record
+//capture stops when the next record does not fit
+//
+//a download holds the buffer (hold/release) while it sends from it, a new
+//capture is not started while held (start would reset or reallocate it)
+//
+//host/capdec converts a capture to text or pcap
+
+struct Capture {
+
+    enum : uint8_t { RX = 0, TX = 1 };
+
+    static const size_t HEADER = 16;
+
+    ~Capture            ();
+
+    //network side, appends stopped (see UartBridge::capture_start)
+    bool        start       (size_t, uint32_t); //buffer size, baud -> false if no memory
+    void        stop        ();
+
+    //uart task
+    void        append      (uint8_t, const uint8_t*, size_t); //dir, data, len
+
+    //network side
+    bool        on          ();
+    bool        full        ();             //stopped because buffer full
+    const uint8_t* data     (size_t&);      //-> header and records, arg set to len
+    void        hold        ();             //a reader is sending from data()
+    void        release     ();
+    bool        held        ();
+    size_t      size        ();             //buffer size
+    uint32_t    records     ();
+
+    private:
+
+    uint8_t*            m_buf{nullptr};
+    size_t              m_size{0};
+    std::atomic<size_t> m_len{0};           //published length
+    std::atomic<bool>   m_on{false};
+    std::atomic<bool>   m_full{false};
+    std::atomic<uint32_t> m_records{0};
+    uint32_t            m_last_us{0};       //uart task only
+    uint8_t             m_readers{0};       //network side only
+
+};
@@ -1,137 +1,324 @@
 #include "Commander.hpp"
 #include "NvsSettings.hpp"
 #include "TelnetServer.hpp"
+#include "Bridges.hpp"
+#include "WebServer.hpp"
+#include "EventLog.hpp"
+#include "Reactor.hpp"
+#include "WifiLink.hpp"
+#include "BootTime.hpp"
 
 extern TelnetServer telnet_info;
-extern TelnetServer telnet_uart2;
+extern TelnetServer telnet_trace;
+extern TelnetServer telnet_log;
+extern WebServer web_server;
 
 //=============================================================================
 // commands
 //=============================================================================
+static void help(WiFiClient&, const char* = "");
+static void bye(WiFiClient&, const char*);
 //sys
-static void sys_bootAP(WiFiClient&, String);
-static void sys_reboot(WiFiClient&, String);
-static void sys_erase(WiFiClient&, String);
+static void sys_bootAP(WiFiClient&, const char*);
+static void sys_reboot(WiFiClient&, const char*);
+static void sys_erase(WiFiClient&, const char*);
+static void sys_save(WiFiClient&, const char*);
+static void sys_log(WiFiClient&, const char*);
+static void sys_timeline(WiFiClient&, const char*);
 //wifi
-static void wifi_list(WiFiClient&, String);
-static void wifi_add(WiFiClient&, String);
-static void wifi_erase(WiFiClient&, String);
+static void wifi_list(WiFiClient&, const char*);
+static void wifi_add(WiFiClient&, const char*);
+static void wifi_erase(WiFiClient&, const char*);
+static void wifi_reboot(WiFiClient&, const char*);
+static void wifi_fast(WiFiClient&, const char*);
 //net
-static void net_hostname(WiFiClient&, String);
-static void net_APname(WiFiClient&, String);
-static void net_mac(WiFiClient&, String);
-static void net_servers(WiFiClient&, String);
-//uart2
-static void uart2_baud(WiFiClient&, String);
+static void net_hostname(WiFiClient&, const char*);
+static void net_APname(WiFiClient&, const char*);
+static void net_mac(WiFiClient&, const char*);
+static void net_servers(WiFiClient&, const char*);
+//stats
+static void stats_show(WiFiClient&, const char*);
+static void stats_reset(WiFiClient&, const char*);
+//uart0-2 (template arg = port)
+template<uint8_t N> static void uart_enable(WiFiClient&, const char*);
+template<uint8_t N> static void uart_port(WiFiClient&, const char*);
+template<uint8_t N> static void uart_pins(WiFiClient&, const char*);
+template<uint8_t N> static void uart_baud(WiFiClient&, const char*);
+template<uint8_t N> static void uart_framing(WiFiClient&, const char*);
+template<uint8_t N> static void uart_invert(WiFiClient&, const char*);
+template<uint8_t N> static void uart_telnet(WiFiClient&, const char*);
+template<uint8_t N> static void uart_compress(WiFiClient&, const char*);
+template<uint8_t N> static void uart_drop(WiFiClient&, const char*);
+template<uint8_t N> static void uart_coalesce(WiFiClient&, const char*);
+template<uint8_t N> static void uart_backlog(WiFiClient&, const char*);
+template<uint8_t N> static void uart_replay(WiFiClient&, const char*);
+template<uint8_t N> static void uart_capture(WiFiClient&, const char*);
+template<uint8_t N> static void uart_driver(WiFiClient&, const char*);
+template<uint8_t N> static void uart_packet(WiFiClient&, const char*);
+template<uint8_t N> static void uart_flow(WiFiClient&, const char*);
 
 //=============================================================================
-// command list - name:function
+// command list - root, sub:function, help (usage is shown after the root)
 //=============================================================================
-using cmdfunc_t = void(*)(WiFiClient&, String);
-using cmd_t = struct {
-    const char* cmd;
-    cmdfunc_t func;
-    const char* help;
+using cmd_t = Commander::cmd_t;
+
+//the same group for each uart port
+#define UART_COMMANDS(n) \
+        { "uart" #n,  NULL,       NULL,             NULL,                                 NULL }, \
+        { "uart" #n,  "enable",   uart_enable<n>,   "<enable | enable=0/1>",              "view or set uart" #n " bridge on/off" }, \
+        { "uart" #n,  "port",     uart_port<n>,     "<port | port=2302>",                 "view or set tcp port" }, \
+        { "uart" #n,  "pins",     uart_pins<n>,     "<pins | pins=rx,tx>",                "view or set rx/tx pins (-1=default)" }, \
+        { "uart" #n,  "baud",     uart_baud<n>,     "<baud | baud=115200>",               "view or set baudrate" }, \
+        { "uart" #n,  "framing",  uart_framing<n>,  "<framing | framing=8N1>",            "view or set data bits/parity N,E,O/stop bits 1,2" }, \
+        { "uart" #n,  "invert",   uart_invert<n>,   "<invert | invert=0/1>",              "view or set rx/tx inverted" }, \
+        { "uart" #n,  "telnet",   uart_telnet<n>,   "<telnet | telnet=0/1>",              "view or set telnet protocol (0=raw tcp)" }, \
+        { "uart" #n,  "compress", uart_compress<n>, "<compress | compress=0/1>",          "view or set lz allowed (telnet client asks, DO 88)" }, \
+        { "uart" #n,  "drop",     uart_drop<n>,     "<drop | drop=skip/close>",           "view or set slow reader policy" }, \
+        { "uart" #n,  "coalesce", uart_coalesce<n>, "<coalesce | coalesce=n,g,h>",        "view or set uart->tcp send size/gap us/hold us (0=auto)" }, \
+        { "uart" #n,  "backlog",  uart_backlog<n>,  "<backlog | backlog=n,f,r>",          "view or set backlog bytes/when full wrap,stop/replay auto,req" }, \
+        { "uart" #n,  "replay",   uart_replay<n>,   "replay",                             "send backlog again to clients" }, \
+        { "uart" #n,  "capture",  uart_capture<n>,  "<capture | capture=start,KB>",       "view, start (KB default 32) or =stop capture, http /uart" #n "/capture" }, \
+        { "uart" #n,  "driver",   uart_driver<n>,   "<driver | driver=r,f,i>",            "view or set driver rx ring bytes/fifo full bytes/idle char times" }, \
+        { "uart" #n,  "packet",   uart_packet<n>,   "<packet | packet=m[,a]>",            "view or set uart->tcp framing none/line/delim,hex/length,1-2/idle,chars" }, \
+        { "uart" #n,  "flow",     uart_flow<n>,     "<flow | flow=none/xoff/rts,r[,c]>",  "view or set rx flow control- xon/xoff, or rts (cts) pins" },
+
+static constexpr cmd_t commands[] = {
+        //root        sub         function          usage                                 help
+        { "help",     NULL,       help,             "",                                   "you are here" },
+        { "bye",      NULL,       bye,              "",                                   "close this connection" },
+
+        { "sys",      NULL,       NULL,             NULL,                                 NULL },
+        { "sys",      "bootAP",   sys_bootAP,       "<bootAP | bootAP=0 | bootAP=1>",     "view or set boot flag" },
+        { "sys",      "reboot",   sys_reboot,       "reboot",                             "reset esp32" },
+        { "sys",      "erase",    sys_erase,        "erase",                              "erase all stored settings" },
+        { "sys",      "save",     sys_save,         "save",                               "store changed settings now" },
+        { "sys",      "log",      sys_log,          "<log | log=off/serial/telnet/both>", "view or set event log to uart0/telnet port 2304" },
+        { "sys",      "timeline", sys_timeline,     "timeline",                           "view boot phase times, to first byte bridged" },
+
+        { "wifi",     NULL,       NULL,             NULL,                                 NULL },
+        { "wifi",     "list",     wifi_list,        "list",                               "list all stored wifi connections" },
+        { "wifi",     "add",      wifi_add,         "add # <ssid=name | pass=pw>",        "add ssid or password for index# 0-7" },
+        { "wifi",     "erase",    wifi_erase,       "erase #",                            "erase stored wifi info in index# 0-7" },
+        { "wifi",     "reboot",   wifi_reboot,      "<reboot | reboot=seconds>",          "view or set reboot when wifi down seconds (0=never)" },
+        { "wifi",     "fast",     wifi_fast,        "<fast | fast=off/bssid/ip>",         "view or set reconnect to last ap first (ip = and its dhcp lease)" },
+
+        { "net",      NULL,       NULL,             NULL,                                 NULL },
+        { "net",      "hostname", net_hostname,     "<hostname | hostname=myname>",       "view or set hostname" },
+        { "net",      "APname",   net_APname,       "<APname | APname=myapname>",         "view or set access point name" },
+        { "net",      "mac",      net_mac,          "mac",                                "view mac address" },
+        { "net",      "servers",  net_servers,      "servers",                            "view telnet server status and rates" },
+
+        { "stats",    NULL,       NULL,             NULL,                                 NULL },
+        { "stats",    "show",     stats_show,       "show",                               "view bridge, main loop and wifi statistics" },
+        { "stats",    "reset",    stats_reset,      "reset",                              "clear bridge statistics" },
+
+        UART_COMMANDS(0)
+        UART_COMMANDS(1)
+        UART_COMMANDS(2)
 };
 
-static cmd_t commands[] = {
-        //name          function        help
-        { "help",       NULL,           "help                               :you are here" },
-        { "bye",        NULL,           "bye                                :close this connection" },
-        { "sys",        NULL,           NULL },
-        {   "bootAP",   sys_bootAP,     "sys <bootAP | bootAP=0 | bootAP=1> :view or set boot flag" },
-        {   "reboot",   sys_reboot,     "sys reboot                         :reset esp32" },
-        {   "erase",    sys_erase,      "sys erase                          :erase all stored settings" },
-
-        { "wifi",       NULL,           NULL },
-        {   "list",     wifi_list,      "wifi list                          :list all stored wifi connections" },
-        {   "add",      wifi_add,       "wifi add # <ssid=name | pass=pw>   :add ssid or password for index# 0-7" },
-        {   "erase",    wifi_erase,     "wifi erase #                       :erase stored wifi info in index# 0-7" },
-
-        { "net",        NULL,           NULL },
-        {   "hostname", net_hostname,   "net <hostname | hostname=myname>   :view or set hostname" },
-        {   "APname",   net_APname,     "net <APname | APname=myapname>     :view or set access point name" },
-        {   "mac",      net_mac,        "net mac                            :view mac address" },
-        {   "servers",  net_servers,    "net servers                        :view telnet server status" },
-
-        { "uart2",      NULL,           NULL },
-        {   "baud",     uart2_baud,     "uart2 <baud | baud=115200>         :view or set uart2 baudrate" },
-
-        { NULL,         NULL }              //end of table
+//=============================================================================
+// command lookup - perfect hash
+//=============================================================================
+//key is fnv-1a of "root" or "root sub", the top SLOT_BITS of the key pick a
+//slot in the index- the hash seed is searched at compile time so every
+//command gets its own slot, so a lookup is one hash of the typed words and
+//one compare no matter how many commands there are
+static constexpr uint32_t FNV_BASIS = 2166136261u;
+static constexpr uint32_t FNV_PRIME = 16777619u;
+static constexpr uint32_t SLOT_BITS = 9;
+static constexpr size_t SLOTS = 1 << SLOT_BITS;
+static constexpr size_t NCMDS = sizeof(commands) / sizeof(commands[0]);
+
+static constexpr uint32_t fnv(const char* s, uint32_t h)
+{
+    return *s ? fnv(s + 1, (h ^ (uint8_t)*s) * FNV_PRIME) : h;
+}
+static constexpr uint32_t key(const char* root, const char* sub, uint32_t seed)
+{
+    return sub ? fnv(sub, (fnv(root, seed) ^ ' ') * FNV_PRIME) : fnv(root, seed);
+}
+static constexpr size_t slot(size_t i, uint32_t seed)
+{
+    return key(commands[i].root, commands[i].sub, seed) >> (32 - SLOT_BITS);
+}
+static constexpr bool unique(size_t i, size_t j, uint32_t seed)
+{
+    return j >= NCMDS or (slot(i, seed) != slot(j, seed) and unique(i, j + 1, seed));
+}
+static constexpr bool perfect(size_t i, uint32_t seed)
+{
+    return i >= NCMDS or (unique(i, i + 1, seed) and perfect(i + 1, seed));
+}
+//first seed from FNV_BASIS with no collisions (0 = none in tries)
+static constexpr uint32_t find_seed(uint32_t seed, uint32_t tries)
+{
+    return not tries ? 0 : perfect(0, seed) ? seed : find_seed(seed + 1, tries - 1);
+}
+static constexpr uint32_t HASH_SEED = find_seed(FNV_BASIS, 256);
+static_assert(NCMDS < 256 and NCMDS <= SLOTS / 2, "too many commands, increase SLOT_BITS");
+static_assert(HASH_SEED, "no perfect hash seed found, increase SLOT_BITS");
+
+//slot -> command index + 1 (0 = empty), filled on first use
+struct Slots {
+    uint8_t idx[SLOTS]{};
+    Slots(){ for(size_t i = 0; i < NCMDS; i++) idx[slot(i, HASH_SEED)] = i + 1; }
 };
 
+//runtime version of fnv for a word that is not 0 terminated
+static uint32_t fnv(const char* s, size_t len, uint32_t h)
+{
+    for(; len; len--) h = (h ^ (uint8_t)*s++) * FNV_PRIME;
+    return h;
+}
+
+//str == the len chars at p
+static bool same(const char* str, const char* p, size_t len)
+{
+    return not strncmp(str, p, len) and not str[len];
+}
+
+//root, sub (sub NULL for root only) -> command or NULL
+static const cmd_t* lookup(const char* root, size_t rlen, const char* sub, size_t slen)
+{
+    static const Slots slots;
+    uint32_t h = fnv(root, rlen, HASH_SEED);
+    if(sub) h = fnv(sub, slen, (h ^ ' ') * FNV_PRIME);
+    size_t i = slots.idx[h >> (32 - SLOT_BITS)];
+    if(not i--) return NULL;
+    const cmd_t& c = commands[i];
+    if(not same(c.root, root, rlen)) return NULL;
+    if(sub ? not c.sub or not same(c.sub, sub, slen) : c.sub != NULL) return NULL;
+    return &c;
+}
+
+static bool is_space(char c){ return (uint8_t)c <= ' '; }
+
 //=============================================================================
 // common print functions
 //=============================================================================
-void help(WiFiClient& client)
+static void help(WiFiClient& client, const char*)
+{
+    Commander::help(client);
+}
+
+//help text ':' column (the longest root + usage fits)
+static const int HELP_COL = 40;
+
+void Commander::help(WiFiClient& client)
 {
     client.printf("\navailable commands:\n\n");
-    for(auto i = 0; commands[i].cmd != NULL; i++){
-        if(commands[i].help) client.printf("%s\n", commands[i].help);
+    for(auto& c : commands){
+        //root + usage padded to the ':' column, at least one space
+        if(not c.help) continue;
+        int w = HELP_COL - 1 - (int)strlen(c.root);
+        int min = (int)strlen(c.usage) + 1;
+        client.printf("%s %-*s:%s\n", c.root, w > min ? w : min, c.usage, c.help);
     }
     client.printf("\n");
 }
-void bad(WiFiClient& client){ client.printf("unknown command\n"); }
+static void bad(WiFiClient& client){ client.printf("unknown command\n"); }
 
 //=============================================================================
-// process incoming command passed from telnet function (already trimmed)
+// split command line into root, sub, args (in place) and look up
 //=============================================================================
-void Commander::process(WiFiClient& client, String s)
-{
-    //can 'logoff' with bye
-    if(s == "bye"){
-        telnet_info.stop_client();
-        return;
-    }
-    //check for root command
-    for(auto i = 0; commands[i].func || commands[i].cmd; i++){
-        if(commands[i].func) continue; //only looking for root command
-        if(not s.startsWith(commands[i].cmd)) continue; //no match
-        //root command found
-        s.replace(commands[i].cmd, ""); //remove command string
-        if(s[0] != ' '){ help(client); return;  } //no space after command
-        s.trim();
-        if(not s[0]){ help(client); return; } //unfinshed command
-        //check for sub command
-        for(i++; commands[i].func; i++){
-            if(not s.startsWith(commands[i].cmd)) continue;
-            //sub command found
-            s.replace(commands[i].cmd, "");
-            s.trim();
-            //run command
-            commands[i].func(client, s);
-            return;
-        }
-        //bad subcommand
-        help(client);
-    }
+//"uart2 baud=115200" -> root "uart2", sub "baud", arg "=115200"
+//only writes to the line to trim trailing whitespace, the words are
+//looked up where they are
+const cmd_t* Commander::find(char* line, const char*& arg)
+{
+    char* p = line;
+    while(*p and is_space(*p)) p++;
+    char* e = p + strlen(p);
+    while(e > p and is_space(e[-1])) *--e = 0;
+    const char* root = p;
+    while(not is_space(*p)) p++;
+    size_t rlen = p - root;
+    while(*p and is_space(*p)) p++;
+    arg = p;
+    const cmd_t* c = lookup(root, rlen, NULL, 0);
+    if(not c or c->func) return c;              //unknown, or root only command
+    //group, sub command ends at space or '='
+    const char* sub = p;
+    while(not is_space(*p) and *p != '=') p++;
+    if(p == sub) return c;
+    const cmd_t* s = lookup(root, rlen, sub, p - sub);
+    if(not s) return c;
+    while(*p and is_space(*p)) p++;
+    arg = p;
+    return s;
+}
+
+//=============================================================================
+// process incoming command passed from telnet function
+//=============================================================================
+void Commander::process(WiFiClient& client, char* line)
+{
+    for(const char* p = line; is_space(*p); p++) if(not *p) return; //blank
+    const char* arg;
+    const cmd_t* c = find(line, arg);
+    if(not c){ bad(client); return; }
+    if(not c->func){ help(client); return; }    //group without (valid) sub command
+    c->func(client, arg);
+}
 
-    bad(client);
+//=============================================================================
+// argument parsing
+//=============================================================================
+//gpio number up to the end char (',' or 0), -1 allowed when min is -1 ->
+//pin, -2 if not valid- digits only, flash pins 6-11 and gpios the esp32
+//does not have are not valid
+static int pin_arg(const char* s, char end, int min, int max)
+{
+    bool none = min < 0 and s[0] == '-' and s[1] == '1';
+    if(not none and not isdigit(s[0])) return -2;
+    char* e;
+    long n = strtol(s, &e, 10);
+    if(*e != end and *e) return -2;
+    if(n < min or n > max or (n >= 6 and n <= 11) or n == 20 or n == 24 or (n >= 28 and n <= 31)) return -2;
+    return n;
+}
+
+//number up to the end char (',' or 0), 0-max -> -1 if not valid
+static long num_arg(const char* s, char end, long max)
+{
+    if(not isdigit(s[0])) return -1;
+    char* e;
+    long n = strtol(s, &e, 10);
+    if(*e != end and *e) return -1;
+    return n <= max ? n : -1;
 }
 
 //=============================================================================
 // all command functions
 //=============================================================================
+//bye
+static void bye(WiFiClient& client, const char* s)
+{
+    if(s[0]){ help(client); return; }
+    telnet_info.stop_client();
+}
 //sys bootAP
-static void sys_bootAP(WiFiClient& client, String s)
+static void sys_bootAP(WiFiClient& client, const char* s)
 {
     NvsSettings settings;
     //no args
     if(not s[0]) client.printf("bootAP: %s\n", settings.boot_to_AP() ? "true" : "false");
-    else if(s.startsWith("=1")) settings.boot_to_AP(true);
-    else if(s.startsWith("=0")) settings.boot_to_AP(false);
+    else if(not strncmp(s, "=1", 2)) settings.boot_to_AP(true);
+    else if(not strncmp(s, "=0", 2)) settings.boot_to_AP(false);
     else help(client);
 }
 //sys reboot
-static void sys_reboot(WiFiClient& client, String s)
+static void sys_reboot(WiFiClient& client, const char* s)
 {
     if(s[0]){ bad(client); return; }
     client.printf("rebooting in 5 seconds...");
+    NvsSettings::flush();
     delay(5000);
     ESP.restart();
 }
 //sys erase
-static void sys_erase(WiFiClient& client, String s)
+static void sys_erase(WiFiClient& client, const char* s)
 {
     if(s[0]){ bad(client); return; }
     client.printf("erasing all stored data...");
@@ -139,8 +326,37 @@ static void sys_erase(WiFiClient& client, String s)
     settings.erase_all();
     client.printf("done.\n");
 }
+//sys save
+static void sys_save(WiFiClient& client, const char* s)
+{
+    if(s[0]){ bad(client); return; }
+    if(not NvsSettings::dirty()){ client.printf("no changes to save\n"); return; }
+    client.printf(NvsSettings::flush() ? "saved\n" : "save failed\n");
+}
+//sys log
+//(applied now)
+static void sys_log(WiFiClient& client, const char* s)
+{
+    static const char* const names[] = { "off", "serial", "telnet", "both" };
+    NvsSettings settings;
+    //no args
+    if(not s[0]){ client.printf("log: %s\n", names[settings.logout() & 3]); return; }
+    for(uint8_t i = 0; i < 4; i++){
+        if(s[0] != '=' or strcmp(s + 1, names[i])) continue;
+        settings.logout(i);
+        EventLog::outputs(i);
+        return;
+    }
+    help(client);
+}
+//sys timeline
+static void sys_timeline(WiFiClient& client, const char* s)
+{
+    if(s[0]){ bad(client); return; }
+    BootTime::print(client);
+}
 //wifi list
-static void wifi_list(WiFiClient& client, String s)
+static void wifi_list(WiFiClient& client, const char* s)
 {
     if(s[0]){ bad(client); return; }
     NvsSettings settings;
@@ -154,71 +370,113 @@ static void wifi_list(WiFiClient& client, String s)
         if(s > maxslen) maxslen = s;
         if(p > maxplen) maxplen = p;
     }
-    String fmt{"  #  %-" + String(maxslen) + "s  %-" + String(maxplen) + "s \n"};
-    client.printf(fmt.c_str(),"SSID","PASS");
-    fmt = " %2d  %-" + String(maxslen) + "s  %-" + String(maxplen) + "s \n";
-    for(auto i = maxslen + maxplen + 10; i; client.printf("-"), i--);
-    client.printf("\n");
+    client.printf("  #  %-*s  %-*s \n", maxslen, "SSID", maxplen, "PASS");
+    static const char rule[] = "--------------------------------------------------------------"
+        "--------------------------------------------------";  //ssid 31 + pass 63 + 10
+    client.printf("%.*s\n", maxslen + maxplen + 10, rule);
     for( auto i = 0; i < max; i++ ){
-        client.printf(fmt.c_str(),
-            i, settings.ssid(i).c_str(), settings.pass(i).c_str()
+        client.printf(" %2d  %-*s  %-*s \n",
+            i, maxslen, settings.ssid(i).c_str(), maxplen, settings.pass(i).c_str()
         );
     }
 }
 //wifi add
-static void wifi_add(WiFiClient& client, String s)
+static void wifi_add(WiFiClient& client, const char* s)
 {
-    //"0 ssid=myssid"
     NvsSettings settings;
     //"0 ssid=myssid"
     //"0 pass=mypass"
     int idx = 0;
-    if(s.substring(0,2) != "0 "){
-        idx = s.toInt();
+    if(strncmp(s, "0 ", 2)){
+        idx = atoi(s);
         if(idx == 0){
             client.printf("missing index# or index# not valid\n");
             return;
         }
     }
-    if(idx > settings.wifimaxn()){
-        client.printf("index# is out of range (max %s)\n", settings.wifimaxn());
+    if(idx >= settings.wifimaxn()){
+        client.printf("index# is out of range (max %d)\n", settings.wifimaxn() - 1);
         return;
     }
-    int si = s.indexOf("ssid=");
-    if(si > 0){
-        settings.ssid(idx, &s[si+5]);
+    const char* si = strstr(s, "ssid=");
+    if(si and si != s){
+        settings.ssid(idx, si + 5);
         return;
     }
-    si = s.indexOf("pass=");
-    if(si > 0){
-        settings.pass(idx, &s[si+5]);
+    si = strstr(s, "pass=");
+    if(si and si != s){
+        settings.pass(idx, si + 5);
         return;
     }
     //bad command
     help(client);
 }
 //wifi erase
-static void wifi_erase(WiFiClient& client, String s)
+static void wifi_erase(WiFiClient& client, const char* s)
 {
     //"wifi erase 0"
     int idx = 0;
-    if(s != "0"){
-        idx = s.toInt();
+    if(strcmp(s, "0")){
+        idx = atoi(s);
         if(idx == 0){
             client.printf("missing index# or index# not valid\n");
             return;
         }
     }
     NvsSettings settings;
-    if(idx > settings.wifimaxn()){
+    if(idx >= settings.wifimaxn()){
         client.printf("index# is out of range\n");
         return;
     }
     settings.ssid(idx, "");
     settings.pass(idx, "");
 }
+//wifi reboot
+//(applied now)
+static void wifi_reboot(WiFiClient& client, const char* s)
+{
+    NvsSettings settings;
+    //no arg
+    if(not s[0]){
+        uint16_t secs = settings.wifireboot();
+        client.printf("reboot: %u%s\n", secs, secs ? " seconds down" : " (never)");
+        return;
+    }
+    //"=300"
+    if(s[0] != '=' or not isdigit(s[1])){ help(client); return; }
+    int secs = atoi(s + 1);
+    if(secs > 65535){
+        client.printf("seconds not valid (max 65535)\n");
+        return;
+    }
+    settings.wifireboot(secs);
+}
+//wifi fast
+//(applied on the next connect)
+static void wifi_fast(WiFiClient& client, const char* s)
+{
+    static const char* const names[] = { "off", "bssid", "ip" };
+    NvsSettings settings;
+    //no args
+    if(not s[0]){
+        NvsSettings::wifilast_t w = settings.wifilast();
+        client.printf("fast: %s\n", names[settings.wififast() % 3]);
+        if(w.index >= settings.wifimaxn()){ client.printf("last: none\n"); return; }
+        const uint8_t* b = w.bssid;
+        client.printf("last: [%u] %s %02x:%02x:%02x:%02x:%02x:%02x channel %u ip %s\n",
+            w.index, settings.ssid(w.index).c_str(), b[0], b[1], b[2], b[3], b[4], b[5],
+            w.channel, IPAddress(w.ip).toString().c_str());
+        return;
+    }
+    for(uint8_t i = 0; i < 3; i++){
+        if(s[0] != '=' or strcmp(s + 1, names[i])) continue;
+        settings.wififast(i);
+        return;
+    }
+    help(client);
+}
 //net hostname
-static void net_hostname(WiFiClient& client, String s)
+static void net_hostname(WiFiClient& client, const char* s)
 {
     NvsSettings settings;
     //no arg
@@ -228,19 +486,18 @@ static void net_hostname(WiFiClient& client, String s)
     }
     //=myname
     if(s[0] == '='){
-        s = s.substring(1);
-        if(s.length() > 32){
+        if(strlen(s + 1) > 32){
             client.printf("hostname too long (32 chars max)\n");
             return;
         }
-        settings.hostname(s); //nvs storage
+        settings.hostname(s + 1); //nvs storage
         return;
     }
     //bad command
     help(client);
 }
 //net APname
-static void net_APname(WiFiClient& client, String s)
+static void net_APname(WiFiClient& client, const char* s)
 {
     NvsSettings settings;
     //no arg
@@ -250,19 +507,18 @@ static void net_APname(WiFiClient& client, String s)
     }
     //=myAPname
     if(s[0] == '='){
-        s = s.substring(1);
-        if(s.length() > 32){
+        if(strlen(s + 1) > 32){
             client.printf("APname too long (32 chars max)\n");
             return;
         }
-        settings.APname(s); //nvs storage
+        settings.APname(s + 1); //nvs storage
         return;
     }
     //bad command
     help(client);
 }
 //net mac
-static void net_mac(WiFiClient& client, String s)
+static void net_mac(WiFiClient& client, const char* s)
 {
     //no arg
     if(not s[0]){
@@ -274,38 +530,393 @@ static void net_mac(WiFiClient& client, String s)
 }
 
 //net servers
-static void net_servers(WiFiClient& client, String s)
+static void net_servers(WiFiClient& client, const char* s)
 {
     //no arg
     if(not s[0]){
         telnet_info.status(client);
-        telnet_uart2.status(client);
+        telnet_trace.status(client);
+        Bridges::status(client);
         return;
     }
     //bad command
     help(client);
 }
 
-//uart2 baud
-void uart2_baud(WiFiClient& client, String s)
+//stats show
+static void stats_show(WiFiClient& client, const char* s)
+{
+    if(s[0]){ bad(client); return; }
+    Bridges::stats(client);
+    Reactor::stats(client);
+    WifiLink::stats(client);
+}
+//stats reset
+static void stats_reset(WiFiClient& client, const char* s)
+{
+    if(s[0]){ bad(client); return; }
+    Bridges::stats_reset();
+    Reactor::stats_reset();
+    WifiLink::stats_reset();
+}
+
+//uart command for a bridge that is not running
+static TelnetServer* bridge(WiFiClient& client, uint8_t n)
+{
+    TelnetServer* t = Bridges::get(n);
+    if(not t) client.printf("uart%u not enabled\n", n);
+    return t;
+}
+
+//uartN enable
+//(applied now- the bridge is started or stopped)
+template<uint8_t N> static void uart_enable(WiFiClient& client, const char* s)
+{
+    NvsSettings settings;
+    //no args
+    if(not s[0]){
+        client.printf("uart%u enable: %s\n", N, settings.uartenable(N) ? "true" : "false");
+        return;
+    }
+    if(strcmp(s, "=1") and strcmp(s, "=0")){ help(client); return; }
+    settings.uartenable(N, s[1] == '1');
+    Bridges::apply(N);
+}
+
+//uartN port
+//(applied now- the bridge is restarted)
+template<uint8_t N> static void uart_port(WiFiClient& client, const char* s)
+{
+    NvsSettings settings;
+    //no arg
+    if(not s[0]){
+        client.printf("uart%u port: %u\n", N, settings.uartport(N));
+        return;
+    }
+    //"=2302"
+    if(s[0] != '='){ help(client); return; }
+    int port = atoi(s + 1);
+    //the other servers (their port whether running or not), other bridges
+    bool used = port == telnet_info.port() or port == telnet_trace.port() or
+                port == telnet_log.port() or port == web_server.port();
+    for(uint8_t n = 0; n < settings.uartmaxn(); n++){
+        if(n != N and settings.uartenable(n) and settings.uartport(n) == port) used = true;
+    }
+    if(port <= 0 or port > 65535 or used){
+        client.printf("port not valid or in use\n");
+        return;
+    }
+    settings.uartport(N, port);
+    Bridges::apply(N);
+}
+
+//uartN pins
+template<uint8_t N> static void uart_pins(WiFiClient& client, const char* s)
+{
+    NvsSettings settings;
+    //no arg
+    if(not s[0]){
+        client.printf("uart%u pins: rx %d, tx %d (-1=default)\n",
+            N, settings.uartrxpin(N), settings.uarttxpin(N)
+        );
+        return;
+    }
+    //"=16,17"
+    const char* c1 = strchr(s, ',');
+    if(s[0] != '=' or not c1){ help(client); return; }
+    int rx = pin_arg(s + 1, ',', -1, 39);
+    int tx = pin_arg(c1 + 1, 0, -1, 33);
+    if(rx < -1 or tx < -1){
+        client.printf("pin not valid (rx gpio -1-39, tx gpio -1-33, not 6-11)\n");
+        return;
+    }
+    settings.uartpins(N, rx, tx);
+}
+
+//uartN baud
+template<uint8_t N> static void uart_baud(WiFiClient& client, const char* s)
 {
     NvsSettings settings;
     //no arg
     if(not s[0]){
-        client.printf("uart2 baud: %d\n", settings.uart2baud());
+        client.printf("uart%u baud: %d\n", N, settings.uartbaud(N));
         return;
     }
     //"=115200"
     if(s[0] == '='){
-        s = s.substring(1);
-        int baud = s.toInt();
+        int baud = atoi(s + 1);
         if(baud == 0){
             client.printf("baud value not valid\n");
             return;
         }
-        settings.uart2baud(baud);
+        settings.uartbaud(N, baud);
         return;
     }
     //bad command
     help(client);
 }
+
+//uartN framing
+//SERIAL_xxx config- bits 0-1 parity (0=N, 2=E, 3=O), bits 2-3 data bits - 5,
+//bits 4-5 stop bits (1=1, 3=2)
+template<uint8_t N> static void uart_framing(WiFiClient& client, const char* s)
+{
+    NvsSettings settings;
+    //no arg
+    if(not s[0]){
+        uint32_t cfg = settings.uartconfig(N);
+        client.printf("uart%u framing: %u%c%u\n", N,
+            (unsigned)((cfg >> 2 & 3) + 5), "NNEO"[cfg & 3], (cfg >> 4 & 3) == 3 ? 2 : 1
+        );
+        return;
+    }
+    //"=8N1"
+    const char* par = strchr("NEO", s[2]);
+    if(s[0] != '=' or s[1] < '5' or s[1] > '8' or not s[2] or not par
+        or (s[3] != '1' and s[3] != '2') or s[4]){
+        help(client);
+        return;
+    }
+    static const uint8_t parity[] = { 0, 2, 3 };
+    settings.uartconfig(N, 0x8000000 | parity[par - "NEO"] | (s[1] - '5') << 2
+        | (s[3] == '2' ? 3 : 1) << 4);
+}
+
+//uartN invert
+template<uint8_t N> static void uart_invert(WiFiClient& client, const char* s)
+{
+    NvsSettings settings;
+    //no args
+    if(not s[0]) client.printf("uart%u invert: %s\n", N, settings.uartinvert(N) ? "true" : "false");
+    else if(not strncmp(s, "=1", 2)) settings.uartinvert(N, true);
+    else if(not strncmp(s, "=0", 2)) settings.uartinvert(N, false);
+    else help(client);
+}
+
+//uartN telnet
+template<uint8_t N> static void uart_telnet(WiFiClient& client, const char* s)
+{
+    NvsSettings settings;
+    //no args
+    if(not s[0]) client.printf("uart%u telnet: %s\n", N, settings.uarttelnet(N) ? "true" : "false");
+    else if(not strncmp(s, "=1", 2)) settings.uarttelnet(N, true);
+    else if(not strncmp(s, "=0", 2)) settings.uarttelnet(N, false);
+    else help(client);
+}
+
+//uartN compress
+template<uint8_t N> static void uart_compress(WiFiClient& client, const char* s)
+{
+    NvsSettings settings;
+    //no args
+    if(not s[0]) client.printf("uart%u compress: %s\n", N, settings.uartcompress(N) ? "true" : "false");
+    else if(not strncmp(s, "=1", 2)) settings.uartcompress(N, true);
+    else if(not strncmp(s, "=0", 2)) settings.uartcompress(N, false);
+    else help(client);
+}
+
+//uartN drop
+template<uint8_t N> static void uart_drop(WiFiClient& client, const char* s)
+{
+    NvsSettings settings;
+    //no args
+    if(not s[0]) client.printf("uart%u drop: %s\n", N, settings.uartdrop(N) ? "close" : "skip");
+    else if(not strcmp(s, "=skip")) settings.uartdrop(N, false);
+    else if(not strcmp(s, "=close")) settings.uartdrop(N, true);
+    else help(client);
+}
+
+//uartN coalesce
+template<uint8_t N> static void uart_coalesce(WiFiClient& client, const char* s)
+{
+    NvsSettings settings;
+    //no args
+    if(not s[0]){
+        client.printf("uart%u coalesce: size %u, gap %uus, hold %uus (0=auto)\n",
+            N, settings.uartco_size(N), settings.uartco_gap(N), settings.uartco_hold(N)
+        );
+        return;
+    }
+    //"=1436,250,5000"
+    const char* c1 = strchr(s, ',');
+    const char* c2 = c1 ? strchr(c1 + 1, ',') : NULL;
+    if(s[0] != '=' or not c2){ help(client); return; }
+    static const long CO_SIZE_MAX = TelnetServer::UART_RX_RING / 2;
+    static const long CO_US_MAX = 1000000;
+    long size = num_arg(s + 1, ',', CO_SIZE_MAX);
+    long gap = num_arg(c1 + 1, ',', CO_US_MAX);
+    long hold = num_arg(c2 + 1, 0, CO_US_MAX);
+    if(size < 0 or gap < 0 or hold < 0){
+        client.printf("coalesce not valid (size 0-%ld, gap/hold 0-%ld us, 0=auto)\n", CO_SIZE_MAX, CO_US_MAX);
+        return;
+    }
+    settings.uartcoalesce(N, size, gap, hold);
+}
+
+//uartN backlog
+//(a new size is applied once no clients of the bridge are connected)
+template<uint8_t N> static void uart_backlog(WiFiClient& client, const char* s)
+{
+    NvsSettings settings;
+    //no args
+    if(not s[0]){
+        client.printf("uart%u backlog: %u bytes, when full %s, replay %s\n",
+            N, (unsigned)settings.uartbl_size(N),
+            settings.uartbl_wrap(N) ? "wrap" : "stop",
+            settings.uartbl_auto(N) ? "auto" : "req"
+        );
+        return;
+    }
+    //"=8192,wrap,auto"
+    const char* c1 = strchr(s, ',');
+    const char* c2 = c1 ? strchr(c1 + 1, ',') : NULL;
+    if(s[0] != '=' or not c2){ help(client); return; }
+    bool wrap = not strncmp(c1 + 1, "wrap,", 5);
+    bool stop = not strncmp(c1 + 1, "stop,", 5);
+    bool autor = not strcmp(c2 + 1, "auto");
+    bool req = not strcmp(c2 + 1, "req");
+    if(not (wrap or stop) or not (autor or req)){ help(client); return; }
+    uint32_t size = atoi(s + 1);
+    if(size > 1024 * 1024){
+        client.printf("backlog size too large (max 1048576)\n");
+        return;
+    }
+    settings.uartbacklog(N, size, wrap, autor);
+    if(TelnetServer* t = Bridges::get(N)) t->backlog(size, wrap, autor);
+}
+
+//uartN replay
+template<uint8_t N> static void uart_replay(WiFiClient& client, const char* s)
+{
+    if(s[0]){ bad(client); return; }
+    if(TelnetServer* t = bridge(client, N)) t->replay();
+}
+
+//uartN capture
+template<uint8_t N> static void uart_capture(WiFiClient& client, const char* s)
+{
+    TelnetServer* t = bridge(client, N);
+    if(not t) return;
+    //no args
+    if(not s[0]){
+        Capture& cap = t->capture();
+        size_t len;
+        cap.data(len);
+        client.printf("uart%u capture: %s, %u records, %u/%u bytes\n", N,
+            cap.on() ? "on" : cap.full() ? "off (full)" : "off",
+            (unsigned)cap.records(), (unsigned)len, (unsigned)cap.size()
+        );
+        return;
+    }
+    if(not strcmp(s, "=stop")){ t->capture_stop(); return; }
+    //"=start" or "=start,64"
+    size_t kb = 32;
+    if(not strncmp(s, "=start,", 7)) kb = atoi(s + 7);
+    else if(strcmp(s, "=start")){ help(client); return; }
+    if(kb == 0 or kb > 4096){
+        client.printf("capture size not valid (1-4096 KB)\n");
+        return;
+    }
+    if(t->capture().held()){
+        client.printf("capture is being downloaded, start it when done\n");
+        return;
+    }
+    if(not t->capture_start(kb * 1024)){
+        client.printf("no memory for %u KB capture\n", (unsigned)kb);
+    }
+}
+
+//uartN driver
+//(reopens the uart if running, rings cleared)
+template<uint8_t N> static void uart_driver(WiFiClient& client, const char* s)
+{
+    NvsSettings settings;
+    //no args
+    if(not s[0]){
+        client.printf("uart%u driver: rx ring %u bytes, fifo full %u bytes, idle %u chars\n",
+            N, settings.uartrx_ring(N), settings.uartrx_full(N), settings.uartrx_idle(N)
+        );
+        return;
+    }
+    //"=512,112,2"
+    const char* c1 = strchr(s, ',');
+    const char* c2 = c1 ? strchr(c1 + 1, ',') : NULL;
+    if(s[0] != '=' or not c2){ help(client); return; }
+    int ring = atoi(s + 1), full = atoi(c1 + 1), idle = atoi(c2 + 1);
+    if(ring <= UartPort::FIFO or ring > 16384 or full < 1 or full >= UartPort::FIFO or
+       idle < 1 or idle > 126){
+        client.printf("driver values not valid (ring %u-16384, full 1-%u, idle 1-126)\n",
+            UartPort::FIFO + 1, UartPort::FIFO - 1);
+        return;
+    }
+    settings.uartdriver(N, ring, full, idle);
+    if(TelnetServer* t = Bridges::get(N)) t->uart_init();
+}
+
+//uartN packet
+//(applied now, readers look for a frame from where they are)
+template<uint8_t N> static void uart_packet(WiFiClient& client, const char* s)
+{
+    NvsSettings settings;
+    //no args
+    if(not s[0]){
+        client.printf("uart%u packet: %s,%u\n", N,
+            Framer::name((Framer::mode_t)settings.uartpacket(N)), settings.uartpacket_arg(N)
+        );
+        return;
+    }
+    //"=line", "=delim,0d", "=length,2", "=idle,4"
+    if(s[0] != '='){ help(client); return; }
+    const char* c1 = strchr(s, ',');
+    size_t len = c1 ? c1 - s - 1 : strlen(s + 1);
+    Framer::mode_t m = Framer::NONE;
+    for(; m <= Framer::IDLE; m = (Framer::mode_t)(m + 1)){
+        if(strlen(Framer::name(m)) == len and not strncmp(s + 1, Framer::name(m), len)) break;
+    }
+    long arg = c1 ? strtol(c1 + 1, NULL, m == Framer::DELIM ? 16 : 10) : 0;
+    bool ok = m <= Framer::IDLE and (m == Framer::NONE or m == Framer::LINE ? not c1 :
+        m == Framer::DELIM ? c1 and arg >= 0 and arg <= 255 :
+        m == Framer::LENGTH ? arg == 1 or arg == 2 : arg >= 1 and arg <= 255);
+    if(not ok){
+        client.printf("packet not valid (none, line, delim,hex byte, length,1-2, idle,1-255)\n");
+        return;
+    }
+    settings.uartpacket(N, m, arg);
+    if(TelnetServer* t = Bridges::get(N)) t->packet(m, arg);
+}
+
+//uartN flow
+//(reopens the uart if running, rings cleared)
+template<uint8_t N> static void uart_flow(WiFiClient& client, const char* s)
+{
+    NvsSettings settings;
+    static const char* const names[] = { "none", "rts", "xoff" };
+    //no args
+    if(not s[0]){
+        uint8_t f = settings.uartflow(N);
+        client.printf("uart%u flow: %s", N, names[f <= UartPort::FLOW_XOFF ? f : 0]);
+        if(f == UartPort::FLOW_RTS){
+            client.printf(", rts %d, cts %d (-1=none)", settings.uartrtspin(N), settings.uartctspin(N));
+        }
+        client.printf("\n");
+        return;
+    }
+    //"=none", "=xoff", "=rts,18" or "=rts,18,19"
+    int rts = -1, cts = -1;
+    UartPort::flow_t f;
+    if(not strcmp(s, "=none")) f = UartPort::FLOW_NONE;
+    else if(not strcmp(s, "=xoff")) f = UartPort::FLOW_XOFF;
+    else if(not strncmp(s, "=rts,", 5)){
+        f = UartPort::FLOW_RTS;
+        const char* c2 = strchr(s + 5, ',');
+        rts = pin_arg(s + 5, ',', 0, 33);
+        if(c2) cts = pin_arg(c2 + 1, 0, 0, 39);
+        if(rts < 0 or (c2 and cts < 0)){
+            client.printf("pin not valid (rts gpio 0-33, cts gpio 0-39, not 6-11)\n");
+            return;
+        }
+    }
+    else { help(client); return; }
+    settings.uartflow(N, f, rts, cts);
+    if(TelnetServer* t = Bridges::get(N)) t->uart_init();
+}
@@ -4,8 +4,31 @@
 
 struct Commander {
 
+    //command handler-
     //WiFiClient&   - so can print to
-    //String        - command line string (already trimmed)
-    static void process(WiFiClient&, String);
+    //const char*   - args after the command name, trimmed ("" if none),
+    //                points into the line passed to process
+    using func_t = void(*)(WiFiClient&, const char*);
+
+    //command table entry- root only (help, bye), root with a NULL func
+    //is a group, sub commands follow their group
+    using cmd_t = struct {
+        const char* root;
+        const char* sub;
+        func_t      func;
+        const char* usage;          //shown after the name in help
+        const char* help;           //NULL = not shown
+    };
+
+    //char*         - command line, split into tokens in place (no copies)
+    static void process(WiFiClient&, char*);
+
+    //print the help list (generated from the command table)
+    static void help(WiFiClient&);
+
+    //tokenize and look up only-
+    //-> command, group if sub command missing/unknown, NULL if unknown
+    //arg   - set to the args after the command
+    static const cmd_t* find(char*, const char*& arg);
 
 };
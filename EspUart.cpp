@@ -0,0 +1,164 @@
+#include "EspUart.hpp"
+#include "EventLog.hpp"
+#include <Arduino.h>
+#include <driver/uart.h>
+
+//=====================
+// local functions
+//=====================
+
+static EspUart ports[3] = { {0}, {1}, {2} };
+
+//default pins as HardwareSerial::begin (uart1 has none- the flash pins)
+static const int8_t rx_default[3] = { 3, -1, 16 };
+static const int8_t tx_default[3] = { 1, -1, 17 };
+
+//created with the first begin, then kept- every port's event queue is
+//added while begun, the kick semaphore always
+static std::atomic<QueueSetHandle_t> s_set{nullptr};
+static SemaphoreHandle_t s_kick;
+
+static bool set_init()
+{
+    if(s_set) return true;
+    s_kick = xSemaphoreCreateBinary();
+    QueueSetHandle_t set = xQueueCreateSet(3 * EspUart::EVENTS + 1);
+    if(not s_kick or not set) return false;
+    xQueueAddToSet(s_kick, set);
+    s_set = set;
+    return true;
+}
+
+//=====================
+// UartPort
+//=====================
+
+UartPort& UartPort::get(uint8_t n){ return ports[n < 3 ? n : 0]; }
+
+//the set is emptied (the kick taken if in it), driver events are left in
+//their queues for available() (task, port in use)- so a port being ended
+//is never touched here, a set entry for an ended port is just a wake
+void UartPort::wait(uint32_t ms)
+{
+    TickType_t ticks = pdMS_TO_TICKS(ms) ? pdMS_TO_TICKS(ms) : 1;
+    QueueSetHandle_t set = s_set;
+    if(not set){ vTaskDelay(ticks); return; }
+    for(QueueSetMemberHandle_t m = xQueueSelectFromSet(set, ticks); m; m = xQueueSelectFromSet(set, 0)){
+        if(m == s_kick) xSemaphoreTake(s_kick, 0);
+    }
+}
+
+void UartPort::kick()
+{
+    if(s_set) xSemaphoreGive(s_kick);
+}
+
+//=====================
+// class functions
+//=====================
+
+EspUart::EspUart(uint8_t nr) : m_nr(nr)
+{
+}
+
+//the event queue is added to the set before the pins are connected, so
+//it is still empty (a queue with events cannot be added)
+bool EspUart::begin(uint32_t baud, uint32_t cfg, int8_t rxpin, int8_t txpin, bool invert,
+    const opts_t& o)
+{
+    end();
+    if(not set_init()) return false;
+    if(m_nr == 0){ EventLog::serial(false); Serial.end(); }
+    uart_port_t n = (uart_port_t)m_nr;
+    uart_config_t c = {};
+    c.baud_rate = baud;
+    c.data_bits = (uart_word_length_t)((cfg >> 2) & 3);   //SERIAL_xxx bits match
+    c.parity = (uart_parity_t)(cfg & 3);
+    c.stop_bits = (uart_stop_bits_t)((cfg >> 4) & 3);
+    c.flow_ctrl = o.flow != FLOW_RTS ? UART_HW_FLOWCTRL_DISABLE :
+        o.cts < 0 ? UART_HW_FLOWCTRL_RTS : UART_HW_FLOWCTRL_CTS_RTS;
+    c.rx_flow_ctrl_thresh = FLOW_THRESH;
+    uart_param_config(n, &c);
+    uint16_t ring = o.rx_ring > FIFO ? o.rx_ring : FIFO + 1;  //driver needs > fifo
+    QueueHandle_t q;
+    if(uart_driver_install(n, ring, 0, EVENTS, &q, 0) != ESP_OK){
+        if(m_nr == 0){ Serial.begin(115200); EventLog::serial(true); }
+        return false;
+    }
+    xQueueAddToSet(q, s_set);
+    m_events = q;
+    m_rts = o.flow == FLOW_RTS;
+    bool rts = o.flow == FLOW_RTS and o.rts >= 0;
+    bool cts = o.flow == FLOW_RTS and o.cts >= 0;
+    uart_set_pin(n, txpin < 0 ? tx_default[m_nr] : txpin, rxpin < 0 ? rx_default[m_nr] : rxpin,
+        rts ? o.rts : UART_PIN_NO_CHANGE, cts ? o.cts : UART_PIN_NO_CHANGE);
+    uart_set_line_inverse(n, invert ? UART_INVERSE_RXD | UART_INVERSE_TXD : 0);
+    uart_intr_config_t ic = {};
+    ic.intr_enable_mask = UART_RXFIFO_FULL_INT_ENA_M | UART_RXFIFO_TOUT_INT_ENA_M |
+        UART_RXFIFO_OVF_INT_ENA_M | UART_FRM_ERR_INT_ENA_M | UART_PARITY_ERR_INT_ENA_M;
+    ic.rxfifo_full_thresh = o.rx_full ? (o.rx_full < FIFO ? o.rx_full : FIFO - 1) : 1;
+    ic.rx_timeout_thresh = o.rx_idle ? (o.rx_idle < 127 ? o.rx_idle : 126) : 1;
+    uart_intr_config(n, &ic);
+    return true;
+}
+
+//events still queued are taken first (a member with events cannot be
+//removed)- set entries left for them are ignored by wait
+void EspUart::end()
+{
+    QueueHandle_t q = m_events;
+    if(not q) return;
+    m_events = nullptr;
+    uart_disable_rx_intr((uart_port_t)m_nr);
+    uart_event_t e;
+    while(xQueueReceive(q, &e, 0) == pdTRUE);
+    xQueueRemoveFromSet(q, s_set);
+    uart_driver_delete((uart_port_t)m_nr);
+    if(m_nr == 0){ Serial.begin(115200); EventLog::serial(true); }
+}
+
+void EspUart::baud(uint32_t v)
+{
+    uart_set_baudrate((uart_port_t)m_nr, v);
+}
+
+//task- data events only say there is data (read by available/read),
+//fifo overflow and full driver ring events are counted- with FLOW_RTS a
+//full ring is the hold itself (the isr stops taking rx, the fifo fills and
+//rts goes off), so only fifo overflows count then
+void EspUart::events()
+{
+    QueueHandle_t q = m_events;
+    if(not q) return;
+    uart_event_t e;
+    while(xQueueReceive(q, &e, 0) == pdTRUE){
+        if(e.type == UART_FIFO_OVF or (e.type == UART_BUFFER_FULL and not m_rts)) m_overruns++;
+    }
+}
+
+size_t EspUart::available()
+{
+    size_t n = 0;
+    events();
+    if(m_events) uart_get_buffered_data_len((uart_port_t)m_nr, &n);
+    return n;
+}
+
+size_t EspUart::read(uint8_t* p, size_t n)
+{
+    int r = m_events ? uart_read_bytes((uart_port_t)m_nr, p, n, 0) : 0;
+    return r > 0 ? r : 0;
+}
+
+size_t EspUart::write(const uint8_t* p, size_t n)
+{
+    int r = m_events ? uart_tx_chars((uart_port_t)m_nr, (const char*)p, n) : 0;
+    return r > 0 ? r : 0;
+}
+
+bool EspUart::tx_done()
+{
+    return not m_events or uart_wait_tx_done((uart_port_t)m_nr, 0) == ESP_OK;
+}
+
+uint32_t EspUart::overruns(){ return m_overruns; }
@@ -0,0 +1,55 @@
+#pragma once
+
+#include "UartPort.hpp"
+#include <atomic>
+#include <freertos/FreeRTOS.h>
+#include <freertos/queue.h>
+#include <freertos/semphr.h>
+
+//UartPort on the esp-idf uart driver (esp32 build)
+//
+//the driver isr empties the rx fifo into the driver rx ring when the fifo
+//holds rx_full bytes or the line has been idle rx_idle char times, and
+//posts an event- every port's event queue and a kick semaphore are in one
+//queue set, so the bridge task sleeps until there is rx data, tx data to
+//send, or its timeout (the events themselves are taken by available())
+//
+//tx goes straight into the tx fifo (uart_tx_chars, no driver tx ring), so
+//a write never waits- what does not fit stays in the bridge tx ring
+//
+//FLOW_RTS is the uart's hardware flow control (rts off at FLOW_THRESH fifo
+//bytes, tx paused while cts is off), FLOW_XOFF needs nothing here
+//
+//uart0 is also the debug console (Serial)- Serial is ended while the
+//uart0 bridge runs and begun again (115200) when it stops, the event log
+//task is off uart0 for that time (EventLog::serial)
+//
+//the esp-idf 3.x isr reads rxfifo_cnt, the count the esp32-hal isr patch
+//in modified_arduino_sources.txt stops using- a misread leaves bytes in the
+//fifo until the next rx interrupt (not lost)
+
+struct EspUart : UartPort {
+
+    EspUart             (uint8_t);
+
+    bool        begin       (uint32_t, uint32_t, int8_t, int8_t, bool, const opts_t&) override;
+    void        end         () override;
+    void        baud        (uint32_t) override;
+    size_t      available   () override;
+    size_t      read        (uint8_t*, size_t) override;
+    size_t      write       (const uint8_t*, size_t) override;
+    bool        tx_done     () override;
+    uint32_t    overruns    () override;
+
+    static const uint8_t EVENTS = 16;       //driver event queue length
+
+    private:
+
+    void        events      ();             //take queued driver events
+
+    uint8_t             m_nr;
+    QueueHandle_t       m_events{nullptr};  //driver event queue, in the set
+    bool                m_rts{false};       //FLOW_RTS- a full ring is not an overrun
+    std::atomic<uint32_t> m_overruns{0};
+
+};
@@ -0,0 +1,120 @@
+#include "EventLog.hpp"
+#include <WiFi.h>
+
+//=====================
+// local functions
+//=====================
+
+//ip (network order) as text, "" for 0
+static const char* ipstr(char* s, uint32_t ip)
+{
+    s[0] = 0;
+    if(ip) sprintf(s, "%u.%u.%u.%u", ip & 0xFF, ip >> 8 & 0xFF, ip >> 16 & 0xFF, ip >> 24);
+    return s;
+}
+
+//=====================
+// class functions
+//=====================
+
+SeqRing<EventLog::rec_t, EventLog::RING> EventLog::s_ring;
+std::atomic<uint8_t> EventLog::s_outputs{SERIAL_OUT | TELNET_OUT};
+std::atomic<bool> EventLog::s_serial{true};
+std::atomic<bool> EventLog::s_writing{false};
+
+const char* EventLog::name(event_t ev)
+{
+    static const char* const names[] = {
+        "starting", "stopping", "new client", "new websocket", "websocket", "closed", "rejected",
+        "failed", "idle", "stalled", "uart busy", "reader too slow", "uart driver not started",
+        "no memory for backlog", "no memory for lz", "command", "connected", "connection lost",
+        "rebooting, down too long",
+    };
+    static_assert(sizeof(names) / sizeof(names[0]) == EVENTS, "event names");
+    return ev < EVENTS ? names[ev] : "?";
+}
+
+void EventLog::outputs(uint8_t v){ s_outputs = v; }
+uint8_t EventLog::outputs(){ return s_outputs; }
+
+//the uart0 bridge (EspUart) ends Serial and begins it again- the task either
+//sees uart0 taken before it touches Serial, or is seen writing and waited for
+void EventLog::serial(bool on)
+{
+    s_serial = on;
+    while(not on and s_writing) vTaskDelay(1);
+}
+
+void EventLog::reset(reader_t& r){ s_ring.reset(r); }
+
+//records in ring order, a line each, a lost line before the record that
+//follows records lost
+size_t EventLog::format(reader_t& r, char* buf, size_t len)
+{
+    static const char* const srcs[] = { "Telnet Server", "Web Server   ", "WiFi Link    " };
+    char line[LINE];
+    char sip[16], cip[16];
+    size_t n = 0;
+    for(;;){
+        int k;
+        if(r.lost_sent != r.lost){
+            k = snprintf(line, sizeof(line), "event log | %u events lost\n",
+                (unsigned)(r.lost - r.lost_sent));
+            if(n + k > len) return n;
+            memcpy(&buf[n], line, k);
+            n += k;
+            r.lost_sent = r.lost;
+            continue;
+        }
+        rec_t e;
+        if(not s_ring.read(r, e)) return n;
+        if(r.lost_sent != r.lost) continue;     //lapped, lost line first
+        e.text[TEXT - 1] = 0;
+        k = snprintf(line, sizeof(line), "%5u.%03u %s | %5s | s%15s | p%5u | c%15s | %s%s%s\n",
+            (unsigned)(e.ms / 1000), (unsigned)(e.ms % 1000), srcs[e.src <= WIFI ? e.src : 0],
+            e.name ? e.name : "", ipstr(sip, (uint32_t)WiFi.localIP()), e.port, ipstr(cip, e.ip),
+            name((event_t)e.event), e.text[0] ? " " : "", e.text
+        );
+        if(k >= (int)sizeof(line)) k = sizeof(line) - 1;
+        if(n + k > len) return n;
+        memcpy(&buf[n], line, k);
+        n += k;
+        s_ring.next(r);
+    }
+}
+
+void EventLog::start(uint8_t v)
+{
+    static TaskHandle_t t;
+    outputs(v);
+    if(not t) xTaskCreatePinnedToCore(task, "log", TASK_STACK, nullptr, TASK_PRIO, &t, TASK_CORE);
+}
+
+//uart0 reader- a buffer of lines is written as the tx fifo takes it, when
+//uart0 is off, or a bridge has it, the records are still read (so turning
+//it on shows new events)
+void EventLog::task(void*)
+{
+    static char buf[256];
+    size_t pos = 0, len = 0;
+    reader_t r;
+    reset(r);
+    for(;;){
+        if(pos == len){
+            pos = 0;
+            len = format(r, buf, sizeof(buf));
+            if(not (outputs() & SERIAL_OUT)) len = 0;
+        }
+        size_t w = 0;
+        s_writing = true;                       //serial() waits for this
+        if(not s_serial) pos = len;             //a bridge has uart0, lines dropped
+        int room = pos < len ? Serial.availableForWrite() : 0;
+        if(room > 0){
+            size_t k = len - pos < (size_t)room ? len - pos : room;
+            w = Serial.write((const uint8_t*)&buf[pos], k);
+            pos += w;
+        }
+        s_writing = false;
+        if(not w) vTaskDelay(TASK_MS / portTICK_PERIOD_MS);
+    }
+}
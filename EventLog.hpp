@@ -0,0 +1,97 @@
+#pragma once
+
+#include <Arduino.h>
+#include <atomic>
+#include "SeqRing.hpp"
+
+//server event log (start, connect, close, reject..., wifi link up/lost)
+//
+//  EventLog::put(EventLog::NEW_CLIENT, EventLog::TELNET, m_name, m_port, ip);
+//
+//an event stores one fixed size record- time, event, source, server name,
+//port, remote ip (and for a command its first chars)- in a lock-free ring
+//(SeqRing), no formatting, no Strings and no locks, from any task
+//
+//records are formatted to text by readers, each with its own place in the
+//ring- the log task writes to uart0 only what the tx fifo has room for (so
+//it never waits on the uart), the telnet log port (2304) sends to its client
+//from the oldest record kept- which of the two is on is set by sys log
+//
+//the ring is a flight recorder- a reader that falls behind loses the oldest
+//records, a line says how many
+//
+//   12.345 Telnet Server | uart2 | s192.168.123.100 | p 2302 | c192.168.123.101 | new client
+//
+//(the server address is the one at the time the record is formatted)
+
+struct EventLog {
+
+    using event_t = enum : uint8_t {
+        STARTING, STOPPING, NEW_CLIENT, NEW_WEBSOCKET, WEBSOCKET, CLOSED, REJECTED,
+        FAILED, IDLE, STALLED, UART_BUSY, SLOW_READER, NO_UART, NO_BACKLOG, NO_LZ,
+        COMMAND, LINK_UP, LINK_LOST, LINK_REBOOT, EVENTS
+    };
+    using src_t = enum : uint8_t { TELNET, WEB, WIFI };
+
+    //outputs (bits)
+    enum : uint8_t { SERIAL_OUT = 1, TELNET_OUT = 2 };
+
+    static const uint32_t   RING        = 64;   //records (power of 2)
+    static const size_t     TEXT        = 16;   //command chars kept (with the 0)
+    static const size_t     LINE        = 128;  //formatted line max
+
+    //event, source, server name (not copied), port, remote ip, command
+    static void put         (event_t ev, src_t src, const char* name, uint16_t port,
+                             uint32_t ip = 0, const char* text = nullptr)
+    {
+        s_ring.put([&](rec_t& r){
+            r.ms = millis();
+            r.name = name;
+            r.ip = ip;
+            r.port = port;
+            r.event = ev;
+            r.src = src;
+            size_t i = 0;
+            if(text) for(; i < TEXT - 1 and text[i]; i++) r.text[i] = text[i];
+            r.text[i] = 0;
+        });
+    }
+
+    using reader_t = seq_reader_t;              //a reader's place in the ring
+
+    static void reset       (reader_t&);        //start at the oldest record kept
+    static size_t format    (reader_t&, char*, size_t); //whole lines that fit -> chars
+
+    static void start       (uint8_t);          //outputs, log task (uart0) started
+    static void outputs     (uint8_t);          //set outputs
+    static uint8_t outputs  ();
+    static void serial      (bool);             //uart0 back (true), or taken by a bridge- a
+                                                //write in progress is waited out
+
+    static const char* name (event_t);
+
+    private:
+
+    using rec_t = struct {
+        uint32_t                ms;
+        const char*             name;
+        uint32_t                ip;
+        uint16_t                port;
+        uint8_t                 event;
+        uint8_t                 src;
+        char                    text[TEXT];
+    };
+
+    static void task        (void*);
+
+    static const uint32_t   TASK_STACK  = 2560;
+    static const uint8_t    TASK_CORE   = 0;    //protocol core, below wifi/lwip
+    static const uint8_t    TASK_PRIO   = 1;
+    static const uint32_t   TASK_MS     = 10;   //sleep when idle or fifo full
+
+    static SeqRing<rec_t, RING>     s_ring;
+    static std::atomic<uint8_t>     s_outputs;
+    static std::atomic<bool>        s_serial;   //uart0 is the log's (Serial begun)
+    static std::atomic<bool>        s_writing;  //log task is using Serial
+
+};
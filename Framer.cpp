@@ -0,0 +1,83 @@
+#include "Framer.hpp"
+#include <string.h>
+
+//=====================
+// class functions
+//=====================
+
+void Framer::set(mode_t m, uint8_t a)
+{
+    m_mode = m;
+    m_arg = a;
+    if(m == LENGTH and (a < 1 or a > 2)) m_arg = 2;
+}
+
+Framer::mode_t Framer::mode(){ return m_mode; }
+uint8_t Framer::arg(){ return m_arg; }
+
+const char* Framer::name(mode_t m)
+{
+    static const char* const names[] = { "none", "line", "delim", "length", "idle" };
+    return m <= IDLE ? names[m] : "?";
+}
+
+//a word xor'd with the byte repeated has a zero byte where there is a
+//match- (w - 0x01..) & ~w & 0x80.. is non zero if any byte of w is zero
+//(4 bytes per step on the esp32), the match is then found in that word
+size_t Framer::find(const uint8_t* p, size_t len, uint8_t b)
+{
+    using word_t = size_t;
+    const word_t ones = (word_t)-1 / 0xFF;
+    const word_t highs = ones << 7;
+    const word_t pat = ones * b;
+    size_t i = 0;
+    for(; i + sizeof(word_t) <= len; i += sizeof(word_t)){
+        word_t w;
+        memcpy(&w, &p[i], sizeof w);
+        w ^= pat;
+        if((w - ones) & ~w & highs) break;
+    }
+    for(; i < len; i++) if(p[i] == b) return i;
+    return len;
+}
+
+size_t Framer::next(ByteRing& rx, size_t cur, size_t& pos, size_t head, size_t max, bool idle)
+{
+    size_t pending = head - cur;
+    if((ptrdiff_t)(pos - cur) < 0) pos = cur;   //reader moved (connect, replay, skip)
+    switch(m_mode){
+        case LINE:
+        case DELIM: {
+            uint8_t b = m_mode == LINE ? '\n' : m_arg;
+            size_t lim = cur + (pending < max ? pending : max);
+            while(pos != lim){                  //up to 2 spans (ring wrap)
+                size_t len;
+                const uint8_t* p = rx.read_span(pos, len);
+                if(len > lim - pos) len = lim - pos;
+                size_t i = find(p, len, b);
+                pos += i < len ? i + 1 : len;
+                if(i < len) return pos - cur;
+            }
+            return pending >= max ? max : 0;
+        }
+        case LENGTH: {
+            if(pos == cur){                     //header
+                if(pending < m_arg) return 0;
+                size_t n = 0;
+                for(uint8_t i = 0; i < m_arg; i++){
+                    size_t len;
+                    n = n << 8 | *rx.read_span(cur + i, len);
+                }
+                pos = cur + m_arg + n;
+            }
+            size_t left = pos - cur;
+            if(left > max) left = max;
+            return pending >= left ? left : 0;
+        }
+        case IDLE:
+            if(pending >= max) return max;
+            return idle ? pending : 0;
+        default:
+            return pending;
+    }
+}
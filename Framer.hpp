@@ -0,0 +1,46 @@
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include "ByteRing.hpp"
+
+//uart -> tcp packet framing- where a frame of uart rx data ends, so each
+//frame goes out in one tcp write (one websocket message, one lz chunk)
+//
+//  LINE-       after a '\n'
+//  DELIM-      after a delimiter byte (arg)
+//  LENGTH-     a big endian length header of arg bytes (1 or 2), then that
+//              many data bytes (the reader must start at a frame start)
+//  IDLE-       after the uart has been idle arg char times
+//
+//a frame longer than max goes out in max byte pieces (for LENGTH the frame
+//end is kept, so the next header is still found), a partial frame is sent
+//by the caller after its hold time (a prompt with no newline)
+//
+//the delimiter is searched a word at a time (SWAR), each reader keeps its
+//position so data is only searched once
+
+struct Framer {
+
+    using mode_t = enum : uint8_t { NONE, LINE, DELIM, LENGTH, IDLE };
+
+    void        set         (mode_t, uint8_t);  //mode, arg
+    mode_t      mode        ();
+    uint8_t     arg         ();
+
+    //ring data cursor..head, reader position (search point or frame end,
+    //starts at the cursor), max frame bytes, uart idle arg char times
+    // -> bytes from cursor to send as one frame, 0 = no frame yet
+    size_t      next        (ByteRing&, size_t, size_t&, size_t, size_t, bool);
+
+    //-> index of the first b in p[0..len), len if none
+    static size_t find      (const uint8_t*, size_t, uint8_t);
+
+    static const char* name (mode_t);
+
+    private:
+
+    mode_t      m_mode{NONE};
+    uint8_t     m_arg{0};
+
+};
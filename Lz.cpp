@@ -0,0 +1,154 @@
+#include "Lz.hpp"
+#include <stdlib.h>
+#include <string.h>
+
+//=====================
+// local functions
+//=====================
+
+static const uint32_t WMASK = LzEncoder::WINDOW - 1;
+
+static uint32_t hash(const uint8_t* p)
+{
+    uint32_t v = p[0] | p[1] << 8 | p[2] << 16;
+    return (v * 2654435761u) >> (32 - LzEncoder::HASH_BITS);
+}
+
+//=====================
+// LzEncoder
+//=====================
+
+LzEncoder::~LzEncoder()
+{
+    end();
+}
+
+bool LzEncoder::start()
+{
+    if(not m_win){
+        m_win = (uint8_t*)malloc(WINDOW + (sizeof(uint16_t) << HASH_BITS));
+        if(not m_win) return false;
+        m_hash = (uint16_t*)&m_win[WINDOW];
+    }
+    memset(m_hash, 0, sizeof(uint16_t) << HASH_BITS);
+    m_pos = 0;
+    return true;
+}
+
+void LzEncoder::end()
+{
+    free(m_win);
+    m_win = nullptr;
+    m_hash = nullptr;
+}
+
+bool LzEncoder::on(){ return m_win; }
+
+//match length of in[i..] against the stream d bytes back- bytes before
+//in[i] are in the window, from in[i] on (overlapping match) in the input
+size_t LzEncoder::match(const uint8_t* in, size_t i, size_t max, uint32_t d)
+{
+    uint32_t pos = m_pos - d;
+    size_t k = 0;
+    for(; k < max and k < d; k++){
+        if(m_win[(pos + k) & WMASK] != in[i + k]) return k;
+    }
+    for(; k < max; k++){
+        if(in[i + k - d] != in[i + k]) break;
+    }
+    return k;
+}
+
+uint8_t* LzEncoder::literals(uint8_t* o, const uint8_t* p, size_t n)
+{
+    while(n){
+        size_t k = n > 128 ? 128 : n;
+        *o++ = k - 1;
+        memcpy(o, p, k);
+        o += k;
+        p += k;
+        n -= k;
+    }
+    return o;
+}
+
+//m_pos is the stream position of in[i] (window updated as input is taken)
+size_t LzEncoder::encode(const uint8_t* in, size_t len, uint8_t* out)
+{
+    uint8_t* o = out;
+    size_t lit = 0;                             //start of pending literals
+    size_t i = 0;
+    while(i < len){
+        size_t best = 0;
+        uint32_t d = 0;
+        if(i + 3 <= len){
+            uint16_t& h = m_hash[hash(&in[i])];
+            d = (uint16_t)(m_pos - h);
+            h = m_pos;
+            if(d and d <= WINDOW and d <= m_pos){
+                size_t max = len - i < MAX_MATCH ? len - i : MAX_MATCH;
+                best = match(in, i, max, d);
+            }
+        }
+        if(best < 3){
+            m_win[m_pos++ & WMASK] = in[i++];
+            continue;
+        }
+        o = literals(o, &in[lit], i - lit);
+        uint32_t off = d - 1;
+        if(best < 18){
+            *o++ = 0x80 | (best - 3) << 3 | off >> 8;
+            *o++ = off;
+        } else {
+            *o++ = 0x80 | 15 << 3 | off >> 8;
+            *o++ = off;
+            *o++ = best - 18;
+        }
+        for(size_t k = 0; k < best; k++) m_win[m_pos++ & WMASK] = in[i++];
+        lit = i;
+    }
+    return literals(o, &in[lit], i - lit) - out;
+}
+
+//=====================
+// LzDecoder
+//=====================
+
+void LzDecoder::start()
+{
+    m_pos = 0;
+    m_toklen = 0;
+    m_lits = 0;
+}
+
+size_t LzDecoder::decode(const uint8_t* in, size_t len, uint8_t* out)
+{
+    uint8_t* o = out;
+    for(size_t i = 0; i < len;){
+        if(m_lits){
+            uint8_t c = in[i++];
+            m_win[m_pos++ & WMASK] = c;
+            *o++ = c;
+            m_lits--;
+            continue;
+        }
+        m_tok[m_toklen++] = in[i++];
+        uint8_t t = m_tok[0];
+        if(not (t & 0x80)){                     //literal run
+            m_lits = t + 1;
+            m_toklen = 0;
+            continue;
+        }
+        size_t need = (t >> 3 & 15) == 15 ? 3 : 2;
+        if(m_toklen < need) continue;
+        uint32_t d = ((t & 7) << 8 | m_tok[1]) + 1;
+        size_t n = need == 3 ? 18 + m_tok[2] : (t >> 3 & 15) + 3;
+        for(; n; n--){
+            uint8_t c = m_win[(m_pos - d) & WMASK];
+            m_win[m_pos++ & WMASK] = c;
+            *o++ = c;
+        }
+        m_toklen = 0;
+    }
+    return o - out;
+}
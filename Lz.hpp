@@ -0,0 +1,73 @@
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+
+//small streaming lz77 compressor for the uart -> net direction
+//
+//the window is the last 2KB of the stream, so each encode() call can match
+//anything sent before (a long session of repeated log lines compresses well
+//even when sent in small pieces), and every call ends on a token boundary
+//(what it returns can be sent as is, nothing is held back)
+//
+//  encoder-    2KB window + 1K entry hash table (4KB, allocated by start)
+//  decoder-    2KB window, a few bytes of token state
+//
+//tokens (byte aligned)-
+//  0LLLLLLL                literal run, L+1 bytes follow (1-128)
+//  1LLLLOOO oooooooo [x]   match, offset OOOoooooooo+1 (1-2048) back,
+//                          length LLLL+3 (3-17), or when LLLL = 15,
+//                          18 + x (18-273)
+//
+//greedy parse, one hash probe per position (3 byte hash), no lazy matching-
+//cpu per byte stays flat, ratio on log text is well above what the link
+//needs to keep up with the uart
+
+struct LzEncoder {
+
+    static const size_t WINDOW  = 2048;
+    static const uint8_t HASH_BITS = 10;
+    static const size_t MAX_MATCH = 273;
+
+    //output bytes needed for n input bytes (worst case, all literals)
+    static size_t bound(size_t n){ return n + n / 128 + 1; }
+
+    ~LzEncoder          ();
+
+    bool        start   ();                     //allocate, reset -> false if no memory
+    void        end     ();                     //free
+    bool        on      ();                     //started
+
+    //in, len, out (bound(len) bytes) -> out bytes
+    size_t      encode  (const uint8_t*, size_t, uint8_t*);
+
+    private:
+
+    size_t      match   (const uint8_t*, size_t, size_t, uint32_t); //-> length at distance
+    uint8_t*    literals(uint8_t*, const uint8_t*, size_t);
+
+    uint8_t*    m_win{nullptr};                 //WINDOW bytes, then the hash table
+    uint16_t*   m_hash{nullptr};                //low 16 bits of last position of a hash
+    uint32_t    m_pos{0};                       //stream position
+
+};
+
+struct LzDecoder {
+
+    //output bytes at most for n input bytes
+    static size_t bound(size_t n){ return n * 137 + LzEncoder::MAX_MATCH; }
+
+    void        start   ();
+
+    //in, len, out (bound(len) bytes) -> out bytes, tokens may split anywhere
+    size_t      decode  (const uint8_t*, size_t, uint8_t*);
+
+    private:
+
+    uint8_t     m_win[LzEncoder::WINDOW];
+    uint32_t    m_pos{0};
+    uint8_t     m_tok[3];                       //match token being received
+    uint8_t     m_toklen{0};
+    uint8_t     m_lits{0};                      //literal bytes left in run
+
+};
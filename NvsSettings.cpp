@@ -1,16 +1,275 @@
 #include "NvsSettings.hpp"
-#include <WiFi.h>
+#include "UartPort.hpp"
+#include "Framer.hpp"
+#include "EventLog.hpp"
+#include "Reactor.hpp"
+#include "WifiLink.hpp"
+#include <nvs.h>
 
 //default names if not set yet
 const String hostname_default = "SNAP";
 const String APname_default = "SNAP-AP";
-//default uart2 baud
-const uint32_t uart2baud_default = 115200;
+//default uart baud, backlog bytes
+const uint32_t uartbaud_default = 115200;
+const uint32_t uartbl_size_default = 8192;
 
+//=====================
+// settings cache
+//=====================
+
+//nvs namespace, same keys and types Preferences used (bool = u8)
+static const char* nvs_namespace = "settings";
+
+//per uart port
+using uart_t = struct {
+    uint32_t    baud;
+    uint8_t     telnet;
+    uint8_t     drop;
+    uint32_t    co_size;
+    uint32_t    co_gap;
+    uint32_t    co_hold;
+    uint32_t    bl_size;
+    uint8_t     bl_wrap;
+    uint8_t     bl_auto;
+    uint8_t     enable;
+    uint16_t    port;
+    int8_t      rxpin;
+    int8_t      txpin;
+    uint32_t    config;
+    uint8_t     invert;
+    uint8_t     lz;
+    uint16_t    rx_ring;
+    uint8_t     rx_full;
+    uint8_t     rx_idle;
+    uint8_t     packet;
+    uint8_t     packet_arg;
+    uint8_t     flow;
+    int8_t      rtspin;
+    int8_t      ctspin;
+};
+
+static struct {
+    bool        loaded;
+    uint32_t    dirty[3];               //1 bit per entries[] index
+    uint32_t    changed_ms;             //millis() of last change
+    char        ssid[8][32];
+    char        pass[8][64];
+    char        hostname[33];
+    char        APname[33];
+    uint8_t     boot;
+    uint8_t     log;
+    uint16_t    reboot;
+    uint8_t     fast;
+    NvsSettings::wifilast_t last;
+    uart_t      uart[3];
+} cache;
+
+enum type_t { STR, U32, U16, U8, I8, BLOB };
+using entry_t = struct {
+    const char* key;
+    type_t      type;
+    void*       val;
+    size_t      size;                   //STR buffer size, BLOB size
+};
+
+//entries[] index of each setting (dirty bit), uart settings are a block
+//per port- UART0 + port * UART_N + setting
+enum { SSID0 = 0, PASS0 = 8, HOSTNAME = 16, APNAME, BOOT, LOG, REBOOT, FAST, LAST, UART0 };
+enum { BAUD, TELNET, DROP, CO_SIZE, CO_GAP, CO_HOLD, BL_SIZE, BL_WRAP, BL_AUTO,
+       ENABLE, PORT, RXPIN, TXPIN, CONFIG, INVERT, LZ, RX_RING, RX_FULL, RX_IDLE,
+       PACKET, PACKET_ARG, FLOW, RTSPIN, CTSPIN, UART_N };
+
+#define UART_ENTRIES(n) \
+    { "uart" #n "baud",     U32,    &cache.uart[n].baud,    0 }, \
+    { "uart" #n "telnet",   U8,     &cache.uart[n].telnet,  0 }, \
+    { "uart" #n "drop",     U8,     &cache.uart[n].drop,    0 }, \
+    { "uart" #n "co_size",  U32,    &cache.uart[n].co_size, 0 }, \
+    { "uart" #n "co_gap",   U32,    &cache.uart[n].co_gap,  0 }, \
+    { "uart" #n "co_hold",  U32,    &cache.uart[n].co_hold, 0 }, \
+    { "uart" #n "bl_size",  U32,    &cache.uart[n].bl_size, 0 }, \
+    { "uart" #n "bl_wrap",  U8,     &cache.uart[n].bl_wrap, 0 }, \
+    { "uart" #n "bl_auto",  U8,     &cache.uart[n].bl_auto, 0 }, \
+    { "uart" #n "enable",   U8,     &cache.uart[n].enable,  0 }, \
+    { "uart" #n "port",     U16,    &cache.uart[n].port,    0 }, \
+    { "uart" #n "rxpin",    I8,     &cache.uart[n].rxpin,   0 }, \
+    { "uart" #n "txpin",    I8,     &cache.uart[n].txpin,   0 }, \
+    { "uart" #n "config",   U32,    &cache.uart[n].config,  0 }, \
+    { "uart" #n "invert",   U8,     &cache.uart[n].invert,  0 }, \
+    { "uart" #n "lz",       U8,     &cache.uart[n].lz,      0 }, \
+    { "uart" #n "rx_ring",  U16,    &cache.uart[n].rx_ring, 0 }, \
+    { "uart" #n "rx_full",  U8,     &cache.uart[n].rx_full, 0 }, \
+    { "uart" #n "rx_idle",  U8,     &cache.uart[n].rx_idle, 0 }, \
+    { "uart" #n "packet",   U8,     &cache.uart[n].packet,  0 }, \
+    { "uart" #n "packet_arg", U8,   &cache.uart[n].packet_arg, 0 }, \
+    { "uart" #n "flow",     U8,     &cache.uart[n].flow,    0 }, \
+    { "uart" #n "rtspin",   I8,     &cache.uart[n].rtspin,  0 }, \
+    { "uart" #n "ctspin",   I8,     &cache.uart[n].ctspin,  0 }
+
+static const entry_t entries[] = {
+    { "ssid0", STR, cache.ssid[0], 32 }, { "ssid1", STR, cache.ssid[1], 32 },
+    { "ssid2", STR, cache.ssid[2], 32 }, { "ssid3", STR, cache.ssid[3], 32 },
+    { "ssid4", STR, cache.ssid[4], 32 }, { "ssid5", STR, cache.ssid[5], 32 },
+    { "ssid6", STR, cache.ssid[6], 32 }, { "ssid7", STR, cache.ssid[7], 32 },
+    { "pass0", STR, cache.pass[0], 64 }, { "pass1", STR, cache.pass[1], 64 },
+    { "pass2", STR, cache.pass[2], 64 }, { "pass3", STR, cache.pass[3], 64 },
+    { "pass4", STR, cache.pass[4], 64 }, { "pass5", STR, cache.pass[5], 64 },
+    { "pass6", STR, cache.pass[6], 64 }, { "pass7", STR, cache.pass[7], 64 },
+    { "hostname",       STR,    cache.hostname,     sizeof(cache.hostname) },
+    { "APname",         STR,    cache.APname,       sizeof(cache.APname) },
+    { "boot",           U8,     &cache.boot,        0 },
+    { "log",            U8,     &cache.log,         0 },
+    { "wifireboot",     U16,    &cache.reboot,      0 },
+    { "wififast",       U8,     &cache.fast,        0 },
+    { "wifilast",       BLOB,   &cache.last,        sizeof(cache.last) },
+    UART_ENTRIES(0),
+    UART_ENTRIES(1),
+    UART_ENTRIES(2),
+};
+static const size_t nentries = sizeof(entries) / sizeof(entries[0]);
+static_assert(nentries == UART0 + 3 * UART_N, "uart entries");
+static_assert(nentries <= sizeof(cache.dirty) * 8, "dirty bits");
+
+static bool is_dirty(size_t i){ return cache.dirty[i / 32] & (1u << (i % 32)); }
+static void set_dirty(size_t i, bool tf)
+{
+    if(tf) cache.dirty[i / 32] |= 1u << (i % 32);
+    else cache.dirty[i / 32] &= ~(1u << (i % 32));
+}
+static bool any_dirty()
+{
+    for(auto d : cache.dirty) if(d) return true;
+    return false;
+}
+
+static void defaults()
+{
+    memset(cache.ssid, 0, sizeof(cache.ssid));
+    memset(cache.pass, 0, sizeof(cache.pass));
+    cache.hostname[0] = 0;
+    cache.APname[0] = 0;
+    cache.boot = false;
+    cache.log = EventLog::SERIAL_OUT | EventLog::TELNET_OUT;
+    cache.reboot = 0;                           //keep what the bridges hold
+    cache.fast = WifiLink::FAST_BSSID;
+    memset(&cache.last, 0, sizeof(cache.last));
+    cache.last.index = 0xFF;
+    //uart2 is the bridge (as before), uart0 is the debug console, uart1
+    //default pins are the flash pins so it needs pins set before enabling
+    for(uint8_t n = 0; n < 3; n++){
+        uart_t& u = cache.uart[n];
+        u.baud = uartbaud_default;
+        u.telnet = true;
+        u.drop = false;
+        u.co_size = u.co_gap = u.co_hold = 0;
+        u.bl_size = uartbl_size_default;
+        u.bl_wrap = true;
+        u.bl_auto = false;
+        u.enable = n == 2;
+        u.port = n ? 2300 + n : 2310;           //2300 is the info port
+        u.rxpin = u.txpin = -1;
+        u.config = SERIAL_8N1;
+        u.invert = false;
+        u.lz = false;
+        u.rx_ring = UartPort::RX_RING_DEF;
+        u.rx_full = UartPort::RX_FULL_DEF;
+        u.rx_idle = UartPort::RX_IDLE_DEF;
+        u.packet = Framer::NONE;
+        u.packet_arg = 0;
+        u.flow = UartPort::FLOW_NONE;
+        u.rtspin = u.ctspin = -1;
+    }
+    memset(cache.dirty, 0, sizeof(cache.dirty));
+}
+
+//read every setting once, anything missing keeps its default
+static void load()
+{
+    defaults();
+    cache.loaded = true;
+    nvs_handle h;
+    if(nvs_open(nvs_namespace, NVS_READWRITE, &h) != ESP_OK) return;
+    for(auto& e : entries){
+        size_t len = e.size;
+        switch(e.type){
+            case STR:
+                if(nvs_get_str(h, e.key, (char*)e.val, &len) != ESP_OK) *(char*)e.val = 0;
+                break;
+            case U32: nvs_get_u32(h, e.key, (uint32_t*)e.val); break;
+            case U16: nvs_get_u16(h, e.key, (uint16_t*)e.val); break;
+            case U8: nvs_get_u8(h, e.key, (uint8_t*)e.val); break;
+            case I8: nvs_get_i8(h, e.key, (int8_t*)e.val); break;
+            case BLOB: {                        //only if the size matches
+                uint8_t b[64];
+                len = sizeof(b);
+                if(nvs_get_blob(h, e.key, b, &len) == ESP_OK and len == e.size) memcpy(e.val, b, len);
+                break;
+            }
+        }
+    }
+    nvs_close(h);
+}
+
+//set cache value, mark changed only if different
+static size_t put(int i, const String& s)
+{
+    const entry_t& e = entries[i];
+    if(s.length() >= e.size) return 0;
+    if(strcmp((char*)e.val, s.c_str())){
+        strcpy((char*)e.val, s.c_str());
+        set_dirty(i, true);
+        cache.changed_ms = millis();
+    }
+    return s.length();
+}
+//numbers stored as their type, -> bytes
+static size_t put(int i, uint32_t v)
+{
+    const entry_t& e = entries[i];
+    size_t n = e.type == U32 ? 4 : e.type == U16 ? 2 : 1;
+    uint32_t old = 0;
+    memcpy(&old, e.val, n);                     //little endian
+    if(memcmp(&old, &v, n)){
+        memcpy(e.val, &v, n);
+        set_dirty(i, true);
+        cache.changed_ms = millis();
+    }
+    return n;
+}
+static size_t put(int i, const void* p, size_t n)
+{
+    const entry_t& e = entries[i];
+    if(n != e.size) return 0;
+    if(memcmp(e.val, p, n)){
+        memcpy(e.val, p, n);
+        set_dirty(i, true);
+        cache.changed_ms = millis();
+    }
+    return n;
+}
+static uint32_t get(int i)
+{
+    const entry_t& e = entries[i];
+    switch(e.type){
+        case U32: return *(uint32_t*)e.val;
+        case U16: return *(uint16_t*)e.val;
+        case I8: return *(int8_t*)e.val;
+        default: return *(uint8_t*)e.val;
+    }
+}
+
+//uart setting index
+static int uart(uint8_t n, int setting)
+{
+    return UART0 + (n < 3 ? n : 2) * UART_N + setting;
+}
+
+//=====================
+// NvsSettings
+//=====================
 
 NvsSettings::NvsSettings()
 {
-    m_settings.begin("settings");
+    if(not cache.loaded) load();
 }
 
 uint8_t NvsSettings::wifimaxn()
@@ -18,86 +277,319 @@ uint8_t NvsSettings::wifimaxn()
     return m_wifimaxn;
 }
 
-//private
-String NvsSettings::gets(String s, String alt = String())
+uint8_t NvsSettings::uartmaxn()
 {
-    return m_settings.getString(s.c_str(), alt);
+    return m_uartmaxn;
 }
-size_t NvsSettings::puts(String key, String s)
+
+//changed entries written, then one commit
+//(entries that fail stay dirty for the next flush)
+bool NvsSettings::flush()
 {
-    return m_settings.putString(key.c_str(), s);
+    if(not any_dirty()) return true;
+    nvs_handle h;
+    if(nvs_open(nvs_namespace, NVS_READWRITE, &h) != ESP_OK) return false;
+    bool done[nentries] = {};
+    for(size_t i = 0; i < nentries; i++){
+        if(not is_dirty(i)) continue;
+        const entry_t& e = entries[i];
+        esp_err_t err = ESP_FAIL;
+        switch(e.type){
+            case STR: err = nvs_set_str(h, e.key, (char*)e.val); break;
+            case U32: err = nvs_set_u32(h, e.key, *(uint32_t*)e.val); break;
+            case U16: err = nvs_set_u16(h, e.key, *(uint16_t*)e.val); break;
+            case U8: err = nvs_set_u8(h, e.key, *(uint8_t*)e.val); break;
+            case I8: err = nvs_set_i8(h, e.key, *(int8_t*)e.val); break;
+            case BLOB: err = nvs_set_blob(h, e.key, e.val, e.size); break;
+        }
+        done[i] = err == ESP_OK;
+    }
+    bool ok = nvs_commit(h) == ESP_OK;
+    nvs_close(h);
+    for(size_t i = 0; ok and i < nentries; i++) if(done[i]) set_dirty(i, false);
+    return ok and not any_dirty();
+}
+
+//the loop sleeps until the flush is due (Reactor), a failed flush is tried
+//again FLUSH_MS later
+void NvsSettings::check()
+{
+    if(not any_dirty()) return;
+    uint32_t ms = millis() - cache.changed_ms;
+    if(ms >= FLUSH_MS){ flush(); ms = 0; }
+    if(any_dirty()) Reactor::due((FLUSH_MS - ms) * 1000);
+}
+
+bool NvsSettings::dirty()
+{
+    return any_dirty();
 }
-//
 
 
 String NvsSettings::ssid(uint8_t idx)
 {
-    if(idx > m_wifimaxn) return {};
-    return gets(String("ssid" + String(idx)));
+    if(idx >= m_wifimaxn) return {};
+    return cache.ssid[idx];
 }
 size_t NvsSettings::ssid(uint8_t idx, String ssid)
 {
-    if(ssid.length() > 31 || idx > m_wifimaxn) return 0;
-    return puts(String("ssid" + String(idx)), ssid);
+    if(ssid.length() > 31 || idx >= m_wifimaxn) return 0;
+    return put(SSID0 + idx, ssid);
 }
 
 String NvsSettings::pass(uint8_t idx)
 {
-    if(idx > m_wifimaxn) return {};
-    return gets(String("pass" + String(idx)));
+    if(idx >= m_wifimaxn) return {};
+    return cache.pass[idx];
 }
 size_t NvsSettings::pass(uint8_t idx, String pass)
 {
-    if(pass.length() > 63 || idx > m_wifimaxn) return 0;
-    return puts(String("pass" + String(idx)), pass);
+    if(pass.length() > 63 || idx >= m_wifimaxn) return 0;
+    return put(PASS0 + idx, pass);
 }
 
 String NvsSettings::hostname()
 {
-    String s = gets(String("hostname"));
-    if(s.length()) return s;
+    if(cache.hostname[0]) return cache.hostname;
     return hostname_default;
 }
 size_t NvsSettings::hostname(String s)
 {
-    return puts(String("hostname"), s);
+    return put(HOSTNAME, s);
 }
 
 String NvsSettings::APname()
 {
-    String s = gets(String("APname"));
-    if(s.length()) return s;
+    if(cache.APname[0]) return cache.APname;
     return APname_default;
 }
 size_t NvsSettings::APname(String s)
 {
-    return puts(String("APname"), s);
+    return put(APNAME, s);
+}
+
+bool NvsSettings::uartenable(uint8_t n)
+{
+    return get(uart(n, ENABLE));
+}
+size_t NvsSettings::uartenable(uint8_t n, bool tf)
+{
+    return put(uart(n, ENABLE), tf);
+}
+
+uint16_t NvsSettings::uartport(uint8_t n)
+{
+    return get(uart(n, PORT));
+}
+size_t NvsSettings::uartport(uint8_t n, uint16_t port)
+{
+    return put(uart(n, PORT), port);
+}
+
+int8_t NvsSettings::uartrxpin(uint8_t n)
+{
+    return get(uart(n, RXPIN));
+}
+int8_t NvsSettings::uarttxpin(uint8_t n)
+{
+    return get(uart(n, TXPIN));
+}
+size_t NvsSettings::uartpins(uint8_t n, int8_t rx, int8_t tx)
+{
+    return put(uart(n, RXPIN), (uint8_t)rx) + put(uart(n, TXPIN), (uint8_t)tx);
+}
+
+uint32_t NvsSettings::uartconfig(uint8_t n)
+{
+    return get(uart(n, CONFIG));
+}
+size_t NvsSettings::uartconfig(uint8_t n, uint32_t cfg)
+{
+    return put(uart(n, CONFIG), cfg);
+}
+
+bool NvsSettings::uartinvert(uint8_t n)
+{
+    return get(uart(n, INVERT));
+}
+size_t NvsSettings::uartinvert(uint8_t n, bool tf)
+{
+    return put(uart(n, INVERT), tf);
+}
+
+uint32_t NvsSettings::uartbaud(uint8_t n)
+{
+    return get(uart(n, BAUD));
+}
+size_t NvsSettings::uartbaud(uint8_t n, uint32_t baud)
+{
+    return put(uart(n, BAUD), baud);
+}
+
+bool NvsSettings::uarttelnet(uint8_t n)
+{
+    return get(uart(n, TELNET));
+}
+size_t NvsSettings::uarttelnet(uint8_t n, bool tf)
+{
+    return put(uart(n, TELNET), tf);
+}
+
+bool NvsSettings::uartcompress(uint8_t n)
+{
+    return get(uart(n, LZ));
+}
+size_t NvsSettings::uartcompress(uint8_t n, bool tf)
+{
+    return put(uart(n, LZ), tf);
+}
+
+bool NvsSettings::uartdrop(uint8_t n)
+{
+    return get(uart(n, DROP));
+}
+size_t NvsSettings::uartdrop(uint8_t n, bool tf)
+{
+    return put(uart(n, DROP), tf);
+}
+
+uint16_t NvsSettings::uartco_size(uint8_t n)
+{
+    return get(uart(n, CO_SIZE));
+}
+uint32_t NvsSettings::uartco_gap(uint8_t n)
+{
+    return get(uart(n, CO_GAP));
+}
+uint32_t NvsSettings::uartco_hold(uint8_t n)
+{
+    return get(uart(n, CO_HOLD));
+}
+size_t NvsSettings::uartcoalesce(uint8_t n, uint16_t size, uint32_t gap, uint32_t hold)
+{
+    return put(uart(n, CO_SIZE), size) + put(uart(n, CO_GAP), gap) + put(uart(n, CO_HOLD), hold);
+}
+
+uint32_t NvsSettings::uartbl_size(uint8_t n)
+{
+    return get(uart(n, BL_SIZE));
+}
+bool NvsSettings::uartbl_wrap(uint8_t n)
+{
+    return get(uart(n, BL_WRAP));
+}
+bool NvsSettings::uartbl_auto(uint8_t n)
+{
+    return get(uart(n, BL_AUTO));
+}
+size_t NvsSettings::uartbacklog(uint8_t n, uint32_t size, bool wrap, bool autor)
+{
+    return put(uart(n, BL_SIZE), size) + put(uart(n, BL_WRAP), wrap) + put(uart(n, BL_AUTO), autor);
 }
 
-uint32_t NvsSettings::uart2baud()
+uint16_t NvsSettings::uartrx_ring(uint8_t n)
+{
+    return get(uart(n, RX_RING));
+}
+uint8_t NvsSettings::uartrx_full(uint8_t n)
+{
+    return get(uart(n, RX_FULL));
+}
+uint8_t NvsSettings::uartrx_idle(uint8_t n)
 {
-    return m_settings.getUInt("uart2baud", uart2baud_default);
+    return get(uart(n, RX_IDLE));
 }
-size_t NvsSettings::uart2baud(uint32_t baud)
+size_t NvsSettings::uartdriver(uint8_t n, uint16_t ring, uint8_t full, uint8_t idle)
 {
-    return m_settings.putUInt("uart2baud", baud);
+    return put(uart(n, RX_RING), ring) + put(uart(n, RX_FULL), full) + put(uart(n, RX_IDLE), idle);
+}
+
+uint8_t NvsSettings::uartpacket(uint8_t n)
+{
+    return get(uart(n, PACKET));
+}
+uint8_t NvsSettings::uartpacket_arg(uint8_t n)
+{
+    return get(uart(n, PACKET_ARG));
+}
+size_t NvsSettings::uartpacket(uint8_t n, uint8_t mode, uint8_t arg)
+{
+    return put(uart(n, PACKET), mode) + put(uart(n, PACKET_ARG), arg);
+}
+
+uint8_t NvsSettings::uartflow(uint8_t n)
+{
+    return get(uart(n, FLOW));
+}
+int8_t NvsSettings::uartrtspin(uint8_t n)
+{
+    return get(uart(n, RTSPIN));
+}
+int8_t NvsSettings::uartctspin(uint8_t n)
+{
+    return get(uart(n, CTSPIN));
+}
+size_t NvsSettings::uartflow(uint8_t n, uint8_t flow, int8_t rts, int8_t cts)
+{
+    return put(uart(n, FLOW), flow) + put(uart(n, RTSPIN), rts) + put(uart(n, CTSPIN), cts);
 }
 
 bool NvsSettings::clear()
 {
-    return m_settings.clear();
+    return erase_all();
 }
 
 bool NvsSettings::boot_to_AP()
 {
-    return m_settings.getBool("boot", false);
+    return cache.boot;
 }
 size_t NvsSettings::boot_to_AP(bool tf)
 {
-    return m_settings.putBool("boot", tf);
+    return put(BOOT, tf);
+}
+
+uint8_t NvsSettings::logout()
+{
+    return cache.log;
+}
+size_t NvsSettings::logout(uint8_t v)
+{
+    return put(LOG, v);
+}
+
+uint16_t NvsSettings::wifireboot()
+{
+    return cache.reboot;
+}
+size_t NvsSettings::wifireboot(uint16_t v)
+{
+    return put(REBOOT, v);
+}
+
+uint8_t NvsSettings::wififast()
+{
+    return cache.fast;
+}
+size_t NvsSettings::wififast(uint8_t v)
+{
+    return put(FAST, v);
+}
+NvsSettings::wifilast_t NvsSettings::wifilast()
+{
+    return cache.last;
+}
+size_t NvsSettings::wifilast(const wifilast_t& w)
+{
+    return put(LAST, &w, sizeof(w));
 }
 
+//not deferred, cache back to defaults
 bool NvsSettings::erase_all()
 {
-    return m_settings.clear();
+    defaults();
+    nvs_handle h;
+    if(nvs_open(nvs_namespace, NVS_READWRITE, &h) != ESP_OK) return false;
+    bool ok = nvs_erase_all(h) == ESP_OK and nvs_commit(h) == ESP_OK;
+    nvs_close(h);
+    return ok;
 }
@@ -1,13 +1,36 @@
 #pragma once
 
-#include <Preferences.h>
+#include <Arduino.h>
 
 // max ssid size = 31, max pass size = 63
 // store ssid 0-m_wifimaxn, pass 0-m_wifimaxn
-// store hostname, APname, boot, uart2baud
+// store hostname, APname, boot, event log outputs, wifi reboot policy, wifi
+// fast reconnect mode and last good connection, and per uart port (0-2)- enable, tcp port, pins, framing, invert, baud, telnet,
+// drop, coalescing size/gap/hold, backlog size/overwrite/replay, compression
+// allowed, driver rx ring/fifo full/idle, packet framing mode/arg, rx flow
+// control/rts/cts pins (keys "uart<n><name>", so the uart2 keys are the ones
+// used before there were more ports)
+
+// all settings are cached in ram, loaded from nvs once (first NvsSettings
+// created), so any NvsSettings reads from the same cache- a set only marks
+// the setting changed, changed settings are written with one nvs commit by
+// flush() (check() from loop flushes once no changes for a few seconds,
+// anything that restarts should flush first)
 
 struct NvsSettings {
 
+    //last good wifi connection (WifiLink fast reconnect)- stored credentials
+    //index (0xFF = none), its ap bssid and channel, and the dhcp lease
+    using wifilast_t = struct {
+        uint8_t     index;
+        uint8_t     channel;
+        uint8_t     bssid[6];
+        uint32_t    ip;                     //0 = none
+        uint32_t    gateway;
+        uint32_t    mask;
+        uint32_t    dns;
+    };
+
     NvsSettings();
     String ssid(uint8_t);           //index -> ssid string (empty if none)
     size_t ssid(uint8_t, String);   //index, ssid -> bytes written
@@ -21,26 +44,85 @@ struct NvsSettings {
     String APname();                //get access point name
     size_t APname(String s);        //set acces point name (used in AP mode)
 
-    uint32_t uart2baud();           //get uart2 baud
-    size_t uart2baud(uint32_t);     //set uart2 baud
+    //uart ports 0-2 (first arg), each for that port's bridge-
+    bool uartenable(uint8_t);       //get bridge enabled (applies on boot)
+    size_t uartenable(uint8_t, bool); //set bridge enabled
+    uint16_t uartport(uint8_t);     //get bridge tcp port (applies on boot)
+    size_t uartport(uint8_t, uint16_t); //set bridge tcp port
+    int8_t uartrxpin(uint8_t);      //get rx pin (-1=default)
+    int8_t uarttxpin(uint8_t);      //get tx pin (-1=default)
+    size_t uartpins(uint8_t, int8_t, int8_t); //set rx pin, tx pin
+    uint32_t uartconfig(uint8_t);   //get framing (SERIAL_8N1 etc)
+    size_t uartconfig(uint8_t, uint32_t); //set framing
+    bool uartinvert(uint8_t);       //get rx/tx inverted
+    size_t uartinvert(uint8_t, bool); //set rx/tx inverted
+
+    uint32_t uartbaud(uint8_t);     //get baud
+    size_t uartbaud(uint8_t, uint32_t); //set baud
+
+    bool uarttelnet(uint8_t);       //get telnet protocol, 0=raw tcp
+    size_t uarttelnet(uint8_t, bool); //set telnet protocol
+
+    bool uartcompress(uint8_t);     //get telnet clients may ask for compression
+    size_t uartcompress(uint8_t, bool); //set compression allowed
+
+    bool uartdrop(uint8_t);         //get slow reader policy, 1=close, 0=skip
+    size_t uartdrop(uint8_t, bool); //set slow reader policy
+
+    uint16_t uartco_size(uint8_t);  //get coalesce size bytes (0=auto)
+    uint32_t uartco_gap(uint8_t);   //get coalesce idle gap us (0=auto)
+    uint32_t uartco_hold(uint8_t);  //get coalesce max hold us (0=auto)
+    size_t uartcoalesce(uint8_t, uint16_t, uint32_t, uint32_t); //set size, gap, hold
+
+    uint32_t uartbl_size(uint8_t);  //get backlog bytes (0=none)
+    bool uartbl_wrap(uint8_t);      //get backlog full, 1=overwrite oldest, 0=stop
+    bool uartbl_auto(uint8_t);      //get backlog replay, 1=on connect, 0=on request
+    size_t uartbacklog(uint8_t, uint32_t, bool, bool); //set size, wrap, auto
+
+    uint16_t uartrx_ring(uint8_t);  //get driver rx ring bytes
+    uint8_t uartrx_full(uint8_t);   //get rx fifo bytes for an interrupt
+    uint8_t uartrx_idle(uint8_t);   //get rx idle char times for an interrupt
+    size_t uartdriver(uint8_t, uint16_t, uint8_t, uint8_t); //set ring, full, idle
+
+    uint8_t uartpacket(uint8_t);    //get packet framing mode (Framer::mode_t)
+    uint8_t uartpacket_arg(uint8_t);//get framing delimiter/length bytes/idle chars
+    size_t uartpacket(uint8_t, uint8_t, uint8_t); //set mode, arg
+
+    uint8_t uartflow(uint8_t);      //get rx flow control (UartPort::flow_t)
+    int8_t uartrtspin(uint8_t);     //get rts pin (-1=none)
+    int8_t uartctspin(uint8_t);     //get cts pin (-1=none)
+    size_t uartflow(uint8_t, uint8_t, int8_t, int8_t); //set flow, rts, cts
 
     uint8_t wifimaxn();             //-> max number of wifi credentials can store
+    uint8_t uartmaxn();             //-> number of uart ports
 
     bool clear();                   //clear all nvs entries for this namespace
 
     bool boot_to_AP();              //get boot val, 1=boot to AP mode
     size_t boot_to_AP(bool);        //set boot val, 1=AP, 0=STA
 
-    bool erase_all();               //erase all data in this namespace
+    uint8_t logout();               //get event log outputs (EventLog bits)
+    size_t logout(uint8_t);         //set event log outputs
 
+    uint16_t wifireboot();          //get reboot when wifi down seconds (0=never)
+    size_t wifireboot(uint16_t);    //set reboot when wifi down seconds
 
-    private:
+    uint8_t wififast();             //get fast reconnect mode (WifiLink::fast_t)
+    size_t wififast(uint8_t);       //set fast reconnect mode
+    wifilast_t wifilast();          //get last good wifi connection
+    size_t wifilast(const wifilast_t&); //set last good wifi connection
 
-    String gets(String, String);
-    size_t puts(String, String);
-    Preferences m_settings;
-    const uint8_t m_wifimaxn = 8;   //limit to 8 ssid/pass
+    bool erase_all();               //erase all data in this namespace (now)
 
-};
+    static bool flush();            //write changed settings to nvs (one commit)
+    static void check();            //flush if changed and no changes for FLUSH_MS
+    static bool dirty();            //-> true if changes not written yet
 
 
+    private:
+
+    static const uint8_t m_wifimaxn = 8;    //limit to 8 ssid/pass
+    static const uint8_t m_uartmaxn = 3;    //uart ports (esp32 has 3)
+    static const uint32_t FLUSH_MS = 2000;  //deferred flush after last change
+
+};
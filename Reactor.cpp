@@ -0,0 +1,158 @@
+#include "Reactor.hpp"
+#include <lwip/sockets.h>
+#include <freertos/timers.h>
+#include <unistd.h>
+
+//=====================
+// local functions
+//=====================
+
+//what the loop waits on (loop only)
+static fd_set rd_set, wr_set;
+static int max_fd = -1;
+static bool due_set;
+static uint32_t due_us;                     //micros() to be checked at
+
+//wake- loopback udp socket connected to itself, one datagram per sleep
+static int wake_fd = -1;
+static std::atomic<bool> woken{false};
+static std::atomic<uint32_t> wake_us{0};    //micros() of the first wake
+
+//stats (loop only)
+static struct {
+    uint32_t    start_us;
+    uint64_t    total_us;                   //since reset
+    uint64_t    idle_us;
+    uint32_t    passes;
+    uint32_t    wakes, sockets, timers;     //what ended the sleep
+    uint64_t    wake_lat, timer_lat;        //sums, us
+    uint32_t    wake_max, timer_max;
+} st;
+
+static void open_wake()
+{
+    int fd = socket(AF_INET, SOCK_DGRAM, 0);
+    if(fd < 0) return;
+    sockaddr_in a{};
+    a.sin_family = AF_INET;
+    a.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    socklen_t len = sizeof(a);
+    if(bind(fd, (sockaddr*)&a, sizeof(a)) or getsockname(fd, (sockaddr*)&a, &len) or
+       connect(fd, (sockaddr*)&a, sizeof(a))){
+        close(fd);
+        return;
+    }
+    fcntl(fd, F_SETFL, O_NONBLOCK);
+    wake_fd = fd;
+}
+
+static void send_wake(void* = nullptr, uint32_t = 0)
+{
+    static const uint8_t b = 0;
+    if(wake_fd >= 0) send(wake_fd, &b, 1, MSG_DONTWAIT);
+}
+
+static void add(fd_set& set, int fd)
+{
+    if(fd < 0) return;
+    FD_SET(fd, &set);
+    if(fd > max_fd) max_fd = fd;
+}
+
+//=====================
+// class functions
+//=====================
+
+void Reactor::read(int fd){ add(rd_set, fd); }
+void Reactor::write(int fd){ add(wr_set, fd); }
+
+void Reactor::due(uint32_t us)
+{
+    uint32_t t = micros() + us;
+    if(not due_set or (int32_t)(t - due_us) < 0) due_us = t;
+    due_set = true;
+}
+
+//the first wake since the loop last woke sends the datagram
+void Reactor::wake()
+{
+    if(woken.exchange(true)) return;
+    wake_us = micros();
+    send_wake();
+}
+
+//the send is done by the timer task
+void IRAM_ATTR Reactor::wake_isr()
+{
+    if(woken.exchange(true)) return;
+    wake_us = micros();
+    BaseType_t hp = pdFALSE;
+    xTimerPendFunctionCallFromISR(send_wake, nullptr, 0, &hp);
+    if(hp) portYIELD_FROM_ISR();
+}
+
+void Reactor::wait()
+{
+    if(wake_fd < 0) open_wake();
+    uint32_t now = micros();
+    if(not st.start_us) st.start_us = now | 1;
+    uint32_t left = MAX_MS * 1000;
+    if(due_set) left = (int32_t)(due_us - now) <= 0 ? 0 : due_us - now < left ? due_us - now : left;
+    if(woken) left = 0;                         //wake in flight (or no socket yet)
+    bool sleep = left >= TICK_US;
+    int n = 0;
+    if(left){
+        add(rd_set, wake_fd);
+        timeval tv{ (time_t)(left / 1000000), (suseconds_t)(sleep ? left % 1000000 : 0) };
+        n = select(max_fd + 1, &rd_set, &wr_set, nullptr, &tv);
+    }
+    uint32_t t = micros();
+    st.idle_us += t - now;
+    st.passes++;
+    bool w = woken;
+    bool wake_rd = n > 0 and wake_fd >= 0 and FD_ISSET(wake_fd, &rd_set);
+    if(wake_rd) n--;
+    if(w or wake_rd){                           //datagram(s) read, one may be late
+        uint8_t b[8];
+        while(recv(wake_fd, b, sizeof(b), MSG_DONTWAIT) > 0);
+    }
+    if(w){
+        woken = false;                          //wakes from here on send again
+        uint32_t lat = t - wake_us;
+        st.wakes++;
+        st.wake_lat += lat;
+        if(lat > st.wake_max) st.wake_max = lat;
+    } else if(n > 0){
+        st.sockets++;
+    } else if(due_set and sleep and not wake_rd){
+        uint32_t lat = (int32_t)(t - due_us) > 0 ? t - due_us : 0;
+        st.timers++;
+        st.timer_lat += lat;
+        if(lat > st.timer_max) st.timer_max = lat;
+    }
+    FD_ZERO(&rd_set);
+    FD_ZERO(&wr_set);
+    max_fd = -1;
+    due_set = false;
+    st.total_us += t - st.start_us;
+    st.start_us = t | 1;
+}
+
+void Reactor::stats(WiFiClient& client)
+{
+    uint32_t total = st.total_us / 1000 ? st.total_us / 1000 : 1;
+    uint32_t idle = st.idle_us / 1000;
+    client.printf("loop   idle %u.%u%% of %ums | passes %u | woken %u, socket %u, timer %u\n",
+        (unsigned)(idle * 100ull / total), (unsigned)(idle * 1000ull / total % 10), (unsigned)total,
+        (unsigned)st.passes, (unsigned)st.wakes, (unsigned)st.sockets, (unsigned)st.timers);
+    client.printf("       wake -> service us avg %u max %u | timer late us avg %u max %u\n",
+        st.wakes ? (unsigned)(st.wake_lat / st.wakes) : 0, (unsigned)st.wake_max,
+        st.timers ? (unsigned)(st.timer_lat / st.timers) : 0, (unsigned)st.timer_max);
+}
+
+void Reactor::stats_reset()
+{
+    uint32_t t = st.start_us;
+    memset(&st, 0, sizeof(st));
+    st.start_us = t;
+}
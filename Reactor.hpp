@@ -0,0 +1,44 @@
+#pragma once
+
+#include <WiFi.h>
+#include <atomic>
+
+//main loop sleep- loop() checks every event source, then sleeps in wait()
+//until one of them has something to do-
+//
+//  socket-     during its check a source adds the sockets it waits on (read,
+//              or write while a full socket holds up its data)
+//  due-        a time it has to be checked again (coalescing hold, idle
+//              close, settings flush, long press)
+//  wake-       from another task or an isr (uart rx data, button)- a
+//              datagram to a loopback socket that is in the same select
+//
+//what was added is cleared when wait() returns, so a source that adds
+//nothing does not keep the loop awake (MAX_MS is the longest sleep)
+//
+//stats- time asleep (idle), and wake to service latency- from wake() to the
+//loop running, or from the due time for a timer
+
+struct Reactor {
+
+    static const uint32_t MAX_MS = 1000;
+
+    //select sleeps in whole freertos ticks- a due time closer than this is
+    //polled for (select without a timeout), so a coalescing gap of a few
+    //hundred us is not stretched to a tick
+    static const uint32_t TICK_US = 1000;
+
+    //sources, while checked (loop)
+    static void read    (int);              //socket, wait until readable
+    static void write   (int);              //socket, wait until writable
+    static void due     (uint32_t);         //check again in us (0 = no sleep)
+
+    static void wake    ();                 //any task
+    static void wake_isr();                 //isr
+
+    static void wait    ();                 //loop- sleep until a source is ready
+
+    static void stats   (WiFiClient&);
+    static void stats_reset();
+
+};
@@ -0,0 +1,82 @@
+#pragma once
+
+#include <stdint.h>
+#include <atomic>
+
+//lock-free flight recorder ring of fixed size records (Trace, EventLog)
+//
+//any task writes, no locks- put() takes the next position, marks its slot
+//as being written (seq 0), fills the record and stores seq = position + 1
+//
+//readers each keep their own place (reader_t)- a record is copied then its
+//seq checked again, if a writer overwrote it in the meantime (lapped) the
+//reader moves ahead to the oldest record and counts the ones skipped as
+//lost, so a reader that falls behind loses the oldest records
+//
+//static storage only (zero filled, no constructor runs), T copyable as bytes,
+//N records (power of 2)
+
+//a reader's place in a ring
+struct seq_reader_t {
+    uint32_t    tail;                           //next record
+    uint32_t    lost;                           //records lost since reset
+    uint32_t    lost_sent;                      //lost count reported
+};
+
+template<typename T, uint32_t N> struct SeqRing {
+
+    static_assert(N and not (N & (N - 1)), "ring size not a power of 2");
+
+    using reader_t = seq_reader_t;
+
+    //add a record- fill(T&) sets its fields (inline, the hot path)
+    template<typename F> void put(F fill)
+    {
+        uint32_t pos = m_head.fetch_add(1, std::memory_order_relaxed);
+        slot_t& s = m_ring[pos & (N - 1)];
+        s.seq.store(0, std::memory_order_relaxed);   //being written
+        std::atomic_thread_fence(std::memory_order_release);
+        fill(s.rec);
+        s.seq.store(pos + 1, std::memory_order_release);
+    }
+
+    //start at the oldest record kept
+    void reset(reader_t& r)
+    {
+        uint32_t head = m_head.load(std::memory_order_acquire);
+        r.tail = head > N ? head - N : 0;
+        r.lost = r.lost_sent = 0;
+    }
+
+    //copy the record at the reader's place -> false if none yet (lapped
+    //moves the place first)- the place is kept, next() once it is used
+    bool read(reader_t& r, T& rec)
+    {
+        for(;;){
+            slot_t& s = m_ring[r.tail & (N - 1)];
+            uint32_t seq = s.seq.load(std::memory_order_acquire);
+            rec = s.rec;
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if(seq == r.tail + 1 and s.seq.load(std::memory_order_relaxed) == seq) return true;
+            //not written yet, or lapped
+            uint32_t head = m_head.load(std::memory_order_acquire);
+            if(head - r.tail <= N) return false;
+            r.lost += head - N - r.tail;
+            r.tail = head - N;
+        }
+    }
+
+    void next(reader_t& r){ r.tail++; }
+
+    private:
+
+    //seq = position + 1 once written (0 = being written)
+    using slot_t = struct {
+        std::atomic<uint32_t>   seq;
+        T                       rec;
+    };
+
+    slot_t                  m_ring[N];
+    std::atomic<uint32_t>   m_head;
+
+};
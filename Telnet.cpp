@@ -0,0 +1,299 @@
+#include "Telnet.hpp"
+#include <string.h>
+
+//=====================
+// local functions
+//=====================
+
+//swar- find first byte equal to a or b, a word at a time
+//(a == b to find a single value)
+//-> index of match, or len if none
+static size_t scan(const uint8_t* p, size_t len, uint8_t a, uint8_t b)
+{
+    using word_t = size_t;
+    const word_t ones = ~(word_t)0 / 255;       //0x0101...
+    const word_t highs = ones << 7;             //0x8080...
+    const word_t wa = ones * a;
+    const word_t wb = ones * b;
+    size_t i = 0;
+    //bytes until aligned
+    for(; i < len and ((uintptr_t)&p[i] & (sizeof(word_t) - 1)); i++){
+        if(p[i] == a or p[i] == b) return i;
+    }
+    //whole words, stop at first word with a match
+    for(; i + sizeof(word_t) <= len; i += sizeof(word_t)){
+        word_t w;
+        memcpy(&w, &p[i], sizeof w);            //aligned, compiles to a load
+        word_t xa = w ^ wa;                     //matching bytes now 0
+        word_t xb = w ^ wb;
+        if(((xa - ones) & ~xa & highs) or ((xb - ones) & ~xb & highs)) break;
+    }
+    //remaining bytes (or the word with a match)
+    for(; i < len; i++){
+        if(p[i] == a or p[i] == b) return i;
+    }
+    return len;
+}
+
+//option bit in bitmap (options 0-5, COMPORT uses bit 7, LZ bit 6)
+static uint8_t bit(uint8_t opt)
+{
+    return opt == Telnet::COMPORT ? 0x80 : opt == Telnet::LZ ? 0x40 : opt < 6 ? 1 << opt : 0;
+}
+
+//options we will do, options we want the client to do
+static const uint8_t us_ok = (1 << Telnet::BINARY) | (1 << Telnet::ECHO) | (1 << Telnet::SGA);
+static const uint8_t him_ok = (1 << Telnet::BINARY) | (1 << Telnet::SGA);
+
+//rfc 2217 commands (client -> server, server replies with cmd + 100)
+enum : uint8_t {
+    SET_BAUDRATE = 1, SET_DATASIZE, SET_PARITY, SET_STOPSIZE, SET_CONTROL,
+    NOTIFY_LINESTATE, NOTIFY_MODEMSTATE, FLOWCONTROL_SUSPEND, FLOWCONTROL_RESUME,
+    SET_LINESTATE_MASK, SET_MODEMSTATE_MASK, PURGE_DATA, SERVER = 100
+};
+
+//=====================
+// class functions
+//=====================
+
+//our side- we echo (the target uart does), suppress go-ahead, binary both ways
+//com port control is left to the client to offer
+void Telnet::start(ComPort* cp, bool lz)
+{
+    m_comport = cp;
+    m_lz_ok = lz;
+    m_linemask = m_modemmask = 0;
+    m_linestate = m_modemstate = 0;
+    m_state = DATA;
+    m_us = m_him = 0;
+    m_outlen = m_outpos = 0;
+    queue(WILL, ECHO);
+    queue(WILL, SGA);
+    queue(DO, SGA);
+    queue(WILL, BINARY);
+    queue(DO, BINARY);
+    //requested, so the client reply is taken as an ack (no reply to a reply)
+    m_us_pend = us_ok;
+    m_him_pend = him_ok;
+}
+
+//a reader promoted to writer- its WILL COM-PORT-OPTION was refused at
+//start (no ComPort then), so ask for it now
+void Telnet::attach(ComPort* cp)
+{
+    if(cp == m_comport) return;
+    m_comport = cp;
+    m_linemask = m_modemmask = 0;
+    if(cp and not (m_him & bit(COMPORT)) and queue(DO, COMPORT)) m_him_pend |= bit(COMPORT);
+}
+
+bool Telnet::binary()
+{
+    return (m_us & m_him & bit(BINARY));
+}
+
+bool Telnet::compress()
+{
+    return m_us & bit(LZ);
+}
+
+void Telnet::compress_off()
+{
+    if(not compress()) return;
+    m_us &= ~bit(LZ);
+    queue(WONT, LZ);
+}
+
+//net -> uart, in place (output index never passes input index)
+size_t Telnet::decode(uint8_t* p, size_t len)
+{
+    size_t o = 0;
+    size_t i = 0;
+    while(i < len){
+        if(m_state == DATA){
+            //fast path- plain data up to next IAC (or CR when not binary)
+            size_t n = scan(&p[i], len - i, IAC, binary() ? IAC : '\r');
+            if(n){
+                if(o != i) memmove(&p[o], &p[i], n);
+                o += n;
+                i += n;
+            }
+            if(i == len) break;
+            uint8_t c = p[i++];
+            if(c == IAC){ m_state = CMD; continue; }
+            p[o++] = c;                         //CR
+            m_state = CR;
+            continue;
+        }
+        uint8_t c = p[i++];
+        switch(m_state){
+            case CR:                            //CR NUL -> CR
+                m_state = DATA;
+                if(c) i--;                      //not NUL, process as data
+                break;
+            case CMD:
+                if(c == IAC){ p[o++] = IAC; m_state = DATA; } //escaped 0xFF
+                else if(c >= WILL){ m_cmd = c; m_state = OPT; }
+                else if(c == SB){ m_sblen = 0; m_state = SUB; }
+                else m_state = DATA;            //NOP, GA, etc. ignored
+                break;
+            case OPT:
+                negotiate(m_cmd, c);
+                m_state = DATA;
+                break;
+            case SUB:                           //collect subnegotiation
+                if(c == IAC) m_state = SUBIAC;
+                else if(m_sblen < sizeof(m_sb)) m_sb[m_sblen++] = c;
+                break;
+            case SUBIAC:
+                if(c == SE){ subneg(); m_sblen = 0; m_state = DATA; break; }
+                if(c == IAC and m_sblen < sizeof(m_sb)) m_sb[m_sblen++] = c;
+                m_state = SUB;
+                break;
+            default:
+                break;
+        }
+    }
+    return o;
+}
+
+//uart -> net
+size_t Telnet::plain(const uint8_t* p, size_t len)
+{
+    return scan(p, len, IAC, IAC);
+}
+
+bool Telnet::escape()
+{
+    static const uint8_t iaciac[] = { IAC, IAC };
+    return queue(iaciac, 2);
+}
+
+const uint8_t* Telnet::out(size_t& len)
+{
+    len = m_outlen - m_outpos;
+    return &m_out[m_outpos];
+}
+
+void Telnet::sent(size_t n)
+{
+    m_outpos += n;
+    if(m_outpos >= m_outlen) m_outlen = m_outpos = 0;
+}
+
+//private
+bool Telnet::queue(const uint8_t* p, size_t len)
+{
+    if(m_outlen + len > sizeof(m_out) and m_outpos){    //compact
+        memmove(m_out, &m_out[m_outpos], m_outlen - m_outpos);
+        m_outlen -= m_outpos;
+        m_outpos = 0;
+    }
+    if(m_outlen + len > sizeof(m_out)) return false;
+    memcpy(&m_out[m_outlen], p, len);
+    m_outlen += len;
+    return true;
+}
+
+bool Telnet::queue(uint8_t cmd, uint8_t opt)
+{
+    const uint8_t b[] = { IAC, cmd, opt };
+    return queue(b, 3);
+}
+
+//reply only when our state changes (rfc 854 loop avoidance), a reply to
+//something we requested is an ack (or refusal) and gets no reply
+void Telnet::negotiate(uint8_t cmd, uint8_t opt)
+{
+    uint8_t b = bit(opt);
+    switch(cmd){
+        case DO:                                //client wants us to
+            if(m_us_pend & b){ m_us_pend &= ~b; m_us |= b; }
+            else if(not ((us_ok | (m_lz_ok ? bit(LZ) : 0)) & b)) queue(WONT, opt);
+            else if(not (m_us & b)){ m_us |= b; queue(WILL, opt); }
+            break;
+        case DONT:                              //client wants us not to
+            if(m_us_pend & b) m_us_pend &= ~b;
+            else if(m_us & b){ m_us &= ~b; queue(WONT, opt); }
+            break;
+        case WILL:                              //client offers to
+            if(m_him_pend & b){ m_him_pend &= ~b; m_him |= b; }
+            else if(not ((him_ok | (m_comport ? bit(COMPORT) : 0)) & b)) queue(DONT, opt);
+            else if(not (m_him & b)){ m_him |= b; queue(DO, opt); }
+            break;
+        case WONT:                              //client will not
+            if(m_him_pend & b) m_him_pend &= ~b;
+            else if(m_him & b){ m_him &= ~b; queue(DONT, opt); }
+            break;
+    }
+}
+
+//rfc 2217 subnegotiation- COMPORT cmd value...
+void Telnet::subneg()
+{
+    if(m_sblen < 2 or m_sb[0] != COMPORT) return;
+    if(not m_comport or not (m_him & bit(COMPORT))) return;
+    uint8_t cmd = m_sb[1];
+    uint8_t v = m_sblen > 2 ? m_sb[2] : 0;
+    switch(cmd){
+        case SET_BAUDRATE:
+            if(m_sblen < 6) return;
+            comport(cmd, m_comport->baud((uint32_t)m_sb[2] << 24 | (uint32_t)m_sb[3] << 16 |
+                                         (uint32_t)m_sb[4] << 8 | m_sb[5]), 4);
+            break;
+        case SET_DATASIZE:  comport(cmd, m_comport->datasize(v), 1); break;
+        case SET_PARITY:    comport(cmd, m_comport->parity(v), 1); break;
+        case SET_STOPSIZE:  comport(cmd, m_comport->stopsize(v), 1); break;
+        case SET_CONTROL:   comport(cmd, m_comport->control(v), 1); break;
+        case FLOWCONTROL_SUSPEND:
+        case FLOWCONTROL_RESUME:
+            comport(cmd, 0, 0);
+            break;
+        case SET_LINESTATE_MASK:
+            m_linemask = v;
+            comport(cmd, v, 1);
+            break;
+        case SET_MODEMSTATE_MASK:
+            m_modemmask = v;
+            comport(cmd, v, 1);
+            m_modemstate = ~(m_comport->modemstate() & v); //force a notify
+            break;
+        case PURGE_DATA:
+            m_comport->purge(v);
+            comport(cmd, v, 1);
+            break;
+    }
+}
+
+//queue server reply- IAC SB COMPORT cmd+100 value IAC SE
+//value is big endian, any 0xFF value byte escaped
+void Telnet::comport(uint8_t cmd, uint32_t v, uint8_t n)
+{
+    uint8_t b[16];
+    uint8_t i = 0;
+    b[i++] = IAC; b[i++] = SB; b[i++] = COMPORT; b[i++] = cmd + SERVER;
+    while(n--){
+        uint8_t c = v >> (n * 8);
+        b[i++] = c;
+        if(c == IAC) b[i++] = IAC;
+    }
+    b[i++] = IAC; b[i++] = SE;
+    queue(b, i);
+}
+
+//line/modem state notifications, only bits enabled by the client masks,
+//and only when changed
+void Telnet::notify()
+{
+    if(not m_comport or not (m_him & bit(COMPORT))) return;
+    uint8_t ls = m_comport->linestate() & m_linemask;
+    if(ls != m_linestate){
+        m_linestate = ls;
+        comport(NOTIFY_LINESTATE, ls, 1);
+    }
+    uint8_t ms = m_comport->modemstate() & m_modemmask;
+    if(ms != m_modemstate){
+        m_modemstate = ms;
+        comport(NOTIFY_MODEMSTATE, ms, 1);
+    }
+}
@@ -0,0 +1,96 @@
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+
+//telnet protocol engine (rfc 854) for the serial bridge ports
+//
+//  net -> uart-    decode() strips commands from received data in place,
+//                  unescapes IAC IAC, and drops the NUL of a CR NUL pair
+//                  when not in binary mode
+//  uart -> net-    plain() gives the length of data that can be sent as is,
+//                  then at an IAC byte, escape() queues IAC IAC
+//
+//negotiation replies and escaped IACs are queued in a small output buffer,
+//which must be sent (out()/sent()) before any more stream data
+//
+//the common case has no 0xFF bytes, so both directions scan whole blocks
+//(swar, a word at a time) and only go byte by byte around an IAC
+//
+//rfc 2217 com port control is handled when a ComPort is given (the client
+//offers WILL COM-PORT-OPTION, subnegotiations are passed to the ComPort)
+//
+//compression (when allowed at start) is a private option the client asks
+//for with DO LZ- after our WILL LZ, the stream data we send is Lz.hpp
+//tokens (still IAC escaped), after WONT LZ it is plain again
+
+struct Telnet {
+
+    //telnet commands
+    enum : uint8_t { SE = 240, NOP = 241, SB = 250, WILL = 251, WONT = 252,
+                     DO = 253, DONT = 254, IAC = 255 };
+    //options supported
+    enum : uint8_t { BINARY = 0, ECHO = 1, SGA = 3, COMPORT = 44, LZ = 88 };
+
+    //rfc 2217 com port control, implemented by the owner of the uart
+    //set functions- 0 = query only, -> current value (rfc 2217 encoding)
+    struct ComPort {
+        virtual uint32_t    baud        (uint32_t) = 0;
+        virtual uint8_t     datasize    (uint8_t) = 0;
+        virtual uint8_t     parity      (uint8_t) = 0;
+        virtual uint8_t     stopsize    (uint8_t) = 0;
+        virtual uint8_t     control     (uint8_t) = 0;
+        virtual uint8_t     linestate   () = 0;
+        virtual uint8_t     modemstate  () = 0;
+        virtual void        purge       (uint8_t) = 0;  //1=rx, 2=tx, 3=both
+        virtual ~ComPort    (){}
+    };
+
+    void        start       (ComPort* = nullptr, bool = false); //reset, queue our negotiation, lz allowed
+    void        attach      (ComPort*);         //com port control from now on (asks the client)
+    void        notify      ();                 //com port line/modem state changes
+
+    //net -> uart
+    size_t      decode      (uint8_t*, size_t); //in place, -> data bytes left
+
+    //uart -> net
+    size_t      plain       (const uint8_t*, size_t); //-> bytes before an IAC
+    bool        escape      ();                 //queue IAC IAC (false if no room)
+
+    //protocol output to send before stream data
+    const uint8_t* out      (size_t&);          //-> pending bytes, arg set to len
+    void        sent        (size_t);           //bytes sent from out()
+
+    bool        binary      ();                 //binary mode (both directions)
+    bool        compress    ();                 //we agreed to send LZ
+    void        compress_off();                 //stop sending LZ (queue WONT)
+
+    private:
+
+    using state_t = enum : uint8_t { DATA, CMD, OPT, SUB, SUBIAC, CR };
+
+    void        negotiate   (uint8_t, uint8_t); //cmd, option
+    void        subneg      ();                 //subnegotiation complete
+    void        comport     (uint8_t, uint32_t, uint8_t); //reply cmd, value, bytes
+    bool        queue       (const uint8_t*, size_t);
+    bool        queue       (uint8_t, uint8_t); //IAC cmd option
+
+    state_t     m_state{DATA};
+    uint8_t     m_cmd{0};                       //WILL/WONT/DO/DONT in progress
+    uint8_t     m_us{0};                        //bitmap of options we will do
+    uint8_t     m_him{0};                       //bitmap of options client does
+    uint8_t     m_us_pend{0};                   //requested, waiting for reply
+    uint8_t     m_him_pend{0};
+    ComPort*    m_comport{nullptr};
+    bool        m_lz_ok{false};                 //LZ allowed
+    uint8_t     m_linemask{0};                  //rfc 2217 notify masks
+    uint8_t     m_modemmask{0};
+    uint8_t     m_linestate{0};                 //last notified
+    uint8_t     m_modemstate{0};
+    uint8_t     m_sb[8];                        //subnegotiation data
+    uint8_t     m_sblen{0};
+    uint8_t     m_out[64];                      //protocol output
+    uint8_t     m_outlen{0};
+    uint8_t     m_outpos{0};
+
+};
@@ -1,72 +1,201 @@
 #include "TelnetServer.hpp"
 #include "Commander.hpp"
+#include "BufferedClient.hpp"
 #include "NvsSettings.hpp"
+#include "Trace.hpp"
+#include "EventLog.hpp"
+#include "Reactor.hpp"
+#include "WifiLink.hpp"
+#include "BootTime.hpp"
+#include <lwip/sockets.h>
+#include <errno.h>
 
 //=====================
 // local functions
 //=====================
 
-//print connection info
-//
-//Telnet Server |  uart | s192.168.123.100 | p   23 | c192.168.123.101 | starting
-//
-static void info(const char* nam, const char* msg, int port, IPAddress remip = {0,0,0,0})
+//trace port- binary stream, each client gets the header and all metadata
+//first (see Trace.hpp)
+static uint8_t trace_buf[1024];
+
+//log port- event log as text, the client gets every event still in the
+//ring first, nothing is sent while the telnet output is off (sys log), the
+//events are still read
+static EventLog::reader_t log_reader;
+static void log_reset(){ EventLog::reset(log_reader); }
+static size_t log_fill(uint8_t* p, size_t n)
 {
-    Serial.printf("Telnet Server | %5s | s%15s | p%5d | c%15s | %s\n",
-        nam, WiFi.localIP().toString().c_str(), port, (uint32_t)remip?remip.toString().c_str():"", msg
-    );
+    n = EventLog::format(log_reader, (char*)p, n);
+    return EventLog::outputs() & EventLog::TELNET_OUT ? n : 0;
 }
+static uint8_t log_buf[512];
 
 //=====================
 // class functions
 //=====================
 
+TelnetServer::stream_t TelnetServer::s_trace = {
+    Trace::reset, Trace::encode, trace_buf, sizeof(trace_buf), 0, 0
+};
+TelnetServer::stream_t TelnetServer::s_log = {
+    log_reset, log_fill, log_buf, sizeof(log_buf), 0, 0
+};
+
 TelnetServer::TelnetServer(int port, const char* nam, serve_t typ)
     : m_server(port),
+    m_clients(),
+    m_maxclients(typ >= INFO ? 1 : MAX_CLIENTS),
     m_port(port),
     m_name(nam),
-    m_client_connected(false),
     m_serve_type(typ),
-    m_serial(typ == TelnetServer::SERIAL0 ? Serial :
-             typ == TelnetServer::SERIAL1 ? Serial1 :
-             typ == TelnetServer::SERIAL2 ? Serial2 :
-             Serial) //INFO will set as Serial, unused
+    m_bridge(UartPort::get(typ < INFO ? typ : 0), //INFO/TRACE/LOG unused
+             typ >= INFO ? 0 : UART_RX_RING, //INFO/TRACE/LOG have no rings
+             typ >= INFO ? 0 : UART_TX_RING)
+{
+}
+
+void TelnetServer::chunk(size_t n)
 {
+    m_chunk = n ? n : 1;
 }
 
+void TelnetServer::coalesce(uint16_t size, uint32_t gap, uint32_t hold)
+{
+    m_co_size = size;
+    m_co_gap = gap;
+    m_co_hold = hold;
+}
+
+//readers start looking for a frame at their cursor
+void TelnetServer::packet(Framer::mode_t mode, uint8_t arg)
+{
+    m_framer.set(mode, arg);
+    for(auto& c : m_clients) c.frame = c.cursor;
+}
+
+//the uart is opened when the server starts and left running (so the
+//backlog has what the target printed while nobody was connected), stored
+//settings are applied again when the first client connects and when the
+//last leaves- a baud change is made by the bridge task, rx data is kept
 void TelnetServer::uart_init()
 {
-    //get baud from stored value (other values currently fixed)
-    if(m_serve_type == SERIAL2){
-        NvsSettings settings;
-        m_baud = settings.uart2baud();
+    if(m_serve_type >= INFO) return;
+    uint8_t n = m_serve_type;
+    NvsSettings settings;
+    uint32_t baud = settings.uartbaud(n);
+    m_telnet_on = settings.uarttelnet(n);
+    m_lz_on = settings.uartcompress(n);
+    m_drop = settings.uartdrop(n) ? CLOSE : SKIP;
+    coalesce(settings.uartco_size(n), settings.uartco_gap(n), settings.uartco_hold(n));
+    packet((Framer::mode_t)settings.uartpacket(n), settings.uartpacket_arg(n));
+    backlog(settings.uartbl_size(n), settings.uartbl_wrap(n), settings.uartbl_auto(n));
+    m_bridge.rx_live(m_bridge.rx().size() - kept());
+    UartPort::opts_t o = { settings.uartrx_ring(n), settings.uartrx_full(n), settings.uartrx_idle(n),
+        (UartPort::flow_t)settings.uartflow(n), settings.uartrtspin(n), settings.uartctspin(n) };
+    m_bridge.setup(settings.uartconfig(n), settings.uartrxpin(n), settings.uarttxpin(n),
+        settings.uartinvert(n), o);
+    if(m_bridge.is_open()) m_bridge.baud(baud);
+    else m_bridge.open(baud);
+    if(not m_bridge.is_open()) EventLog::put(EventLog::NO_UART, EventLog::TELNET, m_name, m_port);
+}
+
+//rx ring resized (uart reopened) only with no clients, if there is not
+//enough memory the ring is back to no backlog
+void TelnetServer::backlog(uint32_t size, bool wrap, bool replay)
+{
+    m_bl_wrap = wrap;
+    m_bl_auto = replay;
+    if(size == m_bl_size or clients()) return;
+    m_bl_size = size;
+    bool open = m_bridge.is_open();
+    m_bridge.close();
+    if(not m_bridge.rx().resize(UART_RX_RING + size)){
+        EventLog::put(EventLog::NO_BACKLOG, EventLog::TELNET, m_name, m_port);
+        m_bridge.rx().resize(UART_RX_RING);
+    }
+    if(open) m_bridge.open(m_bridge.baud());
+}
+
+//oldest data kept, sent again from each client cursor (flush_ready sees a
+//full send size pending, so it goes out at once)
+void TelnetServer::replay()
+{
+    for(auto& c : m_clients){
+        if(not c.connected) continue;
+        c.cursor = m_bridge.rx().tail();
+        c.flush_to = c.cursor;
+        c.frame = c.cursor;
+        c.hold_us = 0;
     }
-    m_serial.begin(m_baud, m_config, m_rxpin, m_txpin, m_txrx_invert);
-    //set serial timeout for reads
-    m_serial.setTimeout(0);
 }
 
+bool TelnetServer::capture_start(size_t size){ return m_bridge.capture_start(size); }
+void TelnetServer::capture_stop(){ m_bridge.capture_stop(); }
+Capture& TelnetServer::capture(){ return m_bridge.capture(); }
+
+//rounding the rx ring up to a power of 2 adds to the backlog
+size_t TelnetServer::kept()
+{
+    size_t n = m_bridge.rx().size();
+    return n > UART_RX_RING ? n - UART_RX_RING : 0;
+}
+
+//no delay- uart data is coalesced here (see flush_ready), so nagle would
+//only add latency
 void TelnetServer::start()
 {
-    info(m_name, "starting", m_port);
-    m_server.begin();
+    EventLog::put(EventLog::STARTING, EventLog::TELNET, m_name, m_port);
+    m_server.begin(m_port);
     m_server.setNoDelay(true);
+    if(m_serve_type < INFO) uart_init();
 }
 
 void TelnetServer::stop()
 {
-    info(m_name, "stopping", m_port);
+    EventLog::put(EventLog::STOPPING, EventLog::TELNET, m_name, m_port);
     stop_client();
     m_server.end();
+    m_bridge.close();
+}
+
+void TelnetServer::port(int port)
+{
+    m_port = port;
+}
+
+int TelnetServer::port(){ return m_port; }
+
+bool TelnetServer::running()
+{
+    return m_server;
+}
+
+const char* TelnetServer::name()
+{
+    return m_name;
 }
 
 void TelnetServer::stop_client()
 {
-    if(m_client) m_client.stop();               //stop client if not already
-    if(not m_client_connected) return;          //was previously closed
-    m_client_connected = false;                 //else update and print message
-    info(m_name, "closed", m_port, m_client_ip);
-    handler(STOP);                              //call handler
+    for(auto& c : m_clients) stop_client(c);
+}
+
+void TelnetServer::stop_client(client_t& c)
+{
+    if(c.client) c.client.stop();               //stop client if not already
+    if(not c.connected) return;                 //was previously closed
+    c.connected = false;                        //else update and print message
+    EventLog::put(EventLog::CLOSED, EventLog::TELNET, m_name, m_port, c.ip);
+    handler(STOP, c);                           //call handler
+}
+
+auto TelnetServer::writer() -> client_t* { return m_writer; }
+
+uint8_t TelnetServer::clients()
+{
+    uint8_t n = 0;
+    for(auto& c : m_clients) n += c.connected;
+    return n;
 }
 
 void TelnetServer::status(WiFiClient& client)
@@ -74,63 +203,258 @@ void TelnetServer::status(WiFiClient& client)
     //Telnet Server |  uart2 | s192.168.123.100 | p   23 | c                | waiting
     //Telnet Server |  uart2 | s192.168.123.100 | p   23 | c                | stopped
     //Telnet Server |  uart2 | s192.168.123.100 | p   23 | c192.168.123.101 | connected
-    client.printf("Telnet Server | %5s | s%15s | p%5d | c%15s | %s\n",
+    //Telnet Server |  uart2 | s192.168.123.100 | p   23 | c192.168.123.102 | connected (reader)
+    //Telnet Server |  uart2 | s192.168.123.100 | p   23 | c192.168.123.103 | connected (reader) ws
+    bool none = true;
+    for(auto& c : m_clients){
+        if(not c.connected) continue;
+        none = false;
+        client.printf("Telnet Server | %5s | s%15s | p%5d | c%15s | %s%s\n",
+            m_name,
+            WiFi.localIP().toString().c_str(),
+            m_port,
+            c.ip.toString().c_str(),
+            m_serve_type >= INFO or &c == m_writer ? "connected" : "connected (reader)",
+            c.ws ? " ws" : ""
+        );
+    }
+    if(none){
+        client.printf("Telnet Server | %5s | s%15s | p%5d | c%15s | %s\n",
+            m_name,
+            WiFi.localIP().toString().c_str(),
+            m_port,
+            "",
+            m_server ? "waiting" : "stopped"
+        );
+    }
+    if(m_serve_type == TRACE){
+        client.printf("              | %5s | %u trace points | %u records lost\n",
+            m_name, (unsigned)Trace::points(), (unsigned)Trace::lost()
+        );
+    }
+    if(m_serve_type >= INFO) return;
+    client.printf("              | %5s | backlog %6u bytes | when full %s | replay %s\n",
+        m_name, (unsigned)kept(), m_bl_wrap ? "overwrite oldest" : "stop",
+        m_bl_auto ? "on connect" : "on request"
+    );
+    //rates since last status (tuning coalescing)
+    uint32_t ms = millis() - m_rate_ms;
+    uint32_t pkts = m_stats.tcp_writes - m_rate_packets;
+    uint32_t up = m_stats.uart_to_tcp - m_rate_up;
+    uint32_t down = m_stats.tcp_to_uart - m_rate_down;
+    uint32_t task = m_bridge.task_us() - m_rate_task;
+    m_rate_ms += ms;
+    m_rate_packets = m_stats.tcp_writes;
+    m_rate_up = m_stats.uart_to_tcp;
+    m_rate_down = m_stats.tcp_to_uart;
+    m_rate_task = m_bridge.task_us();
+    if(not ms) ms = 1;
+    //uart task time as 0.1% of a core
+    client.printf("              | %5s | uart->tcp %7u B/s | tcp->uart %7u B/s | uart task %3u.%u%%\n",
+        m_name, (unsigned)(up * 1000ULL / ms), (unsigned)(down * 1000ULL / ms),
+        (unsigned)(task / ms / 10), (unsigned)(task / ms % 10)
+    );
+    client.printf("              | %5s | uart->tcp %6u pkts/s %5u bytes/pkt | coalesce %u/%uus/%uus%s\n",
         m_name,
-        WiFi.localIP().toString().c_str(),
-        m_port,
-        m_client_connected ? m_client_ip.toString().c_str() : "",
-        m_server ? m_client_connected ? "connected" : "waiting" : "stopped"
+        (unsigned)(pkts * 1000ULL / ms),
+        pkts ? (unsigned)(up / pkts) : 0,
+        m_co_size, (unsigned)m_co_gap, (unsigned)m_co_hold,
+        m_co_size and m_co_gap and m_co_hold ? "" : " (0=auto)"
     );
+    if(m_framer.mode() != Framer::NONE){
+        client.printf("              | %5s | packet framing %s,%u\n",
+            m_name, Framer::name(m_framer.mode()), m_framer.arg()
+        );
+    }
+    //ring occupancy/high water (sizing rings for baud rate)
+    client.printf("              | %5s | rx ring %5u/%5u hi %5u | tx ring %5u/%5u hi %5u\n",
+        m_name,
+        (unsigned)m_bridge.rx().used(), (unsigned)m_bridge.rx().size(), (unsigned)m_bridge.rx().high_water(),
+        (unsigned)m_bridge.tx().used(), (unsigned)m_bridge.tx().size(), (unsigned)m_bridge.tx().high_water()
+    );
+}
+
+void TelnetServer::stats(WiFiClient& client)
+{
+    BridgeStats& st = m_stats;
+    client.printf("%s\n", m_name);
+    client.printf("  uart->tcp bytes  %10u    tcp->uart bytes  %10u\n",
+        (unsigned)st.uart_to_tcp, (unsigned)st.tcp_to_uart);
+    client.printf("  tcp writes       %10u    tcp short writes %10u\n",
+        (unsigned)st.tcp_writes, (unsigned)st.tcp_short);
+    client.printf("  tcp socket full  %10u    tcp send errors  %10u\n",
+        (unsigned)st.tcp_full, (unsigned)st.tcp_errors);
+    client.printf("  uart overruns    %10u    rx ring stalls   %10u\n",
+        (unsigned)(m_bridge.overruns() - m_overrun_base), (unsigned)(m_bridge.stalls() - m_stall_base));
+    client.printf("  reader drops     %10u", (unsigned)st.drops);
+    if(m_bridge.flow()){
+        client.printf("    sender holds     %10u", (unsigned)(m_bridge.holds() - m_hold_base));
+    }
+    client.printf("\n");
+    if(st.outage_held){
+        client.printf("  wifi outage held %10u\n", (unsigned)st.outage_held);
+    }
+    if(st.frames or st.frame_held){
+        client.printf("  frames           %10u    frames held part %10u\n",
+            (unsigned)st.frames, (unsigned)st.frame_held);
+    }
+    //compressed sessions- ratio uart bytes : sent bytes, cost per uart KB
+    if(st.lz_in){
+        client.printf("  lz in bytes      %10u    lz out bytes     %10u\n",
+            (unsigned)st.lz_in, (unsigned)st.lz_out);
+        client.printf("  lz ratio     %10u.%02u:1    lz cpu       %10u us/KB\n",
+            (unsigned)(st.lz_in / st.lz_out), (unsigned)(st.lz_in % st.lz_out * 100 / st.lz_out),
+            (unsigned)((uint64_t)st.lz_us * 1024 / st.lz_in));
+    }
+    client.printf("  us between checks min %u max %u\n",
+        st.check_max ? (unsigned)st.check_min : 0, (unsigned)st.check_max);
+    //histogram, only buckets with counts
+    for(auto i = 0; i < BridgeStats::HIST_N; i++){
+        if(not st.check_hist[i]) continue;
+        client.printf("    %s%6uus %10u\n",
+            i == BridgeStats::HIST_N - 1 ? ">=" : " <",
+            i == BridgeStats::HIST_N - 1 ? 1u << i : 2u << i, (unsigned)st.check_hist[i]);
+    }
+}
+
+void TelnetServer::stats_reset()
+{
+    m_stats.reset();
+    m_overrun_base = m_bridge.overruns();
+    m_stall_base = m_bridge.stalls();
+    m_hold_base = m_bridge.holds();
+    m_rate_packets = m_rate_up = m_rate_down = 0;
+    m_rate_task = m_bridge.task_us();
+    m_rate_ms = millis();
+    m_bridge.rx().high_water_reset();
+    m_bridge.tx().high_water_reset();
 }
 
 void TelnetServer::check()
 {
+    //time since the last check (the loop may also sleep in between)
+    uint32_t now = micros();
+    if(m_last_us) m_stats.check_gap(now - m_last_us);
+    m_last_us = now;
+
     //check for new clients, dropped clients
     if(m_server.hasClient()){
-        if(m_client){                           //already have a client
+        client_t* c = free_slot();
+        if(not c){                              //no free client slot
             m_server.available().stop();        //so reject
-            info(m_name, "rejected", m_port);
+            EventLog::put(EventLog::REJECTED, EventLog::TELNET, m_name, m_port);
         } else {                                //can accept new client
-            m_client = m_server.available();
-            if (not m_client){                  //failed for some reason
-                info(m_name, "failed", m_port);
+            c->client = m_server.available();
+            if (not c->client){                 //failed for some reason
+                EventLog::put(EventLog::FAILED, EventLog::TELNET, m_name, m_port);
                 return;                         //failed to connect
             }
-            m_client_connected = true;
-            m_client_ip = m_client.remoteIP();
-            info(m_name, "new client", m_port, m_client_ip);
-            handler(START);                     //call handler
+            c->connected = true;
+            c->ip = c->client.remoteIP();
+            c->ws = false;
+            c->blocked = false;
+            EventLog::put(EventLog::NEW_CLIENT, EventLog::TELNET, m_name, m_port, c->ip);
+            handler(START, *c);                 //call handler
+        }
+    }
+
+    for(auto i = 0; i < m_maxclients; i++){
+        client_t& c = m_clients[i];
+        //check handler if have client
+        if(c.client) handler(CHECK, c);
+        //else no client, so stop if not already done
+        else if(c.connected) stop_client(c);
+    }
+
+    if(m_serve_type < INFO) fanout();
+    arm();
+}
+
+//new clients, client data (the writer only while the tx ring has room, or
+//the socket is not read- the uart drains a quarter of the ring first), a
+//socket to take data held up, data ready but not sent yet (span cap, ring
+//wrap)- coalescing adds its hold/gap time (flush_ready), uart rx data
+//wakes the loop (UartBridge)
+void TelnetServer::arm()
+{
+    if(not m_server) return;
+    Reactor::read(m_server.fd());
+    ByteRing& tx = m_bridge.tx();
+    for(auto& c : m_clients){
+        if(not c.client) continue;
+        int fd = c.client.fd();
+        if(c.blocked) Reactor::write(fd);
+        if(m_serve_type >= INFO){
+            if(c.client.available()) Reactor::due(0); //left in the client buffer
+            else Reactor::read(fd);
+            if(m_serve_type != INFO) Reactor::due(POLL_US);
+            continue;
         }
+        if(&c == m_writer and not tx.space()){
+            Reactor::due(tx.size() / 4 * (10000000 / m_bridge.baud() + 1));
+        } else {
+            Reactor::read(fd);
+        }
+        if(&c == m_writer and m_telnet_on) Reactor::due(POLL_US);
+        if((ptrdiff_t)(c.flush_to - c.cursor) > 0 and not c.blocked) Reactor::due(0);
     }
+}
+
+auto TelnetServer::free_slot() -> client_t*
+{
+    for(auto i = 0; i < m_maxclients; i++){
+        client_t& c = m_clients[i];
+        if(not c.client and not c.connected) return &c;
+    }
+    return nullptr;
+}
 
-    //check handler if have client
-    if(m_client) handler(CHECK);
-    //else no client, so stop if not already done
-    else if(m_client_connected) stop_client();
+//the web server has done the http upgrade, from here the client is served
+//like any other (first client is the writer), only framed as websocket
+bool TelnetServer::attach(WiFiClient& client)
+{
+    if(m_serve_type >= INFO) return false;
+    client_t* c = free_slot();
+    if(not c) return false;
+    c->client = client;
+    c->connected = true;
+    c->ip = client.remoteIP();
+    c->ws = true;
+    c->blocked = false;
+    EventLog::put(EventLog::NEW_WEBSOCKET, EventLog::TELNET, m_name, m_port, c->ip);
+    handler(START, *c);
+    return true;
 }
 
-//if handler called with START/CHECK, m_client must be true
-//if called with STOP, m_client is false, so no using m_client in STOP
-void TelnetServer::handler(msg_t msg)
+//if handler called with START/CHECK, client must be true
+//if called with STOP, client is false, so no using client in STOP
+void TelnetServer::handler(msg_t msg, client_t& c)
 {
-    if(m_serve_type == INFO) handler_info(msg);
-    else handler_uart(msg);
+    if(m_serve_type == INFO) handler_info(msg, c);
+    else if(m_serve_type == TRACE) handler_stream(msg, c, s_trace);
+    else if(m_serve_type == LOG) handler_stream(msg, c, s_log);
+    else handler_uart(msg, c);
 }
 
-void TelnetServer::handler_info(msg_t msg)
+void TelnetServer::handler_info(msg_t msg, client_t& c)
 {
+    WiFiClient& client = c.client;
     switch(msg){
-        case START:
-            m_client.printf("\nConnected to info port %d\n\n", m_port);
-            Commander::process(m_client, String("help"));
-            m_client.printf("$ ");
+        case START: {
+            BufferedClient out(client);         //help in a few segments
+            out.printf("\nConnected to info port %d\n\n", m_port);
+            Commander::help(out);
+            out.printf("$ ");
+            out.push();
             break;
+        }
         case STOP:
             break;
         case CHECK:
-            static String s;
-            static const auto maxlen = 127;
-            size_t len = m_client.available();
+            static char s[128];                 //command line, 0 terminated
+            static size_t slen;
+            static const auto maxlen = sizeof(s) - 1;
+            size_t len = client.available();
             if(len){
                 char c = 0;
                 //read up to len bytes, while less than max cmd size
@@ -138,61 +462,438 @@ void TelnetServer::handler_info(msg_t msg)
                 //CR+LF - ok (Windows type)
                 //LF - ok (Unix type)
                 //CR - ignored (some may use CR only, ignore them)
-                for(; len && s.length() < maxlen; len--){
-                    c = m_client.read(); //get 1 byte
-                    if(c >= ' '){ s += c; continue; } //if a char, add and keep going
+                for(; len && slen < maxlen; len--){
+                    c = client.read(); //get 1 byte
+                    if(c >= ' '){ s[slen++] = c; continue; } //if a char, add and keep going
                     if(c == '\r') continue; //ignore CR
                     if(c == '\n') break; //found command end
                     //special char, not cr/lf
                     //clear string
-                    s = "";
+                    slen = 0;
                 }
+                s[slen] = 0;
                 //check last char- if lf, process
                 if(c == '\n'){
-                    s.trim();
-                    if(s.length()){
-                        Commander::process(m_client, s);
-                        s = "";
+                    BufferedClient out(client); //output and prompt together
+                    if(slen){
+                        Commander::process(out, s); //trims, splits in place
+                        slen = 0;
                     }
-                    m_client.printf("$ ");
+                    out.printf("$ ");
+                    out.push();
                 }
                 //if too many chars
-                if(s.length() >= maxlen){
-                    m_client.printf("\n\ncommand too long :(\n\n$ "); //command buffer overflow
-                    s = "";
+                if(slen >= maxlen){
+                    client.printf("\n\ncommand too long :(\n\n$ "); //command buffer overflow
+                    slen = 0;
                 }
             }
             break;
     }
 }
 
-void TelnetServer::handler_uart(msg_t msg)
+//trace/log port, anything received is ignored- the source fills a buffer
+//that is sent as the socket takes it
+void TelnetServer::handler_stream(msg_t msg, client_t& c, stream_t& st)
 {
     switch(msg){
         case START:
-            uart_init();
+            st.reset();
+            st.pos = st.len = 0;
+            break;
+        case STOP:
             break;
+        case CHECK:
+            for(size_t n = c.client.available(); n; n--) c.client.read();
+            if(st.pos == st.len){
+                st.pos = 0;
+                st.len = st.fill(st.buf, st.size);
+            }
+            if(st.pos < st.len){
+                int n = tcp_send(c, &st.buf[st.pos], st.len - st.pos);
+                if(n > 0) st.pos += n;
+            }
+            break;
+    }
+}
+
+//first client applies the uart settings and is the writer, later clients
+//are readers- a client starts at the newest uart data, or the oldest in the
+//backlog (replay on connect), or after a wifi outage where the last client
+//left off (what no client was sent, in the ring), when the writer leaves the
+//longest connected reader (lowest slot) becomes the writer
+void TelnetServer::handler_uart(msg_t msg, client_t& c)
+{
+    switch(msg){
+        case START: {
+            if(clients() == 1){
+                uart_init();                    //uart already open, rx kept
+                m_writer = &c;
+            }
+            BootTime::mark(BootTime::FIRST_CLIENT);
+            ByteRing& rx = m_bridge.rx();
+            size_t tail = rx.tail();
+            size_t resume = m_resume - tail <= rx.head() - tail ? m_resume : tail;
+            c.cursor = m_bl_auto ? tail : m_outage ? resume : rx.head();
+            m_outage = false;
+            c.flush_to = c.cursor;
+            c.frame = c.cursor;
+            c.hold_us = 0;
+            //queue our negotiation, only the writer gets com port control
+            if(c.ws) c.websocket.start();
+            else if(m_telnet_on) c.telnet.start(&c == m_writer ? &m_bridge : nullptr, m_lz_on);
+            break;
+        }
         case TelnetServer::STOP:
-            m_serial.end();
+            lz(c, false);
+            if(not clients()){
+                m_resume = c.cursor;
+                m_writer = nullptr;
+                uart_init();                    //undo session changes (rfc 2217)
+                break;
+            }
+            if(&c != m_writer) break;
+            m_writer = nullptr;
+            for(auto& w : m_clients){
+                if(w.connected){ m_writer = &w; break; }
+            }
+            //the new writer gets com port control
+            if(m_writer and not m_writer->ws and m_telnet_on) m_writer->telnet.attach(&m_bridge);
             break;
-        case TelnetServer::CHECK:
-            size_t len;
-            uint8_t buf[128];
-            //get data from the telnet client and push it to the UART
-            //m_serial.write is blocking, will complete-
-            //max 5.5ms- 230400baud/128chars, max 11ms 115200baud/128chars
-            len = m_client.available();
+        case TelnetServer::CHECK: {
+            size_t at = c.cursor;
+            pump_net_to_uart(c);
+            pump_uart_to_net(c);
+            if(c.cursor != at) BootTime::mark(BootTime::FIRST_BYTE);
+            break;
+        }
+    }
+}
+
+//tcp -> uart
+//socket data is received directly into the bridge tx ring (bypassing the
+//WiFiClient rx buffer), the bridge task writes it to the uart
+//in telnet mode (or websocket) the received span is decoded in place before
+//commit
+//readers- data is received and decoded (telnet negotiation), then dropped
+void TelnetServer::pump_net_to_uart(client_t& c)
+{
+    uint8_t drop[64];
+    size_t len = sizeof(drop);
+    uint8_t* p = drop;
+    ByteRing& tx = m_bridge.tx();
+    if(&c == m_writer) p = tx.write_span(len);
+    if(len > m_chunk) len = m_chunk;
+    if(not len) return;                         //ring full, try next check
+    int n = recv(c.client.fd(), p, len, MSG_DONTWAIT);
+    if(n == 0){ c.client.stop(); return; }      //peer closed connection
+    if(n < 0) return;
+    if(c.ws) n = c.websocket.decode(p, n);
+    else if(m_telnet_on) n = c.telnet.decode(p, n);
+    if(p == drop) return;
+    bool idle = not tx.used();                  //else the task is already waking for tx
+    tx.commit(n);
+    if(n and idle) m_bridge.kick();
+    m_stats.tcp_to_uart += n;
+}
+
+//uart -> tcp
+//the bridge task fills the rx ring, each client sends from its own cursor
+//directly from the ring, the socket takes what it can (anything not taken
+//stays in the ring for the next check)
+//in telnet mode, pending protocol output goes first, then data is sent
+//directly from the ring up to the next IAC, which is escaped as IAC IAC
+void TelnetServer::pump_uart_to_net(client_t& c)
+{
+    if(not c.client) return;                    //may have closed above
+    if(c.ws){ pump_uart_to_ws(c); return; }
+    if(c.zbuf or (m_telnet_on and c.telnet.compress())){ pump_uart_to_lz(c); return; }
+    size_t len;
+    ByteRing& rx = m_bridge.rx();
+    if(m_telnet_on) c.telnet.notify();          //rfc 2217 line/modem state
+    for(;;){
+        if(m_telnet_on){
+            const uint8_t* o = c.telnet.out(len);
             if(len){
-                if(len > 128) len = 128;
-                m_client.read(buf, len);
-                m_serial.write(buf, len);
+                int n = tcp_send(c, o, len);
+                if(n > 0) c.telnet.sent(n);
+                if(n != (int)len) return;       //socket full
             }
-            //check UART for data, push it out to telnet
-            len = m_serial.readBytes(buf, 128);
-            if(len){
-                m_client.write(buf, len);
+        }
+        uint8_t* p = rx.read_span(c.cursor, len);
+        if(len > m_chunk) len = m_chunk;
+        if(not len or not flush_ready(c)) return;
+        size_t frame = c.flush_to - c.cursor;   //framing- up to frame end
+        if(m_framer.mode() != Framer::NONE and len > frame) len = frame;
+        if(m_framer.mode() != Framer::NONE and len < frame and not m_telnet_on){
+            size_t len2;                        //frame wraps, one write
+            uint8_t* p2 = rx.read_span(c.cursor + len, len2);
+            if(len2 > frame - len) len2 = frame - len;
+            int n = tcp_send(c, p, len, p2, len2);
+            if(n > 0) c.cursor += n;
+            TRACE("uart->tcp", n);
+            return;
+        }
+        if(m_telnet_on){
+            size_t k = c.telnet.plain(p, len);
+            if(k == 0){                         //IAC, escape all in a row
+                for(; k < len and p[k] == Telnet::IAC and c.telnet.escape(); k++);
+                c.cursor += k;
+                if(k) continue;                 //send escapes, then data
+                return;
             }
-            break;
+            len = k;
+        }
+        int n = tcp_send(c, p, len);
+        if(n > 0) c.cursor += n;
+        TRACE("uart->tcp", n);
+        return;
+    }
+}
+
+//compressed telnet session- the client asked for LZ (DO LZ), everything
+//after our WILL LZ is lz tokens, IAC escaped
+//each encode takes up to LZ_CHUNK ring bytes (when coalescing says send)
+//and all its output is sent before anything else, so a WONT LZ (client
+//DONT, or no memory) never splits a token
+void TelnetServer::pump_uart_to_lz(client_t& c)
+{
+    size_t len;
+    ByteRing& rx = m_bridge.rx();
+    c.telnet.notify();
+    for(;;){
+        if(c.zpos < c.zlen){
+            int n = tcp_send(c, &c.zbuf[c.zpos], c.zlen - c.zpos);
+            if(n > 0) c.zpos += n;
+            if(c.zpos < c.zlen) return;         //socket full
+        }
+        if(c.telnet.compress() != c.lz.on()) lz(c, c.telnet.compress());
+        const uint8_t* o = c.telnet.out(len);
+        if(len){
+            int n = tcp_send(c, o, len);
+            if(n > 0) c.telnet.sent(n);
+            if(n != (int)len) return;
+        }
+        if(not c.zbuf){ pump_uart_to_net(c); return; }  //lz ended, plain from here
+        uint8_t* p = rx.read_span(c.cursor, len);
+        if(len > LZ_CHUNK) len = LZ_CHUNK;
+        if(not len or not flush_ready(c)) return;
+        if(m_framer.mode() != Framer::NONE and len > c.flush_to - c.cursor) len = c.flush_to - c.cursor;
+        uint32_t t = micros();
+        uint8_t* z = &c.zbuf[LZ_BUF / 2];
+        size_t zn = c.lz.encode(p, len, z);
+        size_t k = 0;
+        for(size_t i = 0; i < zn; i++){         //escape, write stays behind read
+            c.zbuf[k++] = z[i];
+            if(z[i] == Telnet::IAC) c.zbuf[k++] = Telnet::IAC;
+        }
+        m_stats.lz_us += micros() - t;
+        m_stats.lz_in += len;
+        m_stats.lz_out += k;
+        c.cursor += len;
+        c.zpos = 0;
+        c.zlen = k;
+    }
+}
+
+//start (allocate) or end compression for a client- when there is no memory
+//the option is turned off again (WONT LZ), before any lz data
+void TelnetServer::lz(client_t& c, bool on)
+{
+    if(not on){
+        c.lz.end();
+        free(c.zbuf);
+        c.zbuf = nullptr;
+        c.zpos = c.zlen = 0;
+        return;
     }
+    if(not c.zbuf) c.zbuf = (uint8_t*)malloc(LZ_BUF);
+    if(c.zbuf and c.lz.start()) return;
+    lz(c, false);
+    c.telnet.compress_off();
+    EventLog::put(EventLog::NO_LZ, EventLog::TELNET, m_name, m_port, c.ip);
+}
+
+//uart -> websocket
+//when coalescing says send, a binary frame is started for the data in the
+//ring, its header goes out with the payload in one sendmsg (payload directly
+//from the ring), a partly sent frame is finished before anything else
+//replies (pong/close) go between frames, after a close reply the client is
+//stopped
+void TelnetServer::pump_uart_to_ws(client_t& c)
+{
+    WebSocket& ws = c.websocket;
+    ByteRing& rx = m_bridge.rx();
+    size_t len;
+    for(;;){
+        const uint8_t* o = ws.out(len);
+        if(len){
+            int n = tcp_send(c, o, len);
+            if(n > 0) ws.sent(n);
+            if(n != (int)len) return;           //socket full
+        }
+        if(ws.closed() and not ws.payload()){ c.client.stop(); return; }
+        uint8_t* p = rx.read_span(c.cursor, len);
+        if(not ws.payload()){
+            if(len > m_chunk) len = m_chunk;
+            if(not len or not flush_ready(c)) return;
+            //framing- one message per frame, sent in spans if it wraps
+            ws.frame(m_framer.mode() != Framer::NONE ? c.flush_to - c.cursor : len);
+        }
+        if(len > ws.payload()) len = ws.payload();
+        size_t hlen;
+        const uint8_t* h = ws.head(hlen);
+        int n = tcp_send(c, h, hlen, p, len);
+        if(n <= 0) return;
+        ws.frame_sent(n);
+        c.cursor += n > (int)hlen ? n - hlen : 0;
+        if(n != (int)(hlen + len) or ws.payload()) return; //socket full, or wrapped
+    }
+}
+
+//non-blocking send, socket takes what it can
+int TelnetServer::tcp_send(client_t& c, const uint8_t* p, size_t len)
+{
+    return tcp_sent(c, send(c.client.fd(), p, len, MSG_DONTWAIT), len);
+}
+
+//header + data in one send (either may be 0 length)
+int TelnetServer::tcp_send(client_t& c, const uint8_t* h, size_t hlen, const uint8_t* p, size_t len)
+{
+    iovec iov[2] = { { (void*)h, hlen }, { (void*)p, len } };
+    msghdr msg{};
+    msg.msg_iov = iov;
+    msg.msg_iovlen = 2;
+    return tcp_sent(c, sendmsg(c.client.fd(), &msg, MSG_DONTWAIT), hlen + len);
 }
 
+//send result- counted, blocked (wait for the socket) if not all taken
+int TelnetServer::tcp_sent(client_t& c, int n, size_t len)
+{
+    c.blocked = n < (int)len;
+    if(n < 0){
+        if(errno == EAGAIN or errno == EWOULDBLOCK) m_stats.tcp_full++;
+        else m_stats.tcp_errors++;
+        return n;
+    }
+    if(n < (int)len) m_stats.tcp_short++;
+    if(n > 0){
+        m_stats.tcp_writes++;
+        m_stats.uart_to_tcp += n;
+    }
+    return n;
+}
+
+//uart -> tcp coalescing-
+//once a send is triggered, everything in the ring at that time is sent
+//(flush_to), then new data waits for the next trigger-
+//  size-   pending bytes >= size (auto = one tcp segment)
+//  gap-    uart idle >= gap us (auto = 3 char times, min 250us)- idle is
+//          from the bridge task's last rx read (rx_us), which is each
+//          rx_full fifo bytes while data streams, so a gap under that many
+//          char times also sends at each read
+//  hold-   oldest pending byte waiting >= hold us (auto = 64 char times,
+//          2-20ms)
+//with packet framing on, only whole frames are sent (flush_to = frame end,
+//see Framer)- size is the max frame piece, hold sends a partial frame (auto
+//= 256 char times, 2-20ms- a frame arrives in rx fifo bursts), gap is not
+//used (idle framing has its own gap)
+bool TelnetServer::flush_ready(client_t& c)
+{
+    ByteRing& rx = m_bridge.rx();
+    if((ptrdiff_t)(c.flush_to - c.cursor) > 0) return true; //still sending
+    size_t pending = rx.head() - c.cursor;
+    uint32_t now = micros();
+    //start of hold (0 = none)- now | 1 could be 1us ahead, then now - hold_us
+    //wraps and the hold is over at once
+    if(not c.hold_us) c.hold_us = (now - 1) | 1;
+    uint32_t charus = 10000000 / m_bridge.baud() + 1; //10 bits per char
+    uint32_t size = m_co_size ? m_co_size : 1436;
+    uint32_t gap = m_co_gap ? m_co_gap : charus * 3 < 250 ? 250 : charus * 3;
+    bool framed = m_framer.mode() != Framer::NONE;
+    uint32_t hold = m_co_hold ? m_co_hold : charus * (framed ? 256 : 64);
+    if(not m_co_hold and hold < 2000) hold = 2000;
+    if(not m_co_hold and hold > 20000) hold = 20000;
+    if(framed){
+        uint32_t idle = m_framer.arg() * charus;
+        size_t n = m_framer.next(rx, c.cursor, c.frame, rx.head(), size, now - m_bridge.rx_us() >= idle);
+        if(n) m_stats.frames++;
+        else if(now - c.hold_us >= hold){ n = pending; m_stats.frame_held++; }
+        else {                                  //check again at hold (or idle)
+            uint32_t left = hold - (now - c.hold_us);
+            uint32_t quiet = now - m_bridge.rx_us();
+            if(m_framer.mode() == Framer::IDLE and quiet < idle and idle - quiet < left) left = idle - quiet;
+            Reactor::due(left);
+            return false;
+        }
+        c.flush_to = c.cursor + n;
+        c.hold_us = 0;
+        return true;
+    }
+    if(pending < size and now - m_bridge.rx_us() < gap and now - c.hold_us < hold){
+        uint32_t g = gap - (now - m_bridge.rx_us());
+        uint32_t h = hold - (now - c.hold_us);
+        Reactor::due(g < h ? g : h);            //check again at gap or hold
+        return false;
+    }
+    c.flush_to = rx.head();
+    c.hold_us = 0;
+    return true;
+}
+
+//uart rx ring is shared by all clients, and holds the backlog-
+//when the ring is nearly full, a reader far behind (more than half the live
+//part of the ring past the backlog) gets the drop policy so it cannot hold
+//up the others (the uart task stops reading when full), then the ring tail
+//is moved up to the slowest reader, but keeping the backlog behind it
+//(a reader replaying the backlog is behind by the backlog, which is ok)
+//no clients- the backlog wraps (tail follows head), or stops (the ring
+//fills, newer uart data is dropped)
+//with rx flow control on, a slow reader holds the sender instead (see
+//UartBridge), SKIP is not applied (it loses data), CLOSE still is
+//wifi link down (WifiLink)- no reader is behind by its own doing, so none
+//is dropped (the ring fills, then the uart task stops reading), with no
+//clients the whole ring less half the live part (room for the uart task)
+//is the backlog, and the next client starts at its oldest data- until a
+//client connects or OUTAGE_MS after the link is back
+void TelnetServer::fanout()
+{
+    ByteRing& rx = m_bridge.rx();
+    if(not rx.size()) return;
+    size_t head = rx.head();
+    size_t tail = rx.tail();
+    size_t keep = kept();
+    size_t live = rx.size() - keep;
+    bool down = not WifiLink::up();
+    bool full = rx.space() < live / 4 and not down;
+    size_t slow = head;
+    for(auto& c : m_clients){
+        if(not c.connected) continue;
+        if((ptrdiff_t)(c.cursor - tail) < 0) c.cursor = c.frame = tail; //rx purged
+        if(full and head - c.cursor > keep + live / 2){
+            if(m_drop == CLOSE){
+                EventLog::put(EventLog::SLOW_READER, EventLog::TELNET, m_name, m_port, c.ip);
+                m_stats.drops++;
+                stop_client(c);
+                continue;
+            }
+            if(not m_bridge.flow()){
+                c.cursor = c.frame = head;      //SKIP
+                m_stats.drops++;
+            }
+        }
+        if(c.cursor - tail < slow - tail) slow = c.cursor;
+    }
+    if(down and not clients()) m_outage = true;
+    if(m_outage and not down and WifiLink::up_ms() >= OUTAGE_MS) m_outage = false;
+    if(m_outage) keep = rx.size() - live / 2;
+    if(down){
+        size_t held = head - (clients() ? slow : tail);
+        if(held > m_stats.outage_held) m_stats.outage_held = held;
+    }
+    if(not clients() and not m_bl_wrap) return; //stop
+    size_t used = head - tail;
+    if(head - slow < keep) slow = head - (used < keep ? used : keep);
+    rx.consume_to(slow);
+    m_bridge.rx_freed();
+}
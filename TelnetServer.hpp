@@ -1,10 +1,22 @@
 #pragma once
 #include <WiFi.h>
+#include "UartBridge.hpp"
+#include "Telnet.hpp"
+#include "WebSocket.hpp"
+#include "Lz.hpp"
+#include "Framer.hpp"
+#include "BridgeStats.hpp"
 
 struct TelnetServer {
 
-    //currently only using SERIAL2 and INFO
-    using serve_t = enum { SERIAL0, SERIAL1, SERIAL2, INFO };
+    //SERIALn = uart n bridge (settings for uart n), INFO = console,
+    //TRACE = trace stream (see Trace.hpp), LOG = event log (see EventLog.hpp)-
+    //INFO and up have no uart
+    using serve_t = enum { SERIAL0, SERIAL1, SERIAL2, INFO, TRACE, LOG };
+
+    //reader that falls behind (uart rx ring nearly full)
+    //SKIP = move reader ahead to newest data, CLOSE = disconnect reader
+    using drop_t = enum : uint8_t { SKIP, CLOSE };
 
     //port, name, type
     TelnetServer        (int, const char*, serve_t);
@@ -12,33 +24,159 @@ struct TelnetServer {
     void start          ();
     void stop           ();
     void check          ();
+    void port           (int);              //port for next start
+    int  port           ();
+    bool running        ();                 //started
+    const char* name    ();
     void status         (WiFiClient&);
-    void stop_client    ();
-    void uart_init      ();
+    void stop_client    ();                 //stop all clients
+    void uart_init      ();                 //open uart or apply settings (uart n)
+    void chunk          (size_t);           //max bytes moved per direction per check
+
+    //uart -> tcp coalescing (0 = auto from current baud)
+    //send when pending >= size bytes, or uart idle >= gap us,
+    //or oldest pending byte held >= hold us
+    void coalesce       (uint16_t, uint32_t, uint32_t);
+
+    //uart -> tcp packet framing (see Framer)- mode, arg, one tcp write
+    //(websocket message, lz chunk) per frame, NONE = coalescing only
+    void packet         (Framer::mode_t, uint8_t);
+
+    //uart rx backlog- kept while no client is connected, replayed to a new
+    //client (or on request), size bytes (0 = none), when full with no client
+    //wrap = overwrite oldest, else stop, replay = on connect
+    //(a new size is applied when no clients are connected)
+    void backlog        (uint32_t, bool, bool);
+    void replay         ();                 //clients resend the backlog
+
+    //uart traffic capture (see Capture.hpp)
+    bool capture_start  (size_t);           //buffer size -> false if no memory
+    void capture_stop   ();
+    Capture& capture    ();
+
+    void stats          (WiFiClient&);      //print bridge statistics
+    void stats_reset    ();
+
+    //take over a client already upgraded to a websocket (by WebServer),
+    //-> false if not a serial port or no free client slot
+    bool attach         (WiFiClient&);
+
+    //ring sizes for uart bridge (uart rx -> tcp, tcp -> uart tx)
+    //(rx ring is this + backlog)
+    static const size_t UART_RX_RING = 4096;
+    static const size_t UART_TX_RING = 2048;
+
+    //serial ports fan out uart rx to all clients, first client is the
+    //writer (uart tx), the others only read
+    static const uint8_t MAX_CLIENTS = 4;
+
+    //compressed telnet sessions- uart bytes per encode, output buffer
+    //(encoded, then IAC escaped in place from the back half)
+    static const size_t LZ_CHUNK = 512;
+    static const size_t LZ_BUF = 2 * (LZ_CHUNK + LZ_CHUNK / 128 + 1);
+
+    //rx ring kept for the next client after a wifi outage (see fanout) for
+    //this long once the link is up
+    static const uint32_t OUTAGE_MS = 60000;
+
+    //trace/log output and rfc 2217 line state are polled this often while
+    //a client is connected (nothing wakes the loop for them)
+    static const uint32_t POLL_US = 50000;
 
     private:
 
     using msg_t = enum : uint8_t { START, CHECK, STOP };
-    void handler        (msg_t);
-    void handler_info   (msg_t);
-    void handler_uart   (msg_t);
+
+    using client_t = struct {
+        WiFiClient      client;
+        IPAddress       ip;
+        bool            connected;
+        size_t          cursor;                 //position in uart rx ring
+        size_t          flush_to;               //coalesce- sending up to here
+        uint32_t        hold_us;                //coalesce- micros() data first seen
+        size_t          frame;                  //framing- searched to, or frame end
+        Telnet          telnet;                 //telnet protocol state
+        bool            ws;                     //websocket client (attach)
+        WebSocket       websocket;              //websocket protocol state
+        LzEncoder       lz;                     //compressed telnet session
+        uint8_t*        zbuf;                   //compressed output (lz on)
+        size_t          zpos;                   //sent
+        size_t          zlen;
+        bool            blocked;                //last send short (socket full)
+    };
+
+    //trace/log port source- reset() starts a new stream, fill() adds to the
+    //buffer (-> bytes), which is sent as the socket takes it
+    using stream_t = struct {
+        void            (*reset)();
+        size_t          (*fill)(uint8_t*, size_t);
+        uint8_t*        buf;
+        size_t          size;
+        size_t          pos;                    //sent
+        size_t          len;
+    };
+
+    void handler        (msg_t, client_t&);
+    void handler_info   (msg_t, client_t&);
+    void handler_uart   (msg_t, client_t&);
+    void handler_stream (msg_t, client_t&, stream_t&);
+    void pump_net_to_uart(client_t&);
+    void pump_uart_to_net(client_t&);
+    void pump_uart_to_ws(client_t&);
+    void pump_uart_to_lz(client_t&);
+    void lz             (client_t&, bool);      //start/end compression
+    void fanout         ();                     //drop policy, free read data
+    void arm            ();                     //what the loop waits on (Reactor)
+    bool flush_ready    (client_t&);            //coalesce- ok to send data
+    int  tcp_send       (client_t&, const uint8_t*, size_t);
+    int  tcp_send       (client_t&, const uint8_t*, size_t, const uint8_t*, size_t); //header, data
+    int  tcp_sent       (client_t&, int, size_t);   //send result, bytes offered -> result
+    client_t* free_slot ();                     //-> unused client or nullptr
+    void stop_client    (client_t&);
+    client_t* writer    ();                     //-> writer client or nullptr
+    uint8_t clients     ();                     //-> number connected
+    size_t  kept        ();                     //-> backlog bytes rx ring keeps
 
     WiFiServer          m_server;
-    WiFiClient          m_client;
+    client_t            m_clients[MAX_CLIENTS];
+    uint8_t             m_maxclients;           //INFO, TRACE, LOG = 1
     int                 m_port;
     const char*         m_name;
-    bool                m_client_connected;
-    IPAddress           m_client_ip;
     serve_t             m_serve_type;
-    HardwareSerial&     m_serial;
+    UartBridge          m_bridge;               //uart side (shared task)
+    size_t              m_chunk{UART_RX_RING};  //max span size per transfer
+    bool                m_telnet_on{true};      //false = raw tcp
+    bool                m_lz_on{false};         //telnet clients may ask for lz
+    drop_t              m_drop{SKIP};
+    client_t*           m_writer{nullptr};
 
-    //TODO: add code to be able to change these settings (via info port)
-    //(can currently change baud only- baud is read fron nvs settings when init is run)
-    uint32_t            m_baud{115200};
-    uint32_t            m_config{SERIAL_8N1};   //default mode
-    int8_t              m_rxpin{-1};            //default pin
-    int8_t              m_txpin{-1};            //default pin
-    bool                m_txrx_invert{false};   //default polarity (idle high)
+    //backlog settings
+    uint32_t            m_bl_size{0};
+    bool                m_bl_wrap{true};
+    bool                m_bl_auto{false};
+    bool                m_outage{false};        //rx ring kept since a wifi outage
+    size_t              m_resume{0};            //rx position the last client left at
 
-};
+    //coalescing settings (0 = auto)
+    uint16_t            m_co_size{0};
+    uint32_t            m_co_gap{0};
+    uint32_t            m_co_hold{0};
+
+    Framer              m_framer;               //packet framing (uart -> tcp)
+
+    //statistics
+    BridgeStats         m_stats;
+    uint32_t            m_last_us{0};           //last check() time
+    uint32_t            m_overrun_base{0};      //bridge counts at reset
+    uint32_t            m_stall_base{0};
+    uint32_t            m_hold_base{0};
+    uint32_t            m_rate_ms{0};           //last status- for rates
+    uint32_t            m_rate_packets{0};
+    uint32_t            m_rate_up{0};
+    uint32_t            m_rate_down{0};
+    uint32_t            m_rate_task{0};
 
+    static stream_t     s_trace;                //trace/log port sources
+    static stream_t     s_log;
+
+};
@@ -0,0 +1,125 @@
+#include "Trace.hpp"
+
+//=====================
+// local functions
+//=====================
+
+//trace point metadata, filled once per trace point (any task)
+using meta_t = struct {
+    uint32_t            id;
+    const char*         file;
+    const char*         func;
+    const char*         name;
+    uint16_t            line;
+    std::atomic<bool>   ready;
+};
+static meta_t metas[Trace::META];
+static std::atomic<uint32_t> meta_count{0};
+
+//encoder state (trace server only)
+static bool header_sent;
+static uint32_t meta_sent;
+static seq_reader_t reader;
+
+static uint8_t* put32(uint8_t* p, uint32_t v)
+{
+    for(auto i = 0; i < 4; i++) *p++ = v >> (8 * i);
+    return p;
+}
+
+//file name without the path
+static const char* base(const char* f)
+{
+    const char* s = strrchr(f, '/');
+    return s ? s + 1 : f;
+}
+
+//=====================
+// class functions
+//=====================
+
+SeqRing<Trace::rec_t, Trace::RING> Trace::s_ring;
+
+//a trace point run by two tasks at once may register twice (same id, so
+//the decoder just sees the metadata again), past META the records of new
+//trace points decode without names
+bool Trace::meta(uint32_t id, const char* file, const char* func, uint16_t line, const char* name)
+{
+    uint32_t i = meta_count.fetch_add(1, std::memory_order_relaxed);
+    if(i >= META) return true;
+    meta_t& m = metas[i];
+    m.id = id;
+    m.file = base(file);
+    m.func = func;
+    m.name = name;
+    m.line = line;
+    m.ready.store(true, std::memory_order_release);
+    return true;
+}
+
+uint32_t Trace::lost(){ return reader.lost; }
+
+uint32_t Trace::points()
+{
+    uint32_t n = meta_count;
+    return n < META ? n : META;
+}
+
+//start at the oldest record still in the ring
+void Trace::reset()
+{
+    header_sent = false;
+    meta_sent = 0;
+    s_ring.reset(reader);
+}
+
+//header, then any metadata not sent, then records in ring order, a lost
+//marker before the record that follows records lost
+//a trace point registers before its first record, so metadata that became
+//ready while records are read is sent first (before that record)
+size_t Trace::encode(uint8_t* buf, size_t len)
+{
+    uint8_t* p = buf;
+    uint8_t* end = buf + len;
+    if(not header_sent){
+        if(len < 8) return 0;
+        memcpy(p, "TRC1", 4);
+        p = put32(p + 4, CPU_MHZ);
+        header_sent = true;
+    }
+    for(;;){
+        while(meta_sent < points() and metas[meta_sent].ready.load(std::memory_order_acquire)){
+            meta_t& m = metas[meta_sent];
+            size_t fl = strlen(m.file) + 1;
+            size_t fnl = strlen(m.func) + 1;
+            size_t nl = strlen(m.name) + 1;
+            if(p + 10 + fl + fnl + nl > end) return p - buf;
+            p = put32(p, META_ID);
+            p = put32(p, m.id);
+            *p++ = m.line;
+            *p++ = m.line >> 8;
+            memcpy(p, m.file, fl); p += fl;
+            memcpy(p, m.func, fnl); p += fnl;
+            memcpy(p, m.name, nl); p += nl;
+            meta_sent++;
+        }
+        if(p + REC_SIZE > end) return p - buf;
+        if(reader.lost_sent != reader.lost){
+            p = put32(p, LOST_ID);
+            p = put32(p, 0);
+            p = put32(p, reader.lost - reader.lost_sent);
+            reader.lost_sent = reader.lost;
+            continue;
+        }
+        rec_t r;
+        if(not s_ring.read(reader, r)) return p - buf;
+        if(reader.lost_sent != reader.lost) continue;   //lapped, lost marker first
+        if(meta_sent < points() and metas[meta_sent].ready.load(std::memory_order_acquire)){
+            continue;                           //metadata first, record read again
+        }
+        p = put32(p, r.id);
+        p = put32(p, r.cycles);
+        p = put32(p, r.value);
+        s_ring.next(reader);
+    }
+}
@@ -0,0 +1,89 @@
+#pragma once
+
+#include <Arduino.h>
+#include <atomic>
+#include "SeqRing.hpp"
+
+//compact binary trace points
+//
+//  TRACE("name", value);
+//
+//the trace id is a compile time fnv-1a hash of file, function and name, a
+//trace point stores one fixed size record- id, cycle count, value (32 bits
+//each)- in a lock-free ring, no formatting and no locks (a few tens of
+//cycles), from any task (SeqRing)
+//
+//a trace point registers its metadata (file, function, line, name) the
+//first time it runs, the encoder sends the metadata of every trace point
+//before any of its records
+//
+//the ring is a flight recorder- when the encoder (trace server) falls
+//behind, the oldest records are overwritten and counted as lost
+//
+//stream (little endian)-
+//  header-     "TRC1" cycles per us (u32)
+//  record-     id(u32) cycles(u32) value(u32)
+//  metadata-   id 0, then id(u32) line(u16) file\0 function\0 name\0
+//  lost-       id 1, cycles 0, value = records lost
+//
+//host/tracedec decodes a stream (telnet trace port 2303) to text
+
+#define TRACE(name, value) do { \
+    static constexpr uint32_t trace_id_ = Trace::id(__FILE__, __func__, name); \
+    static bool trace_meta_; \
+    if(not trace_meta_) trace_meta_ = Trace::meta(trace_id_, __FILE__, __func__, __LINE__, name); \
+    Trace::put(trace_id_, (uint32_t)(value)); \
+} while(0)
+
+struct Trace {
+
+    //record ids 0, 1 are the metadata and lost markers
+    enum : uint32_t { META_ID = 0, LOST_ID = 1 };
+
+    static const uint32_t   RING        = 256;  //records (power of 2)
+    static const uint32_t   META        = 64;   //trace points with metadata
+    static const uint32_t   CPU_MHZ     = 240;  //cycle count rate
+    static const size_t     REC_SIZE    = 12;   //record bytes in stream
+
+    //file, function, name -> id (never META_ID/LOST_ID)
+    static constexpr uint32_t id(const char* f, const char* fn, const char* nam)
+    {
+        return fix(fnv(nam, fnv(fn, fnv(f, 2166136261u))));
+    }
+
+    //trace point- register metadata, -> true (once per trace point)
+    static bool meta        (uint32_t, const char*, const char*, uint16_t, const char*);
+
+    //trace point- add a record (inline, the hot path)
+    static void put         (uint32_t id, uint32_t value)
+    {
+        s_ring.put([&](rec_t& r){
+            r.id = id;
+            r.cycles = ESP.getCycleCount();
+            r.value = value;
+        });
+    }
+
+    //encoder (one reader, trace server)
+    static void reset       ();                 //new stream- header, all metadata, oldest record
+    static size_t encode    (uint8_t*, size_t); //fill buffer, -> bytes
+    static uint32_t lost    ();                 //records lost this stream
+    static uint32_t points  ();                 //trace points registered
+
+    private:
+
+    using rec_t = struct {
+        uint32_t                id;
+        uint32_t                cycles;
+        uint32_t                value;
+    };
+
+    static constexpr uint32_t fnv(const char* s, uint32_t h)
+    {
+        return *s ? fnv(s + 1, (h ^ (uint8_t)*s) * 16777619u) : h;
+    }
+    static constexpr uint32_t fix(uint32_t h){ return h > LOST_ID ? h : h + 2; }
+
+    static SeqRing<rec_t, RING>     s_ring;
+
+};
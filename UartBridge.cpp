@@ -0,0 +1,342 @@
+#include "UartBridge.hpp"
+#include "Trace.hpp"
+#include "Reactor.hpp"
+#include "BootTime.hpp"
+
+//=====================
+// local functions
+//=====================
+
+//uart config bits (esp32-hal-uart.h SERIAL_xxx values)
+//  bits 0-1 parity (0=none, 2=even, 3=odd)
+//  bits 2-3 data bits - 5
+//  bits 4-5 stop bits (1=1, 2=1.5, 3=2)
+static const uint32_t CFG_PARITY    = 0x03;
+static const uint32_t CFG_DATA      = 0x0C;
+static const uint32_t CFG_STOP      = 0x30;
+
+//rfc 2217 values
+enum : uint8_t { PAR_NONE = 1, PAR_ODD, PAR_EVEN };
+enum : uint8_t { STOP_1 = 1, STOP_2, STOP_15 };
+enum : uint8_t { FLOW_NONE = 1, FLOW_HW = 3, BREAK_OFF = 6, DTR_OFF = 9, RTS_OFF = 12,
+                 INFLOW_NONE = 14, INFLOW_XON = 15, INFLOW_HW = 16 };
+enum : uint8_t { LS_DATA_READY = 0x01, LS_THRE = 0x20, LS_TSRE = 0x40 };
+enum : uint8_t { MS_CTS = 0x10, MS_DSR = 0x20, MS_CD = 0x80 };
+
+//=====================
+// class functions
+//=====================
+
+UartBridge* UartBridge::s_bridges[MAX_BRIDGES];
+std::atomic<uint8_t> UartBridge::s_count{0};
+TaskHandle_t UartBridge::s_task{nullptr};
+
+UartBridge::UartBridge(UartPort& port, size_t rxn, size_t txn)
+    : m_port(port),
+    m_rx(rxn),
+    m_tx(txn)
+{
+}
+
+ByteRing& UartBridge::rx(){ return m_rx; }
+ByteRing& UartBridge::tx(){ return m_tx; }
+uint32_t UartBridge::baud(){ return m_baud; }
+uint32_t UartBridge::rx_us(){ return m_rx_us; }
+uint32_t UartBridge::overruns(){ return m_port.overruns(); }
+uint32_t UartBridge::stalls(){ return m_stalls; }
+uint32_t UartBridge::holds(){ return m_holds; }
+bool UartBridge::flow(){ return m_opts.flow != UartPort::FLOW_NONE; }
+uint32_t UartBridge::task_us(){ return m_task_us; }
+bool UartBridge::is_open(){ return m_active; }
+Capture& UartBridge::capture(){ return m_capture; }
+void UartBridge::kick(){ UartPort::kick(); }
+
+//network side- after the rx tail moved
+void UartBridge::rx_freed()
+{
+    if(m_held and m_rx.space() >= (m_live ? m_live.load() : m_rx.size()) / FLOW_GO) UartPort::kick();
+}
+
+void UartBridge::rx_live(size_t n){ m_live = n; }
+
+//called from network side (loop)
+void UartBridge::open(uint32_t baud)
+{
+    close();
+    m_baud = baud;
+    m_pend_baud = m_baud;
+    m_pend_config = m_config;
+    m_reconfig = false;
+    m_purge_tx = false;
+    m_held = false;
+    m_xchar = 0;
+    m_rx.clear();                               //task is idle, safe to clear
+    m_tx.clear();
+    if(not m_port.begin(m_baud, m_config, m_rxpin, m_txpin, m_txrx_invert, m_opts)) return;
+    //listed on first open (the task sees the count after the entry),
+    //task created on first open of any bridge, then left running
+    if(not m_listed and s_count < MAX_BRIDGES){
+        s_bridges[s_count] = this;
+        s_count++;
+        m_listed = true;
+    }
+    if(not s_task){
+        xTaskCreatePinnedToCore(task, "uart", TASK_STACK, nullptr, TASK_PRIO, &s_task, TASK_CORE);
+    }
+    m_active = true;
+}
+
+//called from network side (loop)
+void UartBridge::setup(uint32_t cfg, int8_t rxpin, int8_t txpin, bool invert,
+    const UartPort::opts_t& o)
+{
+    if(rxpin != m_rxpin or txpin != m_txpin or invert != m_txrx_invert or
+       o.rx_ring != m_opts.rx_ring or o.rx_full != m_opts.rx_full or o.rx_idle != m_opts.rx_idle or
+       o.flow != m_opts.flow or o.rts != m_opts.rts or o.cts != m_opts.cts){
+        bool was_open = m_active;
+        uint32_t baud = m_pend_baud;
+        close();
+        m_rxpin = rxpin;
+        m_txpin = txpin;
+        m_txrx_invert = invert;
+        m_opts = o;
+        m_config = cfg;
+        if(was_open) open(baud);
+        return;
+    }
+    if(m_active) config(~0u, cfg);
+    else m_config = cfg;
+}
+
+//called from network side (loop)
+//wait for the task to finish any pass in progress before ending the uart
+void UartBridge::close()
+{
+    if(not m_active) return;
+    m_active = false;
+    while(m_busy) vTaskDelay(1);
+    m_port.end();
+}
+
+//called from network side (loop)
+//appends stopped, then wait out a pass in progress before the capture
+//buffer is reset (a later pass sees the capture off until started)- not
+//while a download holds it (-> false, the capture goes on)
+bool UartBridge::capture_start(size_t size)
+{
+    if(m_capture.held()) return false;
+    m_capture.stop();
+    while(m_busy) vTaskDelay(1);
+    return m_capture.start(size, m_pend_baud);
+}
+
+void UartBridge::capture_stop()
+{
+    m_capture.stop();
+}
+
+//task- a pass over the uarts each time UartPort::wait returns
+//a reconfigure first drains the tx fifo over the next passes (see
+//reconfigure), the other bridges go on meanwhile
+void UartBridge::task(void*)
+{
+    uint8_t first = 0;                          //bridge that starts the rounds
+    for(;;){
+        uint8_t n = s_count;
+        for(uint8_t i = 0; i < n; i++){
+            UartBridge* b = s_bridges[i];
+            b->m_busy = true;                   //set busy before checking active
+            if(not b->m_active) continue;
+            if(b->m_reconfig.exchange(false) and not b->m_draining){
+                b->m_draining = true;
+                b->m_drain_ms = millis();
+            }
+            if(b->m_draining) b->reconfigure();
+            if(b->m_purge_tx.exchange(false)) b->m_tx.clear(); //consumer side
+        }
+        if(n and ++first >= n) first = 0;
+        bool moved = true;
+        for(uint8_t r = 0; moved and r < MAX_ROUNDS; r++){
+            moved = false;
+            for(uint8_t i = 0; i < n; i++){
+                UartBridge* b = s_bridges[(first + i) % n];
+                if(not b->m_active) continue;
+                uint32_t t = micros();
+                moved |= b->service(QUANTUM);
+                b->m_task_us.store(b->m_task_us.load(std::memory_order_relaxed) + micros() - t,
+                    std::memory_order_relaxed);
+            }
+        }
+        bool tx_wait = false;                   //tx data the fifo could not take
+        for(uint8_t i = 0; i < n; i++){
+            UartBridge* b = s_bridges[i];
+            tx_wait |= b->m_active and (b->m_tx.used() or b->m_draining);
+            b->m_busy = false;
+        }
+        UartPort::wait(tx_wait ? 1 : IDLE_MS);
+    }
+}
+
+//one round- uart rx -> rx ring, tx ring -> uart tx, up to max bytes each
+//the port takes only what the uart tx fifo can, so never blocks
+bool UartBridge::service(size_t max)
+{
+    size_t len;
+    size_t moved = 0;
+    if(m_opts.flow != UartPort::FLOW_NONE) flow_check();
+    //rx, up to 2 spans (ring may wrap)
+    size_t avail = m_port.available();
+    if(avail > max) avail = max;
+    if(m_held and m_opts.flow == UartPort::FLOW_RTS) avail = 0;  //driver ring fills, rts off
+    for(auto i = 0; i < 2; i++){
+        uint8_t* p = m_rx.write_span(len);
+        if(avail and not len){ m_stalls++; break; }
+        if(len > avail) len = avail;
+        if(not len) break;
+        avail -= len;
+        len = m_port.read(p, len);
+        m_capture.append(Capture::RX, p, len);
+        m_rx.commit(len);
+        moved += len;
+    }
+    if(moved){
+        m_rx_us = micros();                     //for idle gap coalescing
+        Reactor::wake();                        //network side has data to send
+        BootTime::mark(BootTime::FIRST_RX);
+        TRACE("uart rx", moved);
+    }
+    //tx (none while draining for a reconfigure)
+    uint8_t* p = m_tx.read_span(len);
+    if(len > max) len = max;
+    if(m_draining) len = 0;
+    if(len){
+        len = m_port.write(p, len);
+        m_capture.append(Capture::TX, p, len);
+        m_tx.consume(len);
+        moved += len;
+    }
+    return moved;
+}
+
+//task- rx flow control, the XOFF/XON goes straight to the tx fifo (ahead of
+//tx ring data), or next round if the fifo is full
+void UartBridge::flow_check()
+{
+    size_t space = m_rx.space();
+    size_t live = m_live ? m_live.load() : m_rx.size();
+    if(not m_held and space < live / FLOW_STOP){
+        m_held = true;
+        m_holds++;
+        m_xchar = UartPort::XOFF;
+    } else if(m_held and space >= live / FLOW_GO){
+        m_held = false;
+        m_xchar = UartPort::XON;
+    }
+    if(m_opts.flow != UartPort::FLOW_XOFF or not m_xchar) return;
+    if(m_port.write(&m_xchar, 1)){
+        m_capture.append(Capture::TX, &m_xchar, 1);
+        m_xchar = 0;
+    }
+}
+
+//task- apply pending baud/config, called each pass while draining
+//no more tx ring data goes to the fifo, rx is serviced as usual- once the
+//tx fifo is empty, or after DRAIN_MS (cts held off by the peer), rx is read
+//once more (a new framing restarts the driver, its rx ring is lost) and
+//the change applied
+void UartBridge::reconfigure()
+{
+    uint32_t baud = m_pend_baud;
+    uint32_t cfg = m_pend_config;
+    bool change = baud != m_baud or cfg != m_config;
+    if(change and not m_port.tx_done() and millis() - m_drain_ms < DRAIN_MS) return;
+    if(change) service(m_opts.rx_ring);         //still draining, rx only
+    m_draining = false;
+    if(not change) return;
+    if(cfg == m_config) m_port.baud(baud);
+    else if(not m_port.begin(baud, cfg, m_rxpin, m_txpin, m_txrx_invert, m_opts)) m_active = false;
+    m_baud = baud;
+    m_config = cfg;
+}
+
+//network side- update pending config bits, task applies
+void UartBridge::config(uint32_t mask, uint32_t bits)
+{
+    m_pend_config = (m_pend_config & ~mask) | bits;
+    m_reconfig = true;
+    UartPort::kick();
+}
+
+//=====================
+// Telnet::ComPort
+//=====================
+
+uint32_t UartBridge::baud(uint32_t v)
+{
+    if(v){
+        m_pend_baud = v;
+        m_reconfig = true;
+        UartPort::kick();
+    }
+    return m_pend_baud;
+}
+
+uint8_t UartBridge::datasize(uint8_t v)
+{
+    if(v >= 5 and v <= 8) config(CFG_DATA, (v - 5) << 2);
+    return ((m_pend_config & CFG_DATA) >> 2) + 5;
+}
+
+//mark/space not supported (reply is current setting)
+uint8_t UartBridge::parity(uint8_t v)
+{
+    if(v == PAR_NONE) config(CFG_PARITY, 0);
+    if(v == PAR_ODD) config(CFG_PARITY, 3);
+    if(v == PAR_EVEN) config(CFG_PARITY, 2);
+    uint32_t p = m_pend_config & CFG_PARITY;
+    return p == 3 ? PAR_ODD : p == 2 ? PAR_EVEN : PAR_NONE;
+}
+
+uint8_t UartBridge::stopsize(uint8_t v)
+{
+    if(v == STOP_1) config(CFG_STOP, 0x10);
+    if(v == STOP_15) config(CFG_STOP, 0x20);
+    if(v == STOP_2) config(CFG_STOP, 0x30);
+    uint32_t p = m_pend_config & CFG_STOP;
+    return p == 0x30 ? STOP_2 : p == 0x20 ? STOP_15 : STOP_1;
+}
+
+//flow control is set from the info console (uart<n> flow), no break, dtr
+//or manual rts- reply with the actual state for any set or query in each
+//group (outbound flow is cts, inbound rts or xon/xoff as set)
+uint8_t UartBridge::control(uint8_t v)
+{
+    UartPort::flow_t f = m_opts.flow;
+    if(v <= 3) return f == UartPort::FLOW_RTS and m_opts.cts >= 0 ? FLOW_HW : FLOW_NONE;
+    if(v <= 6) return BREAK_OFF;
+    if(v <= 9) return DTR_OFF;
+    if(v <= 12) return RTS_OFF;
+    return f == UartPort::FLOW_RTS ? INFLOW_HW : f == UartPort::FLOW_XOFF ? INFLOW_XON : INFLOW_NONE;
+}
+
+uint8_t UartBridge::linestate()
+{
+    uint8_t ls = 0;
+    if(m_rx.used()) ls |= LS_DATA_READY;
+    if(not m_tx.used()) ls |= LS_THRE | LS_TSRE;
+    return ls;
+}
+
+//no modem lines, report as a connected modem would
+uint8_t UartBridge::modemstate()
+{
+    return MS_CTS | MS_DSR | MS_CD;
+}
+
+//rx ring is consumed on the network side so can clear here, tx ring is
+//cleared by the task
+void UartBridge::purge(uint8_t v)
+{
+    if(v & 1) m_rx.clear();
+    if(v & 2){ m_purge_tx = true; UartPort::kick(); }
+}
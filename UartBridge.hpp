@@ -0,0 +1,145 @@
+#pragma once
+
+#include <Arduino.h>
+#include <atomic>
+#include "UartPort.hpp"
+#include "ByteRing.hpp"
+#include "Telnet.hpp"
+#include "Capture.hpp"
+
+//uart side of a uart<->network bridge
+//
+//one task pinned to the application core services every open bridge, and
+//exchanges data with the network side (TelnetServer, run from loop) only
+//through two spsc rings per bridge, so a uart is never waiting on wifi or
+//the info console
+//
+//  rx ring-    uart rx -> network      (producer = task, consumer = network)
+//  tx ring-    network -> uart tx      (producer = network, consumer = task)
+//
+//rfc 2217 com port changes (Telnet::ComPort) are made from the network side,
+//and applied by the task between passes- the tx fifo is emptied first
+//(tx ring data waits, the other bridges go on, at most DRAIN_MS) and rx
+//drained, ring contents are kept, so no data is lost and the tcp session
+//is not affected
+//
+//a capture (when started) records each rx/tx span the task moves, with its
+//time
+//
+//the task runs each tick in rounds- every bridge moves up to QUANTUM bytes
+//per direction per round, the first bridge of a round rotates each tick,
+//rounds repeat until nothing moves (or MAX_ROUNDS)- so a busy port cannot
+//starve the others, and the time spent on each bridge is kept (task_us)
+//
+//between passes the task sleeps in UartPort::wait- until a uart has rx data
+//(fifo full or rx idle interrupt), the network side kicks it (tx data, a
+//change to apply), or IDLE_MS (1ms while tx data is waiting for the fifo)-
+//rx data moved wakes the main loop (Reactor) so the network side sends it
+//
+//backpressure- network -> uart, the network side only takes from a socket
+//what fits in the tx ring (the tcp window closes), uart -> network, with rx
+//flow control set (UartPort::flow_t) the sender is held while less than
+//1/FLOW_STOP of the live rx ring (not the backlog) is free- XOFF is sent
+//ahead of tx data, or for RTS the uart is not read, so rts goes off once
+//the driver ring fills- and let go at 1/FLOW_GO free (XON, reading again)
+
+struct UartBridge : Telnet::ComPort {
+
+    //uart, rx ring size, tx ring size
+    UartBridge          (UartPort&, size_t, size_t);
+
+    void        open        (uint32_t); //begin uart at baud, start servicing
+    void        close       ();         //stop servicing, end uart
+    bool        is_open     ();         //(false after open if the driver did not start)
+
+    //framing (SERIAL_xxx), rx pin, tx pin (-1 = default), invert, driver
+    //tuning- framing is applied by the task like an rfc 2217 change, a pin,
+    //polarity or tuning change reopens the uart (rings cleared)
+    void        setup       (uint32_t, int8_t, int8_t, bool, const UartPort::opts_t&);
+
+    ByteRing&   rx          ();         //uart rx data, network consumes
+    ByteRing&   tx          ();         //network produces, uart tx data
+    void        kick        ();         //tx data committed, wake the task
+    void        rx_freed    ();         //rx data consumed, wake the task if holding the sender
+    void        rx_live     (size_t);   //rx ring bytes less the backlog (0 = all)
+
+    uint32_t    baud        ();         //current baud
+    uint32_t    rx_us       ();         //micros() of last uart rx data
+    uint32_t    overruns    ();         //uart driver rx fifo/ring overflowed
+    uint32_t    stalls      ();         //rx ring full with uart data waiting
+    uint32_t    holds       ();         //sender held (flow control)
+    bool        flow        ();         //rx flow control on
+    uint32_t    task_us     ();         //task time servicing this bridge
+
+    //capture- buffer size (false if no memory), stop
+    bool        capture_start(size_t);
+    void        capture_stop();
+    Capture&    capture     ();
+
+    //Telnet::ComPort (network side)
+    uint32_t    baud        (uint32_t) override;
+    uint8_t     datasize    (uint8_t) override;
+    uint8_t     parity      (uint8_t) override;
+    uint8_t     stopsize    (uint8_t) override;
+    uint8_t     control     (uint8_t) override;
+    uint8_t     linestate   () override;
+    uint8_t     modemstate  () override;
+    void        purge       (uint8_t) override;
+
+    //task settings
+    static const uint8_t    TASK_CORE   = 1;    //application core
+    static const uint8_t    TASK_PRIO   = 2;    //above loop task (1)
+    static const uint32_t   TASK_STACK  = 3072;
+    static const uint8_t    MAX_BRIDGES = 3;    //uart0-2
+    static const size_t     QUANTUM     = 128;  //bytes per direction per round
+    static const uint8_t    MAX_ROUNDS  = 8;    //per pass
+    static const uint32_t   IDLE_MS     = 10;   //longest sleep
+    static const uint8_t    FLOW_STOP   = 4;    //hold sender at 1/n live rx ring free
+    static const uint8_t    FLOW_GO     = 2;    //let go at 1/n free
+    static const uint32_t   DRAIN_MS    = 1000; //reconfigure- longest wait for the tx fifo
+
+    private:
+
+    static void task    (void*);
+    bool        service (size_t);       //one round, max bytes -> true if any data moved
+    void        reconfigure();          //apply pending baud/config (task)
+    void        flow_check  ();         //hold/let go the sender (task)
+    void        config      (uint32_t, uint32_t); //mask, bits -> pending config
+
+    //bridges the task services (added on first open, never removed)
+    static UartBridge*          s_bridges[MAX_BRIDGES];
+    static std::atomic<uint8_t> s_count;
+    static TaskHandle_t         s_task;
+
+    UartPort&           m_port;
+    ByteRing            m_rx;
+    ByteRing            m_tx;
+    bool                m_listed{false};    //in s_bridges
+    std::atomic<bool>   m_active{false};    //task may use uart
+    std::atomic<bool>   m_busy{false};      //task is using uart
+    std::atomic<bool>   m_reconfig{false};  //pending baud/config to apply
+    std::atomic<bool>   m_purge_tx{false};  //discard tx ring (task)
+    std::atomic<uint32_t> m_pend_baud{115200};
+    std::atomic<uint32_t> m_pend_config{SERIAL_8N1};
+    std::atomic<uint32_t> m_rx_us{0};
+    std::atomic<uint32_t> m_stalls{0};      //counts, written by task only
+    std::atomic<uint32_t> m_holds{0};
+    std::atomic<bool>   m_held{false};      //sender held (task)
+    std::atomic<size_t> m_live{0};
+    uint8_t             m_xchar{0};         //XON/XOFF to send (task)
+    bool                m_draining{false};  //reconfigure- waiting for the tx fifo (task)
+    uint32_t            m_drain_ms{0};      //millis() draining started
+    std::atomic<uint32_t> m_task_us{0};
+    Capture             m_capture;
+
+    //read from nvs settings when opened (setup), baud and framing can be
+    //changed per session via rfc 2217
+    uint32_t            m_baud{115200};
+    uint32_t            m_config{SERIAL_8N1};   //default mode
+    int8_t              m_rxpin{-1};            //default pin
+    int8_t              m_txpin{-1};            //default pin
+    bool                m_txrx_invert{false};   //default polarity (idle high)
+    UartPort::opts_t    m_opts{UartPort::RX_RING_DEF, UartPort::RX_FULL_DEF, UartPort::RX_IDLE_DEF,
+                               UartPort::FLOW_NONE, -1, -1};
+
+};
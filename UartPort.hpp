@@ -0,0 +1,71 @@
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+
+//uart backend of a bridge (UartBridge)- the bridge only moves bytes between
+//its rings and a UartPort, the backend owns the uart (or its stand-in), its
+//buffering and how the bridge task is woken
+//
+//  EspUart-    esp32 build, the esp-idf uart driver- the rx fifo full and
+//              rx idle timeout interrupts move data into the driver rx ring
+//              and post an event, the bridge task waits on the events
+//  PtyUart-    host build (host/stubs), a pty pair paced to the baud rate,
+//              the fifo full/idle timeout points are worked out from the
+//              pacing and the task waits in ppoll()
+//
+//the backend is picked at link time (one of the two is built), get(n) is
+//port n's backend
+//
+//begin/end are called from the network side while the task is not using
+//the port, kick from anywhere, everything else from the bridge task
+
+struct UartPort {
+
+    //rx flow control- the sender is stopped while the bridge cannot take
+    //more (see UartBridge)
+    //  RTS-    rts (and cts, if a pin is set) by the uart- rts goes off when
+    //          the driver ring is full and the fifo reaches FLOW_THRESH
+    //  XOFF-   XOFF/XON sent by the bridge ahead of tx data
+    using flow_t = enum : uint8_t { FLOW_NONE, FLOW_RTS, FLOW_XOFF };
+
+    //driver tuning, per port (nvs uart<n>rx_ring/rx_full/rx_idle/flow/
+    //rtspin/ctspin)
+    struct opts_t {
+        uint16_t    rx_ring;                    //driver rx ring bytes
+        uint8_t     rx_full;                    //rx fifo bytes that raise an interrupt
+        uint8_t     rx_idle;                    //rx idle char times that raise an interrupt
+        flow_t      flow;
+        int8_t      rts;                        //rts pin (FLOW_RTS)
+        int8_t      cts;                        //cts pin (FLOW_RTS, -1 = tx not flow controlled)
+    };
+
+    static const uint16_t   RX_RING_DEF = 512;
+    static const uint8_t    RX_FULL_DEF = 112;  //as esp32-hal-uart
+    static const uint8_t    RX_IDLE_DEF = 2;
+    static const uint8_t    FIFO        = 128;  //hardware fifo bytes (each way)
+    static const uint8_t    FLOW_THRESH = 120;  //rx fifo bytes that turn rts off
+    static const uint8_t    XON         = 0x11;
+    static const uint8_t    XOFF        = 0x13;
+
+    static UartPort& get    (uint8_t);          //port 0-2
+
+    //bridge task- wait for rx data (fifo full/idle timeout) on any begun
+    //port or a kick, or ms
+    static void wait        (uint32_t);
+    //wake wait (tx data queued, change pending)
+    static void kick        ();
+
+    //baud, config (SERIAL_xxx), rx pin, tx pin (-1 = default), invert,
+    //tuning -> false if the driver could not start
+    virtual bool    begin   (uint32_t, uint32_t, int8_t, int8_t, bool, const opts_t&) = 0;
+    virtual void    end     () = 0;
+    virtual void    baud    (uint32_t) = 0; //change baud, framing kept
+
+    virtual size_t  available() = 0;        //rx bytes in the driver
+    virtual size_t  read    (uint8_t*, size_t) = 0;
+    virtual size_t  write   (const uint8_t*, size_t) = 0; //-> bytes taken, never waits
+    virtual bool    tx_done () = 0;         //everything written has gone out
+    virtual uint32_t overruns() = 0;        //rx fifo or ring overflowed (count), ring only without FLOW_RTS
+
+};
@@ -1,110 +1,427 @@
 #include "WebServer.hpp"
 #include "Commander.hpp"
+#include "BufferedClient.hpp"
+#include "WebSocket.hpp"
+#include "EventLog.hpp"
+#include "Reactor.hpp"
+#include <lwip/sockets.h>
+#include <stdarg.h>
 
 //=====================
 // local functions
 //=====================
 
-//print connection info
-//
-//Web Server    |  uart | s192.168.123.100 | p   23 | c192.168.123.101 | starting
-//
-static void info(const char* nam, const char* msg, int port, IPAddress remip = {0,0,0,0})
+//constant strings
+const char* HTTP_OK = "HTTP/1.1 200 OK";
+const char* HTTP_404 = "HTTP/1.1 404 Not Found";
+const char* HTTP_400 = "HTTP/1.1 400 Bad Request";
+const char* HTTP_TXT = "Content-Type: text/plain";
+
+//browser terminal for /uart<n>- websocket to the same path, uart data shown
+//as text, keys sent as typed (enter = CR)
+static const char uart_page[] = R"html(<!DOCTYPE html>
+<html><head><meta charset="utf-8"><title>uart</title>
+<style>body{margin:0;background:#000;color:#ccc}pre{margin:0;padding:4px;white-space:pre-wrap;font:14px monospace}</style>
+</head><body><pre id="t"></pre><script>
+var t=document.getElementById('t'),d=new TextDecoder(),e=new TextEncoder();
+document.title=location.pathname.slice(1);
+var ws=new WebSocket('ws://'+location.host+location.pathname);
+ws.binaryType='arraybuffer';
+ws.onopen=function(){t.textContent+='[connected]\n'};
+ws.onclose=function(){t.textContent+='\n[closed]\n'};
+ws.onmessage=function(m){
+ var s=t.textContent+d.decode(m.data,{stream:true});
+ t.textContent=s.length>65536?s.slice(-49152):s;
+ window.scrollTo(0,document.body.scrollHeight)};
+var keys={Enter:'\r',Backspace:'\x7f',Tab:'\t',Escape:'\x1b',
+ ArrowUp:'\x1b[A',ArrowDown:'\x1b[B',ArrowRight:'\x1b[C',ArrowLeft:'\x1b[D'};
+document.onkeydown=function(k){
+ var s=keys[k.key];
+ if(k.ctrlKey&&k.key.length==1)s=String.fromCharCode(k.key.toUpperCase().charCodeAt(0)&31);
+ else if(!s&&k.key.length==1&&!k.metaKey)s=k.key;
+ if(s&&ws.readyState==1){ws.send(e.encode(s));k.preventDefault()}};
+document.onpaste=function(p){ws.send(e.encode(p.clipboardData.getData('text')))};
+</script></body></html>
+)html";
+
+//url %xx decode, dst size n
+static void url_decode(char* d, const char* s, size_t n)
 {
-    Serial.printf("Web Server    | %5s | s%15s | p%5d | c%15s | %s\n",
-        nam, WiFi.localIP().toString().c_str(), port, (uint32_t)remip?remip.toString().c_str():"", msg
-    );
+    for(; *s and n > 1; n--){
+        if(s[0] == '%' and isxdigit(s[1]) and isxdigit(s[2])){
+            char h[3] = { s[1], s[2], 0 };
+            *d++ = strtol(h, NULL, 16);
+            s += 3;
+            continue;
+        }
+        *d++ = *s++;
+    }
+    *d = 0;
 }
 
-//constant strings
-const char* HTTP_OK = "HTTP/1.1 200 OK";
-const char* HTTP_404 = "HTTP/1.1 404 ";
-const char* HTTP_TXT = "Content-type:text/plain";
+//s contains t, any case
+static bool contains(const char* s, const char* t)
+{
+    size_t n = strlen(t);
+    for(; *s; s++) if(not strncasecmp(s, t, n)) return true;
+    return false;
+}
 
 
 //=====================
 // class functions
 //=====================
 
+//BufferedClient that adds each buffer full to the response as an http chunk
+//(header, data and end of chunk), or as it is when not chunked (http/1.0)
+struct WebServer::Chunked : BufferedClient {
+    Chunked(WebServer& s, conn_t& c) : BufferedClient(c.client), m_s(s), m_c(c) {}
+    void end(){ push(); if(m_c.http11) m_s.put(m_c, "0\r\n\r\n", 5); }
+
+    private:
+    void send(uint8_t* p, size_t n) override {
+        if(not m_c.http11){ m_s.put(m_c, p, n); return; }
+        char h[HEAD + 1];
+        int k = snprintf(h, sizeof(h), "%x\r\n", (unsigned)n);
+        memcpy(p - k, h, k);
+        memcpy(p + n, "\r\n", 2);
+        m_s.put(m_c, p - k, k + n + 2);
+    }
+    WebServer& m_s;
+    conn_t& m_c;
+};
+
 void WebServer::start()
 {
-    info(m_name, "starting", m_port);
+    EventLog::put(EventLog::STARTING, EventLog::WEB, m_name, m_port);
     m_server.begin();
     m_server.setNoDelay(true);
 }
 
 void WebServer::stop()
 {
-    info(m_name, "stopping", m_port);
+    EventLog::put(EventLog::STOPPING, EventLog::WEB, m_name, m_port);
+    for(auto& c : m_conns) if(c.connected) close(c, EventLog::CLOSED);
     m_server.end();
 }
 
+//new connections, then each connection parses what has arrived (up to
+//READ_MAX bytes) and answers at most one request (a large response body
+//is sent first, as the socket takes it)
 void WebServer::check()
 {
-  WiFiClient client = m_server.available(); //incoming clients
-
-  if (client) {                             //there is a client
-    info(m_name, "new client", m_port, client.remoteIP());
-    String currentLine = "";                //store each line
-    String cmd = "help";                    //default command
-    while (client.connected()) {
-      if (client.available()) {             //if client bytes available
-        char c = client.read();             //read byte
-        if(c == '\r') continue;             //ignore CR
-        if(c != '\n'){                      //save char unless LF
-            currentLine += c;
-            continue;                       //next
+    accept();
+    for(auto& c : m_conns){
+        if(not c.connected) continue;
+        if(not c.client.connected()){ close(c, EventLog::CLOSED); continue; }
+        if(sending(c) and not send_more(c)) continue;
+        size_t n = c.client.available();
+        if(not n){
+            if(millis() - c.last_ms >= IDLE_MS) close(c, EventLog::IDLE);
+            continue;
         }
-
-        //is LF- DONE with line
-
-        //Serial.printf(">> %s\n", currentLine.c_str());
-
-        //first LF, check the line
-        if(currentLine.length()){
-            // Check to see if the client request was GET /'something here'
-            if(currentLine.startsWith("GET /'")){
-                currentLine.replace("GET /'", "");
-                currentLine.replace("%20"," ");
-                auto i = currentLine.indexOf("'");
-                if(i>=0){
-                    cmd = currentLine.substring(0, i);
-                    cmd.trim();
-                    Serial.printf("Web server command received: %s\n", cmd.c_str());
-                }
-            }
-            else if (currentLine.startsWith("GET /favicon.ico")){
-                cmd = "favicon";
-            }
-            currentLine = ""; //done checking line, clear string for next line
-        }
-        //second LF, end of HTTP request
-        else {
-            //this should stop all icon requests after the first time
-            if(cmd == "favicon"){
-                client.println(HTTP_404);
-                client.println();
-                break;
-            }
-
-            client.println(HTTP_OK);                    //header
-            client.println(HTTP_TXT);                   //content type
-            client.println();                           //separator
-
-            //now let commander process the command (prints directly to client)
-            Commander::process(client, cmd);            //default is "help"
-            if(cmd == "help"){                          //add additional info for help
-                client.println("\n\nappend command to address in single quotes-");
-                client.println("http://192.168.4.1/'wifi list'");
-                client.println("\n(or use telnet command interface via port 2300)");
-            }
-            client.println();
+        c.last_ms = millis();
+        if(n > READ_MAX) n = READ_MAX;
+        for(; n; n--){
+            if(not parse(c, c.client.read())) continue;
+            respond(c);
             break;
         }
-      }
     }
-    client.stop();
-    info(m_name, "closed", m_port);
-  }
+    arm();
+}
+
+//what the loop waits on (Reactor)- new connections, request data (or data
+//already in the client buffer, READ_MAX a check), a socket to take more of
+//a response body, the idle/stalled close time
+void WebServer::arm()
+{
+    if(not m_server) return;
+    Reactor::read(m_server.fd());
+    for(auto& c : m_conns){
+        if(not c.connected) continue;
+        int fd = c.client.fd();
+        if(sending(c)) Reactor::write(fd);
+        else if(c.client.available()) Reactor::due(0);
+        else Reactor::read(fd);
+        uint32_t idle = millis() - c.last_ms;
+        Reactor::due(idle < IDLE_MS ? (IDLE_MS - idle) * 1000 : 0);
+    }
+}
+
+void WebServer::accept()
+{
+    if(not m_server.hasClient()) return;
+    for(auto& c : m_conns){
+        if(c.connected) continue;
+        c.client = m_server.available();
+        if(not c.client){
+            EventLog::put(EventLog::FAILED, EventLog::WEB, m_name, m_port);
+            return;
+        }
+        c.connected = true;
+        c.ip = c.client.remoteIP();
+        c.state = REQUEST;
+        c.len = 0;
+        c.outlen = c.outpos = 0;
+        c.txlen = 0;
+        c.last_ms = millis();
+        EventLog::put(EventLog::NEW_CLIENT, EventLog::WEB, m_name, m_port, c.ip);
+        return;
+    }
+    m_server.available().stop();                //no free slot, so reject
+    EventLog::put(EventLog::REJECTED, EventLog::WEB, m_name, m_port);
+}
+
+void WebServer::close(conn_t& c, EventLog::event_t why)
+{
+    sent(c);
+    c.client.stop();
+    c.connected = false;
+    EventLog::put(why, EventLog::WEB, m_name, m_port, c.ip);
+}
+
+//one byte at a time- lines are collected (CR ignored), a request is
+//request line, headers, blank line, body (skipped)
+//-> true when a whole request has been received
+bool WebServer::parse(conn_t& c, char ch)
+{
+    if(c.state == BODY){
+        if(--c.body) return false;
+        c.state = REQUEST;
+        return true;
+    }
+    if(ch == '\r') return false;
+    if(ch != '\n'){
+        if(c.len < sizeof(c.line) - 1) c.line[c.len++] = ch; //too long is truncated
+        return false;
+    }
+    c.line[c.len] = 0;
+    c.len = 0;
+    if(c.state == REQUEST){
+        if(c.line[0]) request(c);               //blank lines before request ignored
+        return false;
+    }
+    if(c.line[0]){ header(c); return false; }
+    //blank line, end of headers
+    if(c.body){ c.state = BODY; return false; }
+    c.state = REQUEST;
+    return true;
+}
+
+//"GET /'wifi list' HTTP/1.1" - command is in single quotes (url encoded),
+//anything else is help (favicon gets a 404, /uart<n> see uart(), a uart
+//not running also gets a 404)
+void WebServer::request(conn_t& c)
+{
+    c.state = HEADERS;
+    c.body = 0;
+    char* target = strchr(c.line, ' ');
+    char* version = target ? strchr(target + 1, ' ') : NULL;
+    if(version) *version++ = 0;
+    c.http11 = version and not strcmp(version, "HTTP/1.1");
+    c.keep = c.http11;                          //1.1 default is keep-alive
+    c.upgrade = false;
+    c.key[0] = 0;
+    c.route = CMD;
+    strcpy(c.cmd, "help");
+    if(not target) return;
+    target++;
+    if(not strcmp(target, "/favicon.ico")){ c.route = FAVICON; return; }
+    if(not strncmp(target, "/uart", 5) and isdigit(target[5])){
+        c.uart = Bridges::get(target[5] - '0');
+        if(not target[6]) c.route = UART;
+        else if(not strcmp(&target[6], "/capture")) c.route = CAPTURE;
+        else c.route = FAVICON;
+        if(not c.uart) c.route = FAVICON;
+        return;
+    }
+    char url[CMD_LEN];
+    url_decode(url, target, sizeof(url));
+    if(strncmp(url, "/'", 2)) return;
+    char* end = strchr(url + 2, '\'');
+    if(not end) return;
+    *end = 0;
+    snprintf(c.cmd, sizeof(c.cmd), "%s", url + 2);
+    EventLog::put(EventLog::COMMAND, EventLog::WEB, m_name, m_port, c.ip, c.cmd);
 }
 
+//only Connection and Content-Length matter (and the websocket upgrade)- a
+//length that is not a number, or over BODY_MAX, is a bad request (no body
+//is skipped, the connection is closed after the reply)
+void WebServer::header(conn_t& c)
+{
+    if(not strncasecmp(c.line, "Connection:", 11)){
+        if(contains(c.line, "close")) c.keep = false;
+        if(contains(c.line, "keep-alive")) c.keep = true;
+    }
+    else if(not strncasecmp(c.line, "Content-Length:", 15)){
+        const char* v = c.line + 15;
+        while(*v == ' ') v++;
+        char* end;
+        unsigned long n = isdigit(*v) ? strtoul(v, &end, 10) : 0;
+        if(not isdigit(*v) or *end or n > BODY_MAX) c.route = BAD;
+        else c.body = n;
+    }
+    else if(not strncasecmp(c.line, "Upgrade:", 8)){
+        c.upgrade = contains(c.line, "websocket");
+    }
+    else if(not strncasecmp(c.line, "Sec-WebSocket-Key:", 18)){
+        const char* k = c.line + 18;
+        while(*k == ' ') k++;
+        snprintf(c.key, sizeof(c.key), "%s", k);
+    }
+}
+
+//Commander prints into the response buffer- chunked for http/1.1, for
+//http/1.0 the response ends when the connection is closed
+void WebServer::respond(conn_t& c)
+{
+    if(not c.http11) c.keep = false;
+    if(c.route == BAD) c.keep = false;
+    const char* conn = c.keep ? "keep-alive" : "close";
+    if(c.route == UART){ uart(c); return; }
+    if(c.route == CAPTURE){ capture(c); return; }
+    if(c.route == FAVICON or c.route == BAD){
+        putf(c, "%s\r\nContent-Length: 0\r\nConnection: %s\r\n\r\n",
+            c.route == BAD ? HTTP_400 : HTTP_404, conn);
+        send_more(c);
+        return;
+    }
+    bool help = not strcmp(c.cmd, "help");
+    putf(c, "%s\r\n%s\r\n%sConnection: %s\r\n\r\n",
+        HTTP_OK, HTTP_TXT, c.http11 ? "Transfer-Encoding: chunked\r\n" : "", conn
+    );
+    Chunked out(*this, c);
+    Commander::process(out, c.cmd);             //buffered, a chunk per buffer full
+    if(help){                                   //add additional info for help
+        out.println("\n\nappend command to address in single quotes-");
+        out.println("http://192.168.4.1/'wifi list'");
+        out.println("\n(or use telnet command interface via port 2300)");
+    }
+    out.println();
+    out.end();
+    send_more(c);
+}
+
+//no upgrade- the terminal page
+//upgrade- the uart server takes the client (if it has a free slot), then
+//the 101 reply, from here this connection is the uart server's (the slot is
+//released without closing the socket)- the reply is the first thing on the
+//socket since this request (a request is read only when nothing is left to
+//send), so the socket takes it whole, if not the connection is closed
+void WebServer::uart(conn_t& c)
+{
+    WiFiClient& client = c.client;
+    if(not c.upgrade or not c.key[0]){
+        putf(c, "%s\r\nContent-Type: text/html\r\nContent-Length: %u\r\nConnection: %s\r\n\r\n",
+            HTTP_OK, (unsigned)(sizeof(uart_page) - 1), c.keep ? "keep-alive" : "close"
+        );
+        c.tx = (const uint8_t*)uart_page;
+        c.txlen = sizeof(uart_page) - 1;
+        send_more(c);
+        return;
+    }
+    if(not c.uart->attach(client)){
+        c.keep = false;
+        putf(c, "HTTP/1.1 503 Service Unavailable\r\nContent-Length: 0\r\nConnection: close\r\n\r\n");
+        send_more(c);
+        EventLog::put(EventLog::UART_BUSY, EventLog::WEB, m_name, m_port, c.ip);
+        return;
+    }
+    char accept[29];
+    char r[160];
+    WebSocket::accept(c.key, accept);
+    int n = snprintf(r, sizeof(r), "HTTP/1.1 101 Switching Protocols\r\nUpgrade: websocket\r\n"
+        "Connection: Upgrade\r\nSec-WebSocket-Accept: %s\r\n\r\n", accept
+    );
+    if(send(client.fd(), r, n, MSG_DONTWAIT) != n) client.stop(); //uart server sees it closed
+    c.client = WiFiClient();
+    c.connected = false;
+    EventLog::put(EventLog::WEBSOCKET, EventLog::WEB, m_name, m_port, c.ip);
+}
+
+//capture so far as a file (records are only appended, so the length at
+//this time is a complete capture), sent by send_more- the capture is held
+//until sent (no new capture can reset or free the buffer)
+void WebServer::capture(conn_t& c)
+{
+    size_t len;
+    c.cap = &c.uart->capture();
+    c.cap->hold();
+    const uint8_t* p = c.cap->data(len);
+    putf(c, "%s\r\nContent-Type: application/octet-stream\r\n"
+        "Content-Disposition: attachment; filename=\"%s.cap\"\r\n"
+        "Content-Length: %u\r\nConnection: %s\r\n\r\n",
+        HTTP_OK, c.uart->name(), (unsigned)len, c.keep ? "keep-alive" : "close"
+    );
+    c.tx = p;
+    c.txlen = len;
+    send_more(c);
+}
+
+//response buffer, then body- non-blocking, in one write (socket takes
+//what it can)
+//-> true when done (connection closed if not keep-alive)
+bool WebServer::send_more(conn_t& c)
+{
+    iovec iov[2] = { { &c.out[c.outpos], c.outlen - c.outpos }, { (void*)c.tx, c.txlen } };
+    msghdr msg{};
+    msg.msg_iov = iov;
+    msg.msg_iovlen = 2;
+    int n = sendmsg(c.client.fd(), &msg, MSG_DONTWAIT);
+    if(n > 0){
+        size_t h = c.outlen - c.outpos < (size_t)n ? c.outlen - c.outpos : n;
+        c.outpos += h;
+        c.tx += n - h;
+        c.txlen -= n - h;
+        c.last_ms = millis();
+    }
+    if(sending(c)){
+        if(millis() - c.last_ms >= IDLE_MS) close(c, EventLog::STALLED);
+        return false;
+    }
+    sent(c);
+    if(not c.keep) close(c, EventLog::CLOSED);
+    return c.connected;
+}
+
+bool WebServer::sending(conn_t& c){ return c.outpos < c.outlen or c.txlen; }
+
+//response done (or connection closed)- buffer freed, capture let go
+void WebServer::sent(conn_t& c)
+{
+    if(c.cap) c.cap->release();
+    c.cap = nullptr;
+    free(c.out);
+    c.out = nullptr;
+    c.outsize = c.outlen = c.outpos = 0;
+    c.txlen = 0;
+}
+
+//add to the response, all or nothing- when it does not fit (OUT_MAX, or
+//no memory) the response is cut short and the connection closed after it
+bool WebServer::put(conn_t& c, const void* p, size_t n)
+{
+    if(c.outlen + n > c.outsize){
+        size_t size = c.outsize ? c.outsize : OUT_MIN;
+        while(size < c.outlen + n) size *= 2;
+        uint8_t* b = size <= OUT_MAX ? (uint8_t*)realloc(c.out, size) : nullptr;
+        if(not b){ c.keep = false; return false; }
+        c.out = b;
+        c.outsize = size;
+    }
+    memcpy(&c.out[c.outlen], p, n);
+    c.outlen += n;
+    return true;
+}
+
+void WebServer::putf(conn_t& c, const char* fmt, ...)
+{
+    char s[LINE_LEN];
+    va_list a;
+    va_start(a, fmt);
+    int n = vsnprintf(s, sizeof(s), fmt, a);
+    va_end(a);
+    if(n > 0) put(c, s, n < (int)sizeof(s) ? n : sizeof(s) - 1);
+}
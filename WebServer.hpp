@@ -1,20 +1,93 @@
 #pragma once
 
 #include <WiFi.h>
+#include "Bridges.hpp"
+#include "EventLog.hpp"
+
+//http server for console commands- http://192.168.4.1/'wifi list'
+//several connections, each parsed a little per check() (never waits on a
+//client), keep-alive, chunked responses
+//
+//a response is made in one go into a buffer of its connection (up to
+//OUT_MAX, allocated for the response), then sent a little per check as the
+//socket takes it- a slow client holds up only its own connection
+//
+//for each running uart bridge (Bridges), /uart<n> is a browser terminal
+//page, its websocket upgrade on /uart<n> is handed over to the bridge (same
+//stream as the telnet port), /uart<n>/capture downloads its capture (sent a
+//little per check)
 
 struct WebServer : public WiFiServer {
 
+    //port, name
     WebServer(uint16_t port, const char* name)
-    : m_port(port), m_server(port, 1), m_name(name)
+    : m_server(port, MAX_CLIENTS), m_port(port), m_name(name)
     {}
 
     void            start();
     void            check();
     void            stop();
+    uint16_t        port(){ return m_port; }
+
+    static const int MAX_CLIENTS = 4;
+    static const size_t LINE_LEN = 256;         //request/header line
+    static const size_t CMD_LEN = 128;          //command from the url
+    static const size_t READ_MAX = 512;         //bytes parsed per client per check
+    static const size_t OUT_MIN = 2048;         //response buffer, first allocation
+    static const size_t OUT_MAX = 16384;        //response buffer max (then cut short)
+    static const uint32_t BODY_MAX = 8192;      //request body (skipped) max
+    static const uint32_t IDLE_MS = 5000;       //close idle/stalled connection
 
     private:
 
+    enum state_t { REQUEST, HEADERS, BODY };
+    enum route_t { CMD, FAVICON, UART, CAPTURE, BAD };
+
+    //per connection, all fixed buffers
+    using conn_t = struct {
+        WiFiClient  client;
+        IPAddress   ip;
+        bool        connected;
+        state_t     state;
+        char        line[LINE_LEN];
+        size_t      len;
+        uint32_t    body;                   //request body bytes to skip
+        bool        http11;
+        bool        keep;                   //keep-alive after response
+        uint32_t    last_ms;                //last activity
+        route_t     route;
+        TelnetServer* uart;                 //UART/CAPTURE bridge
+        char        cmd[CMD_LEN];
+        bool        upgrade;                //Upgrade: websocket
+        char        key[32];                //Sec-WebSocket-Key
+        uint8_t*    out;                    //response being sent (malloc)
+        size_t      outsize;
+        size_t      outlen;
+        size_t      outpos;                 //sent
+        const uint8_t* tx;                  //then this body (page, capture)
+        size_t      txlen;
+        Capture*    cap;                    //capture held while tx is sent from it
+    };
+
+    struct Chunked;                         //response body writer
+
+    void            accept();
+    bool            parse(conn_t&, char);
+    void            request(conn_t&);
+    void            header(conn_t&);
+    void            respond(conn_t&);
+    void            uart(conn_t&);
+    void            capture(conn_t&);
+    bool            send_more(conn_t&);
+    bool            sending(conn_t&);
+    void            sent    (conn_t&);
+    bool            put     (conn_t&, const void*, size_t);
+    void            putf    (conn_t&, const char*, ...) __attribute__((format(printf, 3, 4)));
+    void            arm();
+    void            close(conn_t&, EventLog::event_t);
+
     WiFiServer      m_server;
     uint16_t        m_port;
     const char*     m_name;
+    conn_t          m_conns[MAX_CLIENTS]{};
 };
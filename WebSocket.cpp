@@ -0,0 +1,244 @@
+#include "WebSocket.hpp"
+#include <string.h>
+
+//=====================
+// local functions
+//=====================
+
+static uint32_t rol(uint32_t v, int n) { return v << n | v >> (32 - n); }
+
+//sha-1 of a short message (handshake only, so one call, no streaming)
+static void sha1(const uint8_t* msg, size_t len, uint8_t* digest)
+{
+    uint32_t h[5] = { 0x67452301, 0xEFCDAB89, 0x98BADCFE, 0x10325476, 0xC3D2E1F0 };
+    uint64_t bits = (uint64_t)len * 8;
+    size_t total = (len + 8) / 64 * 64 + 64;    //msg + 0x80 + length, padded
+    for(size_t blk = 0; blk < total; blk += 64){
+        uint8_t b[64];
+        for(size_t i = 0; i < 64; i++){
+            size_t j = blk + i;
+            b[i] = j < len ? msg[j] : j == len ? 0x80 :
+                   j >= total - 8 ? (uint8_t)(bits >> (8 * (total - 1 - j))) : 0;
+        }
+        uint32_t w[80];
+        for(int i = 0; i < 16; i++){
+            w[i] = (uint32_t)b[i*4] << 24 | b[i*4+1] << 16 | b[i*4+2] << 8 | b[i*4+3];
+        }
+        for(int i = 16; i < 80; i++) w[i] = rol(w[i-3] ^ w[i-8] ^ w[i-14] ^ w[i-16], 1);
+        uint32_t a = h[0], bb = h[1], c = h[2], d = h[3], e = h[4];
+        for(int i = 0; i < 80; i++){
+            uint32_t f, k;
+            if(i < 20){ f = (bb & c) | (~bb & d); k = 0x5A827999; }
+            else if(i < 40){ f = bb ^ c ^ d; k = 0x6ED9EBA1; }
+            else if(i < 60){ f = (bb & c) | (bb & d) | (c & d); k = 0x8F1BBCDC; }
+            else { f = bb ^ c ^ d; k = 0xCA62C1D6; }
+            uint32_t t = rol(a, 5) + f + e + k + w[i];
+            e = d; d = c; c = rol(bb, 30); bb = a; a = t;
+        }
+        h[0] += a; h[1] += bb; h[2] += c; h[3] += d; h[4] += e;
+    }
+    for(int i = 0; i < 20; i++) digest[i] = h[i/4] >> (24 - 8 * (i % 4));
+}
+
+//base64, 0 terminated (out needs (len+2)/3*4 + 1)
+static void base64(const uint8_t* p, size_t len, char* out)
+{
+    static const char tbl[] =
+        "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+    for(size_t i = 0; i < len; i += 3){
+        uint32_t v = p[i] << 16 | (i + 1 < len ? p[i+1] << 8 : 0) | (i + 2 < len ? p[i+2] : 0);
+        *out++ = tbl[v >> 18 & 63];
+        *out++ = tbl[v >> 12 & 63];
+        *out++ = i + 1 < len ? tbl[v >> 6 & 63] : '=';
+        *out++ = i + 2 < len ? tbl[v & 63] : '=';
+    }
+    *out = 0;
+}
+
+//unmask n bytes src -> dst (dst <= src, so in place works), a word at a
+//time, then rotate the mask so mask[0] applies to the next byte
+static void unmask(uint8_t* dst, const uint8_t* src, size_t n, uint8_t* mask)
+{
+    using word_t = size_t;
+    word_t m;
+    for(size_t j = 0; j < sizeof m; j++) ((uint8_t*)&m)[j] = mask[j & 3];
+    size_t i = 0;
+    for(; i + sizeof(word_t) <= n; i += sizeof(word_t)){
+        word_t w;
+        memcpy(&w, &src[i], sizeof w);          //read before write, so overlap ok
+        w ^= m;
+        memcpy(&dst[i], &w, sizeof w);
+    }
+    for(; i < n; i++) dst[i] = src[i] ^ mask[i & 3];
+    size_t k = n & 3;
+    if(not k) return;
+    uint8_t t[4];
+    for(size_t j = 0; j < 4; j++) t[j] = mask[(j + k) & 3];
+    memcpy(mask, t, 4);
+}
+
+//=====================
+// class functions
+//=====================
+
+void WebSocket::accept(const char* key, char* out)
+{
+    static const char guid[] = "258EAFA5-E914-47DA-95CA-C5AB0DC85B11";
+    uint8_t msg[64 + sizeof(guid)];
+    size_t len = strlen(key);
+    if(len > 64) len = 64;
+    memcpy(msg, key, len);
+    memcpy(&msg[len], guid, sizeof(guid) - 1);
+    uint8_t digest[20];
+    sha1(msg, len + sizeof(guid) - 1, digest);
+    base64(digest, sizeof digest, out);
+}
+
+void WebSocket::start(bool server)
+{
+    m_server = server;
+    m_state = HEAD;
+    m_hlen = 0;
+    m_left = 0;
+    m_ctllen = 0;
+    m_closed = false;
+    m_fhlen = m_fhpos = 0;
+    m_payload = 0;
+    m_outlen = m_outpos = 0;
+}
+
+bool WebSocket::closed() { return m_closed; }
+
+//frames split anywhere across reads- header bytes are collected in m_hdr,
+//payload is unmasked in whole runs up to the end of the frame or read
+//data frames (text/binary/continuation) all pass through as the stream
+size_t WebSocket::decode(uint8_t* p, size_t len)
+{
+    size_t r = 0;                               //read index
+    size_t w = 0;                               //write index (w <= r)
+    while(r < len and not m_closed){
+        if(m_state == HEAD){
+            m_hdr[m_hlen++] = p[r++];
+            if(m_hlen < 2) continue;
+            uint8_t l7 = m_hdr[1] & 0x7F;
+            size_t need = 2 + (m_hdr[1] & 0x80 ? 4 : 0) + (l7 == 126 ? 2 : l7 == 127 ? 8 : 0);
+            if(m_hlen < need) continue;
+            //header complete
+            const uint8_t* q = &m_hdr[2];
+            uint64_t n = l7;
+            if(l7 >= 126){
+                n = 0;
+                for(int k = l7 == 126 ? 2 : 8; k; k--) n = n << 8 | *q++;
+            }
+            if(m_hdr[1] & 0x80) memcpy(m_mask, q, 4);
+            else memset(m_mask, 0, 4);
+            m_hlen = 0;
+            m_left = n;
+            uint8_t op = m_hdr[0] & 0x0F;
+            if((m_hdr[0] & 0x70) or (m_server and not (m_hdr[1] & 0x80))){
+                close(1002);                    //reserved bits, or client frame not masked
+            } else if(op <= BIN){
+                m_state = n ? DATA : HEAD;
+            } else if(op >= CLOSE and op <= PONG and n <= sizeof(m_ctl) and (m_hdr[0] & 0x80)){
+                m_opcode = op;
+                m_ctllen = 0;
+                m_state = CTRL;
+                if(not n){ m_state = HEAD; control(); }
+            } else {
+                close(1002);                    //protocol error
+            }
+            continue;
+        }
+        size_t k = len - r;
+        if(k > m_left) k = m_left;
+        if(m_state == DATA){
+            unmask(&p[w], &p[r], k, m_mask);
+            w += k;
+        } else {
+            unmask(&m_ctl[m_ctllen], &p[r], k, m_mask);
+            m_ctllen += k;
+        }
+        r += k;
+        m_left -= k;
+        if(m_left) continue;
+        if(m_state == CTRL) control();
+        m_state = HEAD;
+    }
+    return w;                                   //anything after a close dropped
+}
+
+void WebSocket::control()
+{
+    switch(m_opcode){
+        case PING: queue(PONG, m_ctl, m_ctllen); break;
+        case CLOSE: close(m_ctllen >= 2 ? m_ctl[0] << 8 | m_ctl[1] : 1000); break;
+        default: break;                         //PONG
+    }
+}
+
+void WebSocket::close(uint16_t code)
+{
+    if(m_closed) return;
+    uint8_t c[2] = { (uint8_t)(code >> 8), (uint8_t)code };
+    queue(CLOSE, c, 2);
+    m_closed = true;
+}
+
+//control frame, unmasked (server), fin set
+bool WebSocket::queue(uint8_t op, const uint8_t* p, size_t n)
+{
+    if(m_outpos == m_outlen) m_outpos = m_outlen = 0;
+    if(m_outlen + 2 + n > sizeof(m_out)) return false;
+    m_out[m_outlen++] = 0x80 | op;
+    m_out[m_outlen++] = n;
+    memcpy(&m_out[m_outlen], p, n);
+    m_outlen += n;
+    return true;
+}
+
+//binary frame, fin set, unmasked- 7 bit or 16 bit length
+size_t WebSocket::frame(size_t n)
+{
+    if(n > 0xFFFF) n = 0xFFFF;
+    m_fhdr[0] = 0x80 | BIN;
+    if(n < 126){
+        m_fhdr[1] = n;
+        m_fhlen = 2;
+    } else {
+        m_fhdr[1] = 126;
+        m_fhdr[2] = n >> 8;
+        m_fhdr[3] = n;
+        m_fhlen = 4;
+    }
+    m_fhpos = 0;
+    m_payload = n;
+    return n;
+}
+
+const uint8_t* WebSocket::head(size_t& len)
+{
+    len = m_fhlen - m_fhpos;
+    return &m_fhdr[m_fhpos];
+}
+
+size_t WebSocket::payload() { return m_payload; }
+
+void WebSocket::frame_sent(size_t n)
+{
+    size_t k = m_fhlen - m_fhpos;
+    if(k > n) k = n;
+    m_fhpos += k;
+    m_payload -= n - k;
+}
+
+//nothing while a data frame is part sent
+const uint8_t* WebSocket::out(size_t& len)
+{
+    len = m_payload ? 0 : m_outlen - m_outpos;
+    return &m_out[m_outpos];
+}
+
+void WebSocket::sent(size_t n)
+{
+    m_outpos += n;
+}
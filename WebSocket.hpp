@@ -0,0 +1,74 @@
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+
+//websocket protocol engine (rfc 6455) for the serial bridge ports
+//
+//  net -> uart-    decode() strips frame headers from received data in
+//                  place and unmasks the payload, a word at a time with the
+//                  mask rotated to the payload position (frames may split
+//                  anywhere across reads)
+//  uart -> net-    frame() starts a binary frame for data already in the
+//                  ring, head() is its header- the header and payload are
+//                  sent together, the payload directly from the ring
+//
+//ping/close replies are queued in a small output buffer, sent (out()/sent())
+//between data frames
+//
+//as the server (default) a client frame must be masked and no frame may
+//set the reserved bits (no extension is agreed)- else the connection is
+//closed (1002), start(false) decodes server frames (unmasked) instead
+
+struct WebSocket {
+
+    //frame opcodes
+    enum : uint8_t { CONT = 0, TEXT = 1, BIN = 2, CLOSE = 8, PING = 9, PONG = 10 };
+
+    //handshake- Sec-WebSocket-Key -> Sec-WebSocket-Accept (28 chars + 0)
+    static void accept      (const char*, char*);
+
+    void        start       (bool = true);      //reset, server (client frames masked)
+
+    //net -> uart
+    size_t      decode      (uint8_t*, size_t); //in place, -> data bytes left
+
+    //uart -> net
+    size_t      frame       (size_t);           //start a frame of n bytes, -> n (max 65535)
+    const uint8_t* head     (size_t&);          //-> header bytes not sent, arg set to len
+    size_t      payload     ();                 //-> payload bytes not sent (0 = no frame)
+    void        frame_sent  (size_t);           //bytes sent, header then payload
+
+    //protocol output to send between frames
+    const uint8_t* out      (size_t&);          //-> pending bytes, arg set to len
+    void        sent        (size_t);           //bytes sent from out()
+
+    bool        closed      ();                 //close received (or protocol error)
+
+    private:
+
+    using state_t = enum : uint8_t { HEAD, DATA, CTRL, SKIP };
+
+    void        control     ();                 //control frame complete
+    void        close       (uint16_t);         //queue close, status code
+    bool        queue       (uint8_t, const uint8_t*, size_t); //opcode, payload
+
+    state_t     m_state{HEAD};
+    uint8_t     m_hdr[14];                      //frame header being received
+    uint8_t     m_hlen{0};
+    uint8_t     m_opcode{0};                    //of control frame in progress
+    uint8_t     m_mask[4];                      //mask, rotated to payload position
+    uint64_t    m_left{0};                      //payload bytes left in frame
+    uint8_t     m_ctl[125];                     //control frame payload
+    uint8_t     m_ctllen{0};
+    bool        m_closed{false};
+    bool        m_server{true};                 //frames received must be masked
+    uint8_t     m_fhdr[4];                      //frame header to send
+    uint8_t     m_fhlen{0};
+    uint8_t     m_fhpos{0};
+    size_t      m_payload{0};                   //payload of frame to send
+    uint8_t     m_out[132];                     //protocol output
+    uint8_t     m_outlen{0};
+    uint8_t     m_outpos{0};
+
+};
@@ -0,0 +1,290 @@
+#include "WifiLink.hpp"
+#include "NvsSettings.hpp"
+#include "EventLog.hpp"
+#include "Reactor.hpp"
+#include "BootTime.hpp"
+
+//=====================
+// local functions
+//=====================
+
+//(loop only)
+static WifiLink::state_t s_state = WifiLink::DOWN;
+static bool started;
+static uint32_t state_ms;                   //millis() state entered
+static uint32_t since_ms;                   //millis() link came up, or went down
+static uint32_t wait_ms;                    //DOWN- back-off
+static bool lost;                           //down after being up (not boot)
+static bool try_fast;                       //DOWN- fast join before the scan
+static bool fast;                           //JOIN- is a fast join
+static uint8_t boot_fast;                   //0 not tried, 1 hit, 2 miss (first connect)
+static bool static_ip;                      //FAST_IP lease applied as a static config
+
+//stats (loop only)
+static struct {
+    uint32_t    outages;                    //link lost
+    uint32_t    reconnects;                 //up again after lost
+    uint64_t    total_ms;                   //reconnect times
+    uint32_t    last_ms, max_ms;
+    uint32_t    scans, joins, fails;
+    uint32_t    fast_hits, fast_misses;
+} st;
+
+static void enter(WifiLink::state_t s)
+{
+    s_state = s;
+    state_ms = millis();
+}
+
+//failed try- wait twice as long as the last time
+static void backoff()
+{
+    using W = WifiLink;
+    wait_ms = wait_ms < W::BACKOFF_MIN_MS ? W::BACKOFF_MIN_MS :
+              wait_ms * 2 < W::BACKOFF_MAX_MS ? wait_ms * 2 : W::BACKOFF_MAX_MS;
+    enter(WifiLink::DOWN);
+}
+
+//wifi event task
+static void on_event(system_event_id_t e)
+{
+    if(e == SYSTEM_EVENT_STA_DISCONNECTED or e == SYSTEM_EVENT_STA_GOT_IP or
+       e == SYSTEM_EVENT_SCAN_DONE) Reactor::wake();
+}
+
+//scan results -> stored credentials index with the strongest signal, -1 = none
+static int pick(int16_t n)
+{
+    NvsSettings settings;
+    int best = -1;
+    int32_t rssi = 0;
+    for(int16_t i = 0; i < n; i++){
+        String ssid = WiFi.SSID(i);
+        if(not ssid.length()) continue;
+        for(uint8_t j = 0; j < settings.wifimaxn(); j++){
+            if(ssid != settings.ssid(j)) continue;
+            if(best < 0 or WiFi.RSSI(i) > rssi){ best = j; rssi = WiFi.RSSI(i); }
+        }
+    }
+    return best;
+}
+
+//back to dhcp if a lease was applied as a static config
+static void use_dhcp()
+{
+    if(static_ip) WiFi.config(IPAddress(), IPAddress(), IPAddress());
+    static_ip = false;
+}
+
+//last good connection, joined without a scan -> false if none or off
+static bool fast_join()
+{
+    NvsSettings settings;
+    NvsSettings::wifilast_t w = settings.wifilast();
+    uint8_t mode = settings.wififast();
+    use_dhcp();                             //unless this join uses the lease again
+    if(mode == WifiLink::FAST_OFF or w.index >= settings.wifimaxn() or not w.channel or
+       not settings.ssid(w.index).length()) return false;
+    if(mode == WifiLink::FAST_IP and w.ip){
+        WiFi.config(w.ip, w.gateway, w.mask, w.dns);
+        static_ip = true;
+    }
+    WiFi.setHostname(settings.hostname().c_str());
+    WiFi.begin(settings.ssid(w.index).c_str(), settings.pass(w.index).c_str(), w.channel, w.bssid);
+    BootTime::mark(BootTime::WIFI_JOIN);
+    fast = true;
+    enter(WifiLink::JOIN);
+    return true;
+}
+
+//fast join did not connect- back to dhcp if the lease was used
+static void fast_miss()
+{
+    st.fast_misses++;
+    if(not boot_fast) boot_fast = 2;
+    fast = false;
+    use_dhcp();
+}
+
+//the connection to try first next time (NvsSettings::check writes it if
+//it changed)- up on a static config there is no dhcp, so no new lease to
+//store, the lease is left out and the next join takes dhcp (a lease is
+//used for one connection at most)
+static void save_last()
+{
+    NvsSettings settings;
+    NvsSettings::wifilast_t w;
+    memset(&w, 0, sizeof(w));
+    w.index = 0xFF;
+    String ssid = WiFi.SSID();
+    for(uint8_t i = 0; i < settings.wifimaxn(); i++){
+        if(ssid.length() and ssid == settings.ssid(i)){ w.index = i; break; }
+    }
+    if(w.index == 0xFF) return;
+    uint8_t* b = WiFi.BSSID();
+    if(b) memcpy(w.bssid, b, sizeof(w.bssid));
+    w.channel = WiFi.channel();
+    if(not static_ip){
+        w.ip = WiFi.localIP();
+        w.gateway = WiFi.gatewayIP();
+        w.mask = WiFi.subnetMask();
+        w.dns = WiFi.dnsIP();
+    }
+    settings.wifilast(w);
+}
+
+static void reboot()
+{
+    EventLog::put(EventLog::LINK_REBOOT, EventLog::WIFI, "sta", 0);
+    NvsSettings::flush();
+    delay(WifiLink::REBOOT_MS);             //log task prints it
+    ESP.restart();
+}
+
+//=====================
+// class functions
+//=====================
+
+void WifiLink::start()
+{
+    WiFi.onEvent(on_event);
+    WiFi.mode(WIFI_STA);
+    since_ms = millis();
+    wait_ms = 0;                            //join now
+    try_fast = true;
+    enter(DOWN);
+    started = true;
+    BootTime::mark(BootTime::WIFI_START);
+}
+
+bool WifiLink::up(){ return s_state == UP; }
+WifiLink::state_t WifiLink::state(){ return s_state; }
+uint32_t WifiLink::up_ms(){ return s_state == UP ? millis() - since_ms : 0; }
+
+const char* WifiLink::fast_name()
+{
+    static const char* const names[] = { "fast off", "fast bssid", "fast ip" };
+    static const char* const results[] = { "", ", hit", ", miss" };
+    static char s[24];
+    NvsSettings settings;
+    uint8_t m = settings.wififast();
+    snprintf(s, sizeof(s), "%s%s", m <= FAST_IP ? names[m] : "?", results[boot_fast]);
+    return s;
+}
+
+bool WifiLink::check()
+{
+    if(not started) return false;
+    uint32_t now = millis();
+    bool connected = WiFi.status() == WL_CONNECTED;
+    if(s_state == UP){
+        if(connected) return true;
+        EventLog::put(EventLog::LINK_LOST, EventLog::WIFI, "sta", 0);
+        st.outages++;
+        lost = true;
+        since_ms = now;
+        wait_ms = BACKOFF_MIN_MS;           //the core may reconnect first
+        try_fast = true;
+        use_dhcp();                         //so that reconnect renews the lease
+        enter(DOWN);
+    } else if(connected){
+        if(lost){                           //not the first connect
+            uint32_t t = now - since_ms;
+            st.reconnects++;
+            st.total_ms += t;
+            st.last_ms = t;
+            if(t > st.max_ms) st.max_ms = t;
+        }
+        if(s_state == SCAN) WiFi.scanDelete();
+        if(fast){
+            st.fast_hits++;
+            if(not boot_fast) boot_fast = 1;
+            fast = false;
+        }
+        save_last();
+        BootTime::mark(BootTime::WIFI_UP);
+        EventLog::put(EventLog::LINK_UP, EventLog::WIFI, "sta", 0, 0, WiFi.SSID().c_str());
+        since_ms = now;
+        lost = false;
+        enter(UP);
+        return true;
+    }
+
+    //down
+    NvsSettings settings;
+    uint16_t rs = settings.wifireboot();
+    if(rs and now - since_ms >= rs * 1000u) reboot();
+    switch(s_state){
+        case DOWN:
+            if(now - state_ms < wait_ms){
+                Reactor::due((wait_ms - (now - state_ms)) * 1000);
+                break;
+            }
+            WiFi.disconnect();              //stop a connect in progress
+            if(try_fast){
+                try_fast = false;
+                if(fast_join()){ Reactor::due(POLL_US); break; }
+            }
+            st.scans++;
+            if(WiFi.scanNetworks(true) == WIFI_SCAN_FAILED){ backoff(); break; }
+            enter(SCAN);
+            Reactor::due(POLL_US);
+            break;
+        case SCAN: {
+            int16_t n = WiFi.scanComplete();
+            if(n == WIFI_SCAN_RUNNING){ Reactor::due(POLL_US); break; }
+            int i = pick(n);
+            WiFi.scanDelete();
+            if(i < 0){ backoff(); break; }
+            //(setHostname code modified, so can set any time)
+            WiFi.setHostname(settings.hostname().c_str());
+            WiFi.begin(settings.ssid(i).c_str(), settings.pass(i).c_str());
+            BootTime::mark(BootTime::WIFI_JOIN);
+            st.joins++;
+            enter(JOIN);
+            Reactor::due(POLL_US);
+            break;
+        }
+        case JOIN: {
+            wl_status_t s = WiFi.status();
+            bool failed = s == WL_CONNECT_FAILED or s == WL_NO_SSID_AVAIL;
+            if(fast and (failed or now - state_ms >= FAST_MS)){
+                fast_miss();
+                wait_ms = 0;                //scan now
+                enter(DOWN);
+                Reactor::due(0);
+                break;
+            }
+            if(failed or now - state_ms >= JOIN_MS){
+                st.fails++;
+                backoff();
+                break;
+            }
+            Reactor::due(POLL_US);
+            break;
+        }
+        case UP:
+            break;
+    }
+    return false;
+}
+
+void WifiLink::stats(WiFiClient& client)
+{
+    static const char* const names[] = { "down", "scan", "join", "up" };
+    NvsSettings settings;
+    client.printf("wifi   %s %us | outages %u | reconnect ms last %u avg %u max %u\n",
+        names[s_state], (unsigned)((millis() - since_ms) / 1000), (unsigned)st.outages,
+        (unsigned)st.last_ms, st.reconnects ? (unsigned)(st.total_ms / st.reconnects) : 0,
+        (unsigned)st.max_ms);
+    client.printf("       scans %u, joins %u, join fails %u | %s | fast hits %u, misses %u\n",
+        (unsigned)st.scans, (unsigned)st.joins, (unsigned)st.fails, fast_name(),
+        (unsigned)st.fast_hits, (unsigned)st.fast_misses);
+    client.printf("       reboot when down %us%s\n",
+        (unsigned)settings.wifireboot(), settings.wifireboot() ? "" : " (never)");
+}
+
+void WifiLink::stats_reset()
+{
+    memset(&st, 0, sizeof(st));
+}
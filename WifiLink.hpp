@@ -0,0 +1,56 @@
+#pragma once
+
+#include <WiFi.h>
+
+//wifi station link- connects, and reconnects when lost, without blocking
+//the loop, so the uart bridges keep reading while the link is down (see
+//TelnetServer fanout- while down no client is dropped for being behind,
+//and with no client connected the rx ring is kept for the next one)
+//
+//  DOWN-   wait (back-off, doubles each failed try BACKOFF_MIN_MS up to
+//          BACKOFF_MAX_MS), then scan (or first a fast join)
+//  SCAN-   async scan, the strongest stored ssid found is joined, none =
+//          DOWN
+//  JOIN-   WiFi.begin until connected, failed or JOIN_MS = DOWN
+//  UP-     connected (from any state- the core may reconnect on its own)
+//
+//fast reconnect (wifi fast)- at boot and after the link is lost the last
+//good connection is joined first, its ap by bssid and channel (no scan),
+//with FAST_IP also its dhcp lease as a static config (no dhcp)- if not up
+//in FAST_MS it is the full scan (dhcp again)- the last good connection is
+//stored when the link comes up (written only when it changed), without the
+//lease when up on the static config, so the next join renews it by dhcp-
+//the static config is dropped when the link is lost (the core's own
+//reconnect takes dhcp too)
+//
+//credentials and hostname are read from settings for each join, so wifi
+//add and net hostname apply on the next reconnect
+//
+//reboot policy (wifi reboot)- reboot after the link is down this many
+//seconds, 0 = never (a reboot loses what the bridges hold)
+//
+//wifi events (lost, got ip, scan done) wake the loop (Reactor)
+
+struct WifiLink {
+
+    using state_t = enum : uint8_t { DOWN, SCAN, JOIN, UP };
+    using fast_t = enum : uint8_t { FAST_OFF, FAST_BSSID, FAST_IP };
+
+    static const uint32_t BACKOFF_MIN_MS = 1000;
+    static const uint32_t BACKOFF_MAX_MS = 32000;
+    static const uint32_t JOIN_MS = 10000;
+    static const uint32_t FAST_MS = 3000;
+    static const uint32_t POLL_US = 100000;     //scan/join checked this often
+    static const uint32_t REBOOT_MS = 1000;     //event log time before reboot
+
+    static void start   ();                 //station mode, connect
+    static bool check   ();                 //loop -> link up
+    static bool up      ();
+    static state_t state();
+    static uint32_t up_ms();                //-> ms since the link came up (0 = down)
+    static const char* fast_name();         //-> fast reconnect mode, boot result
+
+    static void stats   (WiFiClient&);
+    static void stats_reset();
+
+};
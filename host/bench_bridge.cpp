@@ -0,0 +1,523 @@
+//host benchmark- uart2 bridge end to end
+//runs the real TelnetServer/UartBridge/Commander sources against the host
+//stand-ins (stubs/), with a tcp client on port 2302 and the other side of
+//the uart2 pty (or a websocket client on /uart2 of a WebServer on port 8080)
+//
+//  make && build/bench_bridge [-b baud] [-k KB] [-n pings] [-t | -z | -w] [-p mode[,arg]]
+//                              [-f none|rts|xoff] [-s] [-P] [-o]
+//      -b  uart2 baud rate (default 921600)
+//      -k  KB pushed each direction for throughput (default 256)
+//      -n  round trips for latency percentiles (default 1000)
+//      -t  telnet mode (default raw tcp)
+//      -z  telnet with lz compression (uart2lz set, client asks DO 88), the
+//          uart -> tcp data is a log-like text instead of random bytes
+//      -w  websocket (client frames masked, 1KB per frame)
+//      -p  uart2 packet framing (none, line, delim,hex, length,1-2, idle,chars),
+//          the uart -> tcp data is the log-like text
+//      -f  uart2 rx flow control (tcp -> uart data is then text, no XON/XOFF)
+//      -s  slow reader- the client reads uart -> tcp data at half the line
+//          rate with a 4KB socket rx buffer, data lost shows without flow
+//          control (drops), none lost with it
+//      -P  loop() polls every server as fast as it can (as before the
+//          Reactor), default checks then sleeps in Reactor::wait
+//      -o  wifi outage (raw tcp)- the link goes down (WiFi.link) and the
+//          client with it, 8KB are printed, the link is back and the client
+//          connects again- it should get all of them, and only them
+//
+//the loop thread's cpu use is shown for the throughput and latency runs
+//and for a second with the client connected and no data moving
+//
+//loop() is a thread calling check() on both servers, the bridge task is a
+//thread woken as on the esp32 (uart2 is a PtyUart- rx fifo full/idle
+//timeout, tx kicks)- the pty is paced to the baud rate, so throughput tops
+//out at baud/10 and latency includes the char times (nvs_settings.txt in
+//the working directory holds the settings used)
+
+#include "TelnetServer.hpp"
+#include "Bridges.hpp"
+#include "WebServer.hpp"
+#include "NvsSettings.hpp"
+#include "EventLog.hpp"
+#include "Reactor.hpp"
+#include "WifiLink.hpp"
+#include "BootTime.hpp"
+#include "Lz.hpp"
+#include "PtyUart.hpp"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <string>
+#include <thread>
+#include <vector>
+#include <fcntl.h>
+#include <time.h>
+#include <poll.h>
+#include <termios.h>
+#include <unistd.h>
+#include <arpa/inet.h>
+#include <netinet/tcp.h>
+
+//info/trace/log/web servers, as in wifitoserial.ino (Commander refers to
+//them), the uart2 bridge is started by Bridges from the settings
+TelnetServer telnet_info(2300, "info", TelnetServer::INFO);
+TelnetServer telnet_trace(2303, "trace", TelnetServer::TRACE);
+TelnetServer telnet_log(2304, "log", TelnetServer::LOG);
+WebServer web_server(8080, "http");
+
+using clk = std::chrono::steady_clock;
+using bytes_t = std::vector<uint8_t>;
+
+static bool telnet;
+static Telnet tn;                               //client side protocol
+static bool websock;
+static WebSocket ws;                            //decodes server frames
+static bool compress;
+static bool lz_on;                              //server sent WILL LZ
+static LzDecoder lz;
+static Framer::mode_t packet;                   //uart2 packet framing
+static uint8_t packet_arg;
+static UartPort::flow_t flow;                   //uart2 rx flow control
+static bool slow;                               //slow reader test (small rx buffer)
+static bool poll_loop;                          //loop without Reactor
+static bool outage_test;
+static std::atomic<uint64_t> loop_ns;           //loop thread cpu time
+
+static uint64_t thread_ns()
+{
+    timespec t;
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &t);
+    return t.tv_sec * 1000000000ull + t.tv_nsec;
+}
+
+//loop thread cpu since (t0, c0), % of one core
+static void loop_cpu(const char* name, clk::time_point t0, uint64_t c0)
+{
+    double s = std::chrono::duration<double>(clk::now() - t0).count();
+    printf("%-10s loop cpu %5.1f%%\n", name, (loop_ns - c0) / 1e9 / s * 100);
+}
+
+//=====================
+// tcp client side
+//=====================
+
+static int tcp_connect(uint16_t port)
+{
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    int rcv = 4096;
+    if(slow and port != 2300) setsockopt(fd, SOL_SOCKET, SO_RCVBUF, &rcv, sizeof rcv);
+    sockaddr_in a{};
+    a.sin_family = AF_INET;
+    a.sin_port = htons(port);
+    a.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    if(connect(fd, (sockaddr*)&a, sizeof a)){ perror("connect"); exit(1); }
+    int v = 1;
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &v, sizeof v);
+    return fd;
+}
+
+static void send_all(int fd, const uint8_t* p, size_t n)
+{
+    while(n){
+        ssize_t r = send(fd, p, n, MSG_NOSIGNAL);
+        if(r <= 0){ perror("send"); exit(1); }
+        p += r;
+        n -= r;
+    }
+}
+
+//websocket upgrade on /uart2 (rfc 6455 sample key, so the accept is known)
+static void ws_connect(int fd)
+{
+    const char req[] = "GET /uart2 HTTP/1.1\r\nHost: localhost\r\nUpgrade: websocket\r\n"
+        "Connection: Upgrade\r\nSec-WebSocket-Key: dGhlIHNhbXBsZSBub25jZQ==\r\n"
+        "Sec-WebSocket-Version: 13\r\n\r\n";
+    send_all(fd, (const uint8_t*)req, sizeof req - 1);
+    std::string rsp;
+    char ch;
+    while(rsp.find("\r\n\r\n") == std::string::npos and recv(fd, &ch, 1, 0) == 1) rsp += ch;
+    if(rsp.find(" 101 ") == std::string::npos or
+       rsp.find("s3pPLMBiTxaQ9kYGzzhZRbK+xOo=") == std::string::npos){
+        printf("websocket upgrade failed-\n%s", rsp.c_str());
+        exit(1);
+    }
+    ws.start(false);                            //server frames, unmasked
+}
+
+//send replies the client telnet engine has queued
+static void tn_reply(int fd)
+{
+    size_t len;
+    const uint8_t* o = tn.out(len);
+    if(len){ send_all(fd, o, len); tn.sent(len); }
+}
+
+//lz- the client engine does not know option LZ, so WILL/WONT LZ are cut
+//out of the stream here (tracking IAC so escaped data is not mistaken),
+//the data after WILL LZ is telnet decoded then lz decoded
+static void lz_read(int fd, bytes_t& out, const uint8_t* raw, size_t r)
+{
+    static uint8_t st;                          //0 data, 1 IAC, 2 IAC WILL/WONT
+    static uint8_t cmd;
+    bytes_t tmp;
+    size_t from = 0;
+    auto seg = [&](size_t to){                  //raw[from..to) -> out
+        tmp.assign(raw + from, raw + to);
+        size_t k = tn.decode(tmp.data(), tmp.size());
+        tn_reply(fd);
+        if(lz_on){
+            bytes_t d(LzDecoder::bound(k));
+            k = lz.decode(tmp.data(), k, d.data());
+            out.insert(out.end(), d.begin(), d.begin() + k);
+        } else {
+            out.insert(out.end(), tmp.begin(), tmp.begin() + k);
+        }
+    };
+    for(size_t i = 0; i < r; i++){
+        uint8_t c = raw[i];
+        if(st == 0){ if(c == Telnet::IAC) st = 1; continue; }
+        if(st == 1){ st = c == Telnet::WILL or c == Telnet::WONT ? 2 : 0; cmd = c; continue; }
+        st = 0;
+        if(c != Telnet::LZ) continue;
+        //cut IAC cmd LZ (its first bytes may have been in the last read)
+        size_t at = i >= 2 ? i - 2 : 0;
+        seg(at);
+        from = i + 1;
+        if(cmd == Telnet::WILL and not lz_on){ lz_on = true; lz.start(); }
+        if(cmd == Telnet::WONT) lz_on = false;
+    }
+    seg(r);
+}
+
+//read up to n data bytes (telnet decoded), timeout ms
+//(a read of only protocol bytes decodes to nothing, so keep reading)
+static size_t tcp_read(int fd, uint8_t* p, size_t n, int ms)
+{
+    static bytes_t pending;                     //lz decoded, not yet returned
+    pollfd pf{fd, POLLIN, 0};
+    for(;;){
+        if(not pending.empty()){
+            n = std::min(n, pending.size());
+            memcpy(p, &pending[0], n);
+            pending.erase(pending.begin(), pending.begin() + n);
+            return n;
+        }
+        if(poll(&pf, 1, ms) <= 0) return 0;
+        ssize_t r = recv(fd, p, n, 0);
+        if(r <= 0) return 0;
+        if(websock){
+            r = ws.decode(p, r);
+            if(r) return r;
+            continue;
+        }
+        if(not telnet) return r;
+        if(compress){ lz_read(fd, pending, p, r); continue; }
+        r = tn.decode(p, r);
+        tn_reply(fd);
+        if(r) return r;
+    }
+}
+
+//telnet- escape IAC as IAC IAC
+//websocket- a masked binary frame
+static void tcp_write(int fd, const uint8_t* p, size_t n)
+{
+    if(websock){
+        bytes_t b{ 0x82 };
+        if(n < 126) b.push_back(0x80 | n);
+        else { b.push_back(0x80 | 126); b.push_back(n >> 8); b.push_back(n); }
+        uint8_t mask[4] = { (uint8_t)rand(), (uint8_t)rand(), (uint8_t)rand(), (uint8_t)rand() };
+        b.insert(b.end(), mask, mask + 4);
+        for(size_t i = 0; i < n; i++) b.push_back(p[i] ^ mask[i & 3]);
+        send_all(fd, &b[0], b.size());
+        return;
+    }
+    if(not telnet){ send_all(fd, p, n); return; }
+    bytes_t b;
+    b.reserve(n * 2);
+    for(size_t i = 0; i < n; i++){
+        b.push_back(p[i]);
+        if(p[i] == Telnet::IAC) b.push_back(p[i]);
+    }
+    send_all(fd, &b[0], b.size());
+}
+
+//=====================
+// pty side
+//=====================
+
+static int pty_open(const char* path)
+{
+    int fd = open(path, O_RDWR | O_NOCTTY);
+    if(fd < 0){ perror(path); exit(1); }
+    termios t;
+    tcgetattr(fd, &t);
+    cfmakeraw(&t);
+    tcsetattr(fd, TCSANOW, &t);
+    return fd;
+}
+
+static size_t pty_read(int fd, uint8_t* p, size_t n, int ms)
+{
+    pollfd pf{fd, POLLIN, 0};
+    if(poll(&pf, 1, ms) <= 0) return 0;
+    ssize_t r = read(fd, p, n);
+    return r > 0 ? r : 0;
+}
+
+static void pty_write(int fd, const uint8_t* p, size_t n)
+{
+    while(n){
+        ssize_t r = write(fd, p, n);
+        if(r <= 0){ perror("pty write"); exit(1); }
+        p += r;
+        n -= r;
+    }
+}
+
+//=====================
+// tests
+//=====================
+
+static double secs(clk::time_point t0)
+{
+    return std::chrono::duration<double>(clk::now() - t0).count();
+}
+
+//drain anything pending on a fd (negotiation, leftovers)
+static void drain(int fd, bool tcp)
+{
+    uint8_t b[4096];
+    while(tcp ? tcp_read(fd, b, sizeof b, 50) : pty_read(fd, b, sizeof b, 50));
+}
+
+using reader_t = size_t (*)(int, uint8_t*, size_t, int);
+using writer_t = void (*)(int, const uint8_t*, size_t);
+
+static void throughput(const char* name, int wfd, writer_t w, int rfd, reader_t r, size_t n,
+    bool text = false)
+{
+    bytes_t out(n), in(n);
+    for(auto& b : out) b = rand();
+    for(size_t i = 0; text and i < n;){         //log lines, values changing
+        char s[96];
+        int k = snprintf(s, sizeof s, "[%7zu.%03u] sensor: temp=%d.%dC hum=%d%% state %s\r\n",
+            i / 1000, (unsigned)(i % 1000), 20 + rand() % 5, rand() % 10, 40 + rand() % 20,
+            rand() % 8 ? "ok" : "retry");
+        for(int j = 0; j < k and i < n; j++) out[i++] = s[j];
+    }
+    auto t0 = clk::now();
+    std::thread tx([&]{
+        for(size_t i = 0; i < n; i += 1024) w(wfd, &out[i], std::min<size_t>(1024, n - i));
+    });
+    size_t got = 0;
+    while(got < n){
+        size_t k = r(rfd, &in[got], n - got, 2000);
+        if(not k) break;
+        got += k;
+    }
+    double s = secs(t0);
+    tx.join();
+    printf("%-10s %8.1f KB/s  %s\n", name, got / s / 1000,
+        got < n ? "TIMEOUT" : in == out ? "ok" : "MISMATCH");
+}
+
+static void latency(const char* name, int wfd, writer_t w, int rfd, reader_t r, int count)
+{
+    std::vector<double> us;
+    uint8_t msg[8], in[8];
+    for(int i = 0; i < count; i++){
+        for(auto& b : msg) b = rand();
+        auto t0 = clk::now();
+        w(wfd, msg, sizeof msg);
+        size_t got = 0;
+        while(got < sizeof msg){
+            size_t k = r(rfd, &in[got], sizeof in - got, 1000);
+            if(not k) break;
+            got += k;
+        }
+        if(got < sizeof msg){ printf("%s: timeout %d got %zu bin %d:", name, i, got, tn.binary()); for(auto b: msg) printf(" %02x", b); printf(" /"); for(size_t j=0;j<got;j++) printf(" %02x", in[j]); printf("\n"); return; }
+        us.push_back(secs(t0) * 1e6);
+    }
+    std::sort(us.begin(), us.end());
+    auto pct = [&](double p){ return us[std::min(us.size() - 1, (size_t)(p * us.size()))]; };
+    printf("%-10s p50 %7.0fus  p90 %7.0fus  p99 %7.0fus  max %7.0fus\n",
+        name, pct(0.50), pct(0.90), pct(0.99), us.back());
+}
+
+//uart -> tcp with the client reading at rate bytes/s (less than the line)-
+//the rx ring fills, then a reader is skipped (data lost) or the sender held
+static void slow_reader(int pty, int tcp, size_t n, double rate)
+{
+    bytes_t out(n), in(n);
+    for(auto& b : out) b = ' ' + rand() % 94;
+    auto t0 = clk::now();
+    std::thread tx([&]{
+        for(size_t i = 0; i < n; i += 1024) pty_write(pty, &out[i], std::min<size_t>(1024, n - i));
+    });
+    size_t got = 0;
+    while(got < n){
+        size_t k = tcp_read(tcp, &in[got], std::min<size_t>(512, n - got), 2000);
+        if(not k) break;
+        got += k;
+        double ahead = got / rate - secs(t0);
+        if(ahead > 0) std::this_thread::sleep_for(std::chrono::duration<double>(ahead));
+    }
+    double s = secs(t0);
+    tx.join();
+    in.resize(got);
+    out.resize(n);
+    printf("%-10s %8.1f KB/s  %s", "slow read", got / s / 1000,
+        got < n ? "LOST" : in == out ? "ok" : "MISMATCH");
+    if(got < n) printf(" %zu of %zu bytes", n - got, n);
+    printf("\n");
+}
+
+//wifi outage- the link goes down and the client's connection with it, the
+//target keeps printing, the link is back and the client connects again-
+//it gets everything printed while the link was down, and nothing it had
+//already been sent
+static void outage(int pty, int& tcp, size_t n, double ms)
+{
+    bytes_t out(n), in;
+    for(auto& b : out) b = ' ' + rand() % 94;
+    WiFi.link(false);
+    close(tcp);
+    delay(100);
+    pty_write(pty, &out[0], n);
+    delay(ms);                                  //on the wire
+    WiFi.link(true);
+    tcp = tcp_connect(2302);
+    uint8_t b[4096];
+    for(size_t k; (k = tcp_read(tcp, b, sizeof b, 500));) in.insert(in.end(), b, b + k);
+    bool ok = in.size() >= n and std::equal(out.begin(), out.end(), in.end() - n);
+    printf("%-10s %6zu bytes while down, %6zu on reconnect  %s\n", "outage", n, in.size(),
+        not ok ? "LOST" : in.size() > n ? "REPEATED" : "ok");
+}
+
+//=====================
+// main
+//=====================
+
+int main(int argc, char** argv)
+{
+    BootTime::mark(BootTime::SETUP);
+    uint32_t baud = 921600;
+    size_t kb = 256;
+    int pings = 1000;
+    for(int i = 1; i < argc; i++){
+        if(not strcmp(argv[i], "-b") and i + 1 < argc) baud = atoi(argv[++i]);
+        else if(not strcmp(argv[i], "-k") and i + 1 < argc) kb = atoi(argv[++i]);
+        else if(not strcmp(argv[i], "-n") and i + 1 < argc) pings = atoi(argv[++i]);
+        else if(not strcmp(argv[i], "-t")) telnet = true;
+        else if(not strcmp(argv[i], "-z")) telnet = compress = true;
+        else if(not strcmp(argv[i], "-w")) websock = true, telnet = false;
+        else if(not strcmp(argv[i], "-p") and i + 1 < argc){
+            const char* s = argv[++i];
+            const char* c = strchr(s, ',');
+            size_t len = c ? c - s : strlen(s);
+            packet = Framer::NONE;
+            while(packet <= Framer::IDLE and (strlen(Framer::name(packet)) != len or
+                strncmp(s, Framer::name(packet), len))) packet = (Framer::mode_t)(packet + 1);
+            if(packet > Framer::IDLE){ printf("-p %s: no such mode\n", s); return 1; }
+            if(c) packet_arg = strtol(c + 1, NULL, packet == Framer::DELIM ? 16 : 10);
+        }
+        else if(not strcmp(argv[i], "-f") and i + 1 < argc){
+            const char* s = argv[++i];
+            flow = not strcmp(s, "rts") ? UartPort::FLOW_RTS : not strcmp(s, "xoff") ? UartPort::FLOW_XOFF :
+                UartPort::FLOW_NONE;
+        }
+        else if(not strcmp(argv[i], "-s")) slow = true;
+        else if(not strcmp(argv[i], "-P")) poll_loop = true;
+        else if(not strcmp(argv[i], "-o")) outage_test = true;
+    }
+    {
+        NvsSettings settings;
+        settings.uartenable(2, true);
+        settings.uartport(2, 2302);
+        settings.uartbaud(2, baud);
+        settings.uarttelnet(2, telnet);
+        settings.uartcompress(2, compress);
+        settings.uartpacket(2, packet, packet_arg);
+        settings.uartflow(2, flow, flow == UartPort::FLOW_RTS ? 18 : -1, -1);
+        settings.ssid(0, "host");                   //the stand-in network
+    }
+
+    //loop()- server events on stdout (uart0), as in setup()
+    std::atomic<bool> run{true};
+    EventLog::start(EventLog::SERIAL_OUT);
+    WifiLink::start();
+    telnet_info.start();
+    telnet_trace.start();
+    Bridges::start();
+    web_server.start();
+    BootTime::mark(BootTime::SERVERS);
+    std::thread loop([&]{
+        while(run){
+            WifiLink::check();
+            telnet_info.check();
+            telnet_trace.check();
+            Bridges::check();
+            web_server.check();
+            NvsSettings::check();
+            if(not poll_loop) Reactor::wait();
+            loop_ns = thread_ns();
+        }
+    });
+
+    int tcp = tcp_connect(websock ? 8080 : 2302);
+    if(websock) ws_connect(tcp);
+    if(compress){
+        const uint8_t ask[] = { Telnet::IAC, Telnet::DO, Telnet::LZ };
+        send_all(tcp, ask, sizeof ask);
+    }
+    PtyUart& uart2 = (PtyUart&)UartPort::get(2);
+    for(int i = 0; i < 200 and not uart2.pty(); i++) delay(10);
+    if(not uart2.pty()){ printf("uart2 not opened\n"); return 1; }
+    int pty = pty_open(uart2.pty());
+    drain(tcp, true);                           //telnet negotiation
+    printf("uart2 %u %s, pty %s\n", baud, websock ? "websocket" : compress ? (lz_on ? "telnet lz" : "telnet, lz refused") :
+        telnet ? "telnet" : "raw", uart2.pty());
+    if(packet) printf("packet framing %s,%u\n", Framer::name(packet), packet_arg);
+    if(flow) printf("rx flow control %s\n", flow == UartPort::FLOW_RTS ? "rts" : "xoff");
+
+    printf("loop %s\n", poll_loop ? "polling" : "Reactor");
+
+    auto t0 = clk::now();
+    uint64_t c0 = loop_ns;
+    throughput("uart->tcp", pty, pty_write, tcp, tcp_read, kb * 1000, compress or packet);
+    throughput("tcp->uart", tcp, tcp_write, pty, pty_read, kb * 1000, flow == UartPort::FLOW_XOFF);
+    loop_cpu("throughput", t0, c0);
+    drain(tcp, true);
+    drain(pty, false);
+    t0 = clk::now();
+    c0 = loop_ns;
+    latency("uart->tcp", pty, pty_write, tcp, tcp_read, pings);
+    latency("tcp->uart", tcp, tcp_write, pty, pty_read, pings);
+    loop_cpu("latency", t0, c0);
+    t0 = clk::now();
+    c0 = loop_ns;
+    delay(1000);
+    loop_cpu("idle", t0, c0);
+    if(slow) slow_reader(pty, tcp, kb * 1000, baud / 10 / 2);
+    if(outage_test and (telnet or websock)) printf("outage     raw tcp only\n");
+    else if(outage_test) outage(pty, tcp, 8192, 8192 * 10000.0 / baud + 200);
+
+    //bridge stats and the boot timeline (from main), through the info
+    //server as a user would see them
+    int info = tcp_connect(2300);
+    const char cmd[] = "stats show\r\nsys timeline\r\n";
+    send_all(info, (const uint8_t*)cmd, sizeof cmd - 1);
+    char b[4096];
+    pollfd pf{info, POLLIN, 0};
+    for(ssize_t r; poll(&pf, 1, 500) > 0 and (r = recv(info, b, sizeof b, 0)) > 0;)
+        fwrite(b, 1, r, stdout);
+    close(info);
+
+    run = false;
+    Reactor::wake();
+    loop.join();
+    web_server.stop();
+    close(tcp);
+    close(pty);
+    return 0;
+}
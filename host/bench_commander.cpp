@@ -0,0 +1,176 @@
+//host benchmark- Commander dispatch
+//compares the original dispatch (linear scan of the command list with
+//String startsWith/replace/trim, line passed by value) with the perfect hash
+//lookup in Commander::find, per command in table order, then the tcp
+//writes a command's output makes- each print straight to the client (as
+//before) against the prints collected in a BufferedClient
+//
+//  make && build/bench_commander [iterations]
+//
+//heap allocations are counted with a global operator new- built with the
+//old std::string abi (no small string optimisation), so String allocates
+//like the esp32 String does
+
+#include "Commander.hpp"
+#include "TelnetServer.hpp"
+#include "WebServer.hpp"
+#include "BufferedClient.hpp"
+#include <chrono>
+#include <new>
+
+//info/trace/log/web servers, as in wifitoserial.ino (Commander refers to them)
+TelnetServer telnet_info(2300, "info", TelnetServer::INFO);
+TelnetServer telnet_trace(2303, "trace", TelnetServer::TRACE);
+TelnetServer telnet_log(2304, "log", TelnetServer::LOG);
+WebServer web_server(80, "http");
+
+//=====================
+// allocation counter
+//=====================
+
+static size_t allocs;
+
+void* operator new(size_t n)
+{
+    allocs++;
+    if(void* p = malloc(n ? n : 1)) return p;
+    throw std::bad_alloc();
+}
+void operator delete(void* p) noexcept { free(p); }
+
+//=====================
+// original dispatch
+//=====================
+
+//the command list as it was- root (no function) followed by its subs
+static const struct { const char* cmd; bool sub; } old_commands[] = {
+    { "help", 0 }, { "bye", 0 },
+    { "sys", 0 },   { "bootAP", 1 }, { "reboot", 1 }, { "erase", 1 },
+    { "wifi", 0 },  { "list", 1 }, { "add", 1 }, { "erase", 1 },
+    { "net", 0 },   { "hostname", 1 }, { "APname", 1 }, { "mac", 1 }, { "servers", 1 },
+    { "stats", 0 }, { "show", 1 }, { "reset", 1 },
+    { "uart2", 0 }, { "baud", 1 }, { "telnet", 1 }, { "drop", 1 }, { "coalesce", 1 },
+    { NULL, 0 }
+};
+
+//Commander::process as it was, without running the command
+//-> matched command index, -1 help, -2 unknown
+static int old_find(String s)
+{
+    if(s == "bye") return 1;
+    for(auto i = 0; old_commands[i].cmd; i++){
+        if(old_commands[i].sub) continue;
+        if(not s.startsWith(old_commands[i].cmd)) continue;
+        s.replace(old_commands[i].cmd, "");
+        if(s[0] != ' ') return -1;
+        s.trim();
+        if(not s[0]) return -1;
+        for(i++; old_commands[i].sub; i++){
+            if(not s.startsWith(old_commands[i].cmd)) continue;
+            s.replace(old_commands[i].cmd, "");
+            s.trim();
+            return i;
+        }
+        return -1;
+    }
+    return -2;
+}
+
+//=====================
+// main
+//=====================
+
+//one line per command, in table order (+ unknown)
+static const char* lines[] = {
+    "help", "bye",
+    "sys bootAP=1", "sys reboot", "sys erase",
+    "wifi list", "wifi add 0 ssid=myssid", "wifi erase 3",
+    "net hostname=myname", "net APname", "net mac", "net servers",
+    "stats show", "stats reset",
+    "uart2 baud=115200", "uart2 telnet=1", "uart2 drop=close", "uart2 coalesce=1436,250,5000",
+    "foo bar",
+};
+
+//=====================
+// write counter
+//=====================
+
+//a client that counts the writes (each one a tcp segment, no delay is set)
+struct CountClient : WiFiClient {
+    size_t writes{0};
+    size_t bytes{0};
+    size_t write(const uint8_t*, size_t n) override { writes++; bytes += n; return n; }
+    using WiFiClient::write;
+};
+
+//commands with output, the prompt goes with it (as in handler_info)
+static const char* shows[] = {
+    "help", "wifi list", "net servers", "stats show", "uart2 driver", "uart2 coalesce", "uart2 flow",
+};
+
+static void segments()
+{
+    printf("\n%-30s %8s %8s %10s %8s %8s %10s\n", "",
+        "old segs", "bytes", "bytes/seg", "new segs", "bytes", "bytes/seg");
+    size_t old_w = 0, old_b = 0, new_w = 0, new_b = 0;
+    for(auto line : shows){
+        char buf[128];
+        CountClient a, b;
+        strcpy(buf, line);
+        Commander::process(a, buf);
+        a.printf("$ ");
+        strcpy(buf, line);
+        {
+            BufferedClient out(b);
+            Commander::process(out, buf);
+            out.printf("$ ");
+            out.push();
+        }
+        printf("%-30s %8u %8u %10.1f %8u %8u %10.1f\n", line,
+            (unsigned)a.writes, (unsigned)a.bytes, (double)a.bytes / a.writes,
+            (unsigned)b.writes, (unsigned)b.bytes, (double)b.bytes / b.writes);
+        old_w += a.writes; old_b += a.bytes;
+        new_w += b.writes; new_b += b.bytes;
+    }
+    size_t k = sizeof(shows) / sizeof(shows[0]);
+    printf("%-30s %8.1f %8s %10.1f %8.1f %8s %10.1f\n", "mean", (double)old_w / k, "",
+        (double)old_b / old_w, (double)new_w / k, "", (double)new_b / new_w);
+}
+
+using clk = std::chrono::steady_clock;
+
+int main(int argc, char** argv)
+{
+    size_t n = argc > 1 ? atoi(argv[1]) : 200000;
+    volatile int sink = 0;
+    printf("%-30s %10s %8s %10s %8s\n", "", "old ns", "allocs", "new ns", "allocs");
+    double old_sum = 0, new_sum = 0;
+    for(auto line : lines){
+        String str(line);
+        char buf[128];
+
+        allocs = 0;
+        auto t0 = clk::now();
+        for(size_t i = 0; i < n; i++) sink += old_find(str); //by value, as before
+        double old_ns = std::chrono::duration<double, std::nano>(clk::now() - t0).count() / n;
+        double old_allocs = (double)allocs / n;
+
+        allocs = 0;
+        t0 = clk::now();
+        for(size_t i = 0; i < n; i++){
+            const char* arg;
+            strcpy(buf, line);                  //line buffer filled by the server
+            sink += (intptr_t)Commander::find(buf, arg);
+        }
+        double new_ns = std::chrono::duration<double, std::nano>(clk::now() - t0).count() / n;
+        double new_allocs = (double)allocs / n;
+
+        printf("%-30s %10.1f %8.1f %10.1f %8.1f\n", line, old_ns, old_allocs, new_ns, new_allocs);
+        old_sum += old_ns;
+        new_sum += new_ns;
+    }
+    size_t k = sizeof(lines) / sizeof(lines[0]);
+    printf("%-30s %10.1f %8s %10.1f\n", "mean", old_sum / k, "", new_sum / k);
+    segments();
+    return 0;
+}
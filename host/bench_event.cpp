@@ -0,0 +1,117 @@
+//host benchmark- server event log (EventLog)
+//the cost of an event where it happens- the info() print it replaced (two
+//IPAddress Strings, a formatted line, then the line on uart0 at 115200,
+//which on the esp32 waits on the 128 byte tx fifo) against EventLog::put,
+//then writer threads putting events while a reader formats them, checked
+//for order and that every event is either read or counted as lost
+//
+//  make && build/bench_event [events]
+
+#include "EventLog.hpp"
+#include <WiFi.h>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+using clk = std::chrono::steady_clock;
+
+static double ns(clk::time_point t, size_t n)
+{
+    return std::chrono::duration<double, std::nano>(clk::now() - t).count() / n;
+}
+
+//the old info(), printed to a buffer in place of Serial -> chars
+static char out[256];
+static int old_info(const char* nam, const char* msg, int port, IPAddress remip = {0,0,0,0})
+{
+    return snprintf(out, sizeof(out), "Telnet Server | %5s | s%15s | p%5d | c%15s | %s\n",
+        nam, WiFi.localIP().toString().c_str(), port, (uint32_t)remip?remip.toString().c_str():"", msg
+    );
+}
+
+//writers put events with their own name and port = count, the reader checks
+//each writer's ports go up and counts lines and lost events
+static bool run(int writers, uint32_t n, uint32_t& seen, uint32_t& lost)
+{
+    static const char* names[] = { "w0", "w1", "w2", "w3" };
+    std::vector<std::thread> t;
+    std::atomic<int> done{0};
+    EventLog::reader_t r;
+    char buf[4096];
+    EventLog::reset(r);
+    while(EventLog::format(r, buf, sizeof(buf)));   //past what is in the ring
+    for(int w = 0; w < writers; w++){
+        t.emplace_back([&, w]{
+            for(uint32_t i = 0; i < n; i++){
+                EventLog::put(EventLog::NEW_CLIENT, EventLog::TELNET, names[w], i, 0x0100007F);
+            }
+            done++;
+        });
+    }
+    int last[4] = { -1, -1, -1, -1 };
+    bool ok = true;
+    seen = lost = 0;
+    for(;;){
+        bool fin = done == writers;
+        size_t len = EventLog::format(r, buf, sizeof(buf));
+        if(fin and not len) break;
+        for(char* p = buf; p < buf + len;){
+            char* e = (char*)memchr(p, '\n', buf + len - p);
+            *e = 0;
+            unsigned k;
+            if(sscanf(p, "event log | %u", &k) == 1) lost += k;
+            else {
+                char nam[8];
+                unsigned port;
+                if(sscanf(strchr(p, '|') + 1, " %7s | s%*s | p %u", nam, &port) != 2) ok = false;
+                int w = nam[1] - '0';
+                if(w < 0 or w >= writers or (int)port <= last[w]) ok = false;
+                else last[w] = port;
+                seen++;
+            }
+            p = e + 1;
+        }
+        if(not len) std::this_thread::yield();
+    }
+    for(auto& th : t) th.join();
+    return ok and seen + lost == writers * n;
+}
+
+int main(int argc, char** argv)
+{
+    uint32_t n = argc > 1 ? atoi(argv[1]) : 60000;
+    if(n > 0xFFFF) n = 0xFFFF;                  //the port is the count
+    IPAddress ip(192, 168, 123, 101);
+
+    auto t = clk::now();
+    size_t chars = 0;
+    for(uint32_t i = 0; i < n; i++) chars += old_info("uart2", "new client", 2302, ip);
+    double old_ns = ns(t, n);
+    double uart_us = chars / n * 10 / 0.1152;   //8N1 at 115200, us
+    t = clk::now();
+    for(uint32_t i = 0; i < n; i++) EventLog::put(EventLog::NEW_CLIENT, EventLog::TELNET, "uart2", 2302, ip);
+    double put_ns = ns(t, n);
+    printf("per event, where it happens\n");
+    printf("  info()         %8.1f ns format + %.0f us on uart0 (%u chars)\n", old_ns, uart_us, (unsigned)(chars / n));
+    printf("  EventLog::put  %8.1f ns\n", put_ns);
+
+    char buf[4096];
+    EventLog::reader_t r;
+    EventLog::reset(r);
+    t = clk::now();
+    size_t lines = 0;
+    for(size_t len; (len = EventLog::format(r, buf, sizeof(buf)));){
+        for(size_t i = 0; i < len; i++) lines += buf[i] == '\n';
+    }
+    printf("  format (reader) %7.1f ns per line, %u lines\n", ns(t, lines ? lines : 1), (unsigned)lines);
+
+    int rc = 0;
+    printf("writers putting %u events each, reader formatting (ring %u)\n", n, EventLog::RING);
+    for(int w = 1; w <= 4; w *= 2){
+        uint32_t seen, lost;
+        bool ok = run(w, n, seen, lost);
+        printf("  %d writer%s  %8u read %8u lost  %s\n", w, w > 1 ? "s" : " ", seen, lost, ok ? "ok" : "FAIL");
+        if(not ok) rc = 1;
+    }
+    return rc;
+}
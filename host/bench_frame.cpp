@@ -0,0 +1,157 @@
+//host benchmark- uart -> tcp packet framing (Framer)
+//delimiter search speed (SWAR Framer::find against a byte loop and memchr),
+//then each framing mode run over a ByteRing the way TelnetServer does
+//(data arriving in uart sized pieces, ring wrapping, one reader) with the
+//frames checked against the frames written
+//
+//  make && build/bench_frame [MB]
+//
+//the esp32 has 4 byte words, so find steps 4 bytes there (8 here)
+
+#include "Framer.hpp"
+#include <chrono>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+
+using bytes_t = std::vector<uint8_t>;
+using clk = std::chrono::steady_clock;
+
+static double secs(clk::time_point t){ return std::chrono::duration<double>(clk::now() - t).count(); }
+
+static size_t byte_find(const uint8_t* p, size_t len, uint8_t b)
+{
+    for(size_t i = 0; i < len; i++) if(p[i] == b) return i;
+    return len;
+}
+
+static size_t mem_find(const uint8_t* p, size_t len, uint8_t b)
+{
+    const void* r = memchr(p, b, len);
+    return r ? (const uint8_t*)r - p : len;
+}
+
+//log text, lines of 20-100 chars
+static bytes_t text(size_t n)
+{
+    bytes_t b;
+    while(b.size() < n){
+        size_t len = 20 + rand() % 80;
+        for(size_t i = 0; i < len; i++) b.push_back(' ' + rand() % 94);
+        b.push_back('\n');
+    }
+    b.resize(n);
+    return b;
+}
+
+//search speed- every frame end in buf, MB/s
+template<typename F>
+static double search(const bytes_t& buf, F f, size_t& found)
+{
+    auto t = clk::now();
+    found = 0;
+    for(size_t pos = 0; pos < buf.size(); found++){
+        pos += f(&buf[pos], buf.size() - pos, '\n') + 1;
+    }
+    return buf.size() / 1e6 / secs(t);
+}
+
+//frames of the mode (ends of frames in ends), piece sizes like uart rx
+static bytes_t frames(Framer::mode_t m, uint8_t arg, size_t n, std::vector<size_t>& ends)
+{
+    bytes_t b;
+    while(b.size() < n){
+        size_t len = 1 + rand() % 300;
+        if(m == Framer::LENGTH){
+            if(arg == 1 and len > 255) len = 255;
+            if(arg == 2) b.push_back(len >> 8);
+            b.push_back(len & 0xFF);
+            for(size_t i = 0; i < len; i++) b.push_back(rand());
+        } else {
+            uint8_t d = m == Framer::LINE ? '\n' : arg;
+            for(size_t i = 0; i < len; i++){
+                uint8_t c = rand();
+                b.push_back(c == d ? c + 1 : c);
+            }
+            b.push_back(d);
+        }
+        ends.push_back(b.size());
+    }
+    return b;
+}
+
+//stream through a ring, take each frame (max piece size max), check the
+//pieces end at the frame ends -> frames seen, or 0 if wrong
+static size_t run(Framer::mode_t m, uint8_t arg, size_t n, size_t max, double& mbs)
+{
+    std::vector<size_t> ends;
+    bytes_t data = frames(m, arg, n, ends);
+    Framer f;
+    f.set(m, arg);
+    ByteRing ring(4096);
+    size_t in = 0, cur = 0, pos = 0, e = 0, seen = 0;
+    auto t = clk::now();
+    while(cur < data.size()){
+        size_t len;
+        uint8_t* w = ring.write_span(len);
+        size_t k = 1 + rand() % 128;            //rx fifo/idle timeout piece
+        if(k > len) k = len;
+        if(k > data.size() - in) k = data.size() - in;
+        memcpy(w, &data[in], k);
+        ring.commit(k);
+        in += k;
+        for(;;){
+            size_t fl = f.next(ring, cur, pos, ring.head(), max, in == data.size());
+            if(not fl) break;
+            cur += fl;
+            ring.consume_to(cur);
+            while(e < ends.size() and ends[e] < cur) e++;
+            if(e < ends.size() and ends[e] == cur) seen++;
+            else if(fl != max) return 0;        //not a frame end, not a max piece
+        }
+    }
+    mbs = data.size() / 1e6 / secs(t);
+    return seen == ends.size() ? seen : 0;
+}
+
+int main(int argc, char** argv)
+{
+    size_t mb = argc > 1 ? atoi(argv[1]) : 32;
+    srand(1);
+    bytes_t buf = text(mb << 20);
+    printf("delimiter search, %u MB log text\n", (unsigned)mb);
+    size_t n1, n2, n3;
+    double byte = search(buf, byte_find, n1);
+    double swar = search(buf, Framer::find, n2);
+    double mem = search(buf, mem_find, n3);
+    printf("  byte loop %8.0f MB/s\n  swar      %8.0f MB/s\n  memchr    %8.0f MB/s\n", byte, swar, mem);
+    if(n1 != n2 or n1 != n3){ printf("  FAIL found %u/%u/%u\n", (unsigned)n1, (unsigned)n2, (unsigned)n3); return 1; }
+    //binary data, delimiter rare
+    for(auto& c : buf) c = rand() % 255 + 1;
+    byte = search(buf, byte_find, n1);
+    swar = search(buf, Framer::find, n2);
+    mem = search(buf, mem_find, n3);
+    printf("delimiter search, %u MB binary (1 in 64K)\n", (unsigned)mb);
+    printf("  byte loop %8.0f MB/s\n  swar      %8.0f MB/s\n  memchr    %8.0f MB/s\n", byte, swar, mem);
+    if(n1 != n2 or n1 != n3){ printf("  FAIL found %u/%u/%u\n", (unsigned)n1, (unsigned)n2, (unsigned)n3); return 1; }
+
+    printf("framing through a 4096 byte ring, %u MB, max piece 1436\n", (unsigned)mb);
+    struct { Framer::mode_t m; uint8_t arg; } modes[] = {
+        { Framer::LINE, 0 }, { Framer::DELIM, 0x7E }, { Framer::LENGTH, 1 }, { Framer::LENGTH, 2 },
+    };
+    int rc = 0;
+    for(auto& t : modes){
+        double mbs = 0;
+        size_t seen = run(t.m, t.arg, mb << 20, 1436, mbs);
+        printf("  %-6s %3u  %8u frames %8.0f MB/s %s\n", Framer::name(t.m), t.arg,
+            (unsigned)seen, mbs, seen ? "ok" : "FAIL");
+        if(not seen) rc = 1;
+    }
+    //frames longer than the max piece (length 2, up to 300) still line up
+    double mbs;
+    size_t seen = run(Framer::LENGTH, 2, 1 << 20, 64, mbs);
+    printf("  length   2  %8u frames (max piece 64) %s\n", (unsigned)seen, seen ? "ok" : "FAIL");
+    if(not seen) rc = 1;
+    return rc;
+}
@@ -0,0 +1,180 @@
+//host benchmark- Lz stream compression
+//per corpus- compression ratio, encode and decode speed, round trip check,
+//with the stream fed in pieces the way the bridge does (LZ_CHUNK bytes per
+//encode, window carried across)
+//
+//  make && build/bench_lz [file ...]
+//
+//with no files, generated corpora stand in for typical target output-
+//  boot log    esp-idf style boot messages, repeated reboots
+//  app log     timestamped log lines, a few formats with changing values
+//  hex dump    memory dump lines (address, hex bytes, ascii)
+//  random      incompressible (worst case, all literals)
+//
+//cpu per KB on the esp32 is shown by the info console (stats show), the
+//host numbers here are for comparing changes
+
+#include "Lz.hpp"
+#include <chrono>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <vector>
+
+using bytes_t = std::vector<uint8_t>;
+using clk = std::chrono::steady_clock;
+
+static const size_t CHUNK = 512;                //TelnetServer::LZ_CHUNK
+
+static void add(bytes_t& b, const char* s){ b.insert(b.end(), s, s + strlen(s)); }
+
+static bytes_t boot_log(size_t n)
+{
+    static const char* lines[] = {
+        "ets Jun  8 2016 00:22:57\r\n\r\n",
+        "rst:0x1 (POWERON_RESET),boot:0x13 (SPI_FAST_FLASH_BOOT)\r\n",
+        "configsip: 0, SPIWP:0xee\r\n",
+        "clk_drv:0x00,q_drv:0x00,d_drv:0x00,cs0_drv:0x00,hd_drv:0x00,wp_drv:0x00\r\n",
+        "mode:DIO, clock div:1\r\n",
+        "load:0x3fff0018,len:4\r\n",
+        "load:0x3fff001c,len:1044\r\n",
+        "load:0x40078000,len:8896\r\n",
+        "load:0x40080400,len:5816\r\n",
+        "entry 0x400806ac\r\n",
+        "I (29) boot: ESP-IDF v3.1 2nd stage bootloader\r\n",
+        "I (29) boot: compile time 08:00:00\r\n",
+        "I (31) boot: Enabling RNG early entropy source...\r\n",
+        "I (36) boot: SPI Speed      : 40MHz\r\n",
+        "I (40) boot: SPI Mode       : DIO\r\n",
+        "I (44) boot: SPI Flash Size : 4MB\r\n",
+        "I (48) boot: Partition Table:\r\n",
+        "I (52) boot: ## Label            Usage          Type ST Offset   Length\r\n",
+    };
+    bytes_t b;
+    char s[128];
+    for(unsigned boot = 0; b.size() < n; boot++){
+        for(auto l : lines) add(b, l);
+        for(unsigned i = 0; i < 40 and b.size() < n; i++){
+            snprintf(s, sizeof s, "I (%u) wifi: state: run -> auth (%x), rssi %d\r\n",
+                1000 + boot * 7 + i * 13, i & 0xf, -40 - (int)(i % 30));
+            add(b, s);
+        }
+    }
+    b.resize(n);
+    return b;
+}
+
+static bytes_t app_log(size_t n)
+{
+    bytes_t b;
+    char s[160];
+    srand(1);
+    for(unsigned t = 0; b.size() < n; t += rand() % 50){
+        switch(rand() % 4){
+            case 0: snprintf(s, sizeof s, "[%7u.%03u] sensor: temp=%d.%dC hum=%d%%\r\n",
+                t / 1000, t % 1000, 20 + rand() % 5, rand() % 10, 40 + rand() % 20); break;
+            case 1: snprintf(s, sizeof s, "[%7u.%03u] net: tx %u bytes to 192.168.1.%u:%u\r\n",
+                t / 1000, t % 1000, rand() % 1500, rand() % 255, 1024 + rand() % 1000); break;
+            case 2: snprintf(s, sizeof s, "[%7u.%03u] motor: pos=%d target=%d pwm=%u\r\n",
+                t / 1000, t % 1000, rand() % 4096, rand() % 4096, rand() % 1024); break;
+            default: snprintf(s, sizeof s, "[%7u.%03u] main: loop ok, free heap %u\r\n",
+                t / 1000, t % 1000, 150000 + rand() % 1000); break;
+        }
+        add(b, s);
+    }
+    b.resize(n);
+    return b;
+}
+
+static bytes_t hex_dump(size_t n)
+{
+    bytes_t b;
+    char s[128];
+    srand(2);
+    uint8_t mem[16];
+    for(unsigned a = 0x3ffb0000; b.size() < n; a += 16){
+        for(auto& m : mem) m = rand() % 4 ? 0 : rand();   //mostly zero, like ram
+        int k = snprintf(s, sizeof s, "%08x: ", a);
+        for(auto m : mem) k += snprintf(s + k, sizeof s - k, "%02x ", m);
+        k += snprintf(s + k, sizeof s - k, " |");
+        for(auto m : mem) s[k++] = m >= ' ' and m < 127 ? m : '.';
+        snprintf(s + k, sizeof s - k, "|\r\n");
+        add(b, s);
+    }
+    b.resize(n);
+    return b;
+}
+
+static bytes_t random_bytes(size_t n)
+{
+    bytes_t b(n);
+    srand(3);
+    for(auto& c : b) c = rand();
+    return b;
+}
+
+static void run(const char* name, const bytes_t& in)
+{
+    LzEncoder enc;
+    LzDecoder dec;
+    bytes_t z(LzEncoder::bound(in.size()) + in.size() / CHUNK + 1);
+    bytes_t out(in.size() + 1024);
+    const int reps = 20;
+    size_t zn = 0;
+    auto t0 = clk::now();
+    for(int r = 0; r < reps; r++){
+        enc.start();
+        zn = 0;
+        for(size_t i = 0; i < in.size(); i += CHUNK){
+            size_t n = in.size() - i < CHUNK ? in.size() - i : CHUNK;
+            zn += enc.encode(&in[i], n, &z[zn]);
+        }
+    }
+    double enc_s = std::chrono::duration<double>(clk::now() - t0).count() / reps;
+    //decode in odd sized pieces (tokens split across reads)
+    size_t on = 0;
+    t0 = clk::now();
+    for(int r = 0; r < reps; r++){
+        dec.start();
+        on = 0;
+        for(size_t i = 0; i < zn; i += 1000){
+            size_t n = zn - i < 1000 ? zn - i : 1000;
+            bytes_t tmp(LzDecoder::bound(n));
+            size_t k = dec.decode(&z[i], n, tmp.data());
+            if(on + k > out.size()) out.resize(on + k);
+            memcpy(&out[on], tmp.data(), k);
+            on += k;
+        }
+    }
+    double dec_s = std::chrono::duration<double>(clk::now() - t0).count() / reps;
+    bool ok = on == in.size() and not memcmp(out.data(), in.data(), on);
+    printf("%-12s %9zu %9zu %6.2f:1 %8.1f %8.1f  %s\n", name, in.size(), zn,
+        (double)in.size() / zn, in.size() / enc_s / 1e6, in.size() / dec_s / 1e6,
+        ok ? "ok" : "MISMATCH");
+    if(not ok) exit(1);
+}
+
+int main(int argc, char** argv)
+{
+    printf("%-12s %9s %9s %8s %8s %8s\n", "corpus", "bytes", "lz bytes", "ratio", "enc MB/s", "dec MB/s");
+    if(argc > 1){
+        for(int a = 1; a < argc; a++){
+            FILE* f = fopen(argv[a], "rb");
+            if(not f){ perror(argv[a]); return 1; }
+            bytes_t b;
+            uint8_t buf[4096];
+            for(size_t n; (n = fread(buf, 1, sizeof buf, f)) > 0;) b.insert(b.end(), buf, buf + n);
+            fclose(f);
+            const char* s = strrchr(argv[a], '/');
+            run(s ? s + 1 : argv[a], b);
+        }
+        return 0;
+    }
+    const size_t n = 1 << 20;
+    run("boot log", boot_log(n));
+    run("app log", app_log(n));
+    run("hex dump", hex_dump(n));
+    run("random", random_bytes(n));
+    return 0;
+}
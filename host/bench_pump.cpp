@@ -0,0 +1,129 @@
+//host benchmark- uart/tcp bridge pump
+//compares the original 128 byte stack bounce buffer pump with the ByteRing
+//span pump used by TelnetServer::handler_uart
+//
+//  make && build/bench_pump [MB]
+//
+//the uart driver and the socket are modelled as memory, every memcpy of
+//payload is counted so copies/byte can be reported for each direction
+
+#include "ByteRing.hpp"
+#include <chrono>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+
+//=====================
+// simulated endpoints
+//=====================
+
+static uint64_t copies;                         //payload bytes copied
+
+//uart driver rx queue / socket rx- hands out up to n bytes per call
+struct Source {
+    std::vector<uint8_t> data;
+    size_t pos{0};
+    size_t burst;                               //max bytes ready per call
+    Source(size_t n, size_t b) : data(n), burst(b) {
+        for(size_t i = 0; i < n; i++) data[i] = rand();
+    }
+    size_t ready(){ size_t r = data.size() - pos; return r < burst ? r : burst; }
+    size_t read(uint8_t* p, size_t n){
+        if(n > ready()) n = ready();
+        memcpy(p, &data[pos], n); copies += n; pos += n;
+        return n;
+    }
+    bool done(){ return pos == data.size(); }
+};
+
+//socket tx / uart tx fifo- accepts up to n bytes per call
+struct Sink {
+    std::vector<uint8_t> data;
+    size_t pos{0};
+    size_t window;                              //max bytes accepted per call
+    Sink(size_t n, size_t w) : data(n), window(w) {}
+    size_t write(const uint8_t* p, size_t n){
+        if(n > window) n = window;
+        memcpy(&data[pos], p, n); copies += n; pos += n;
+        return n;
+    }
+};
+
+//WiFiClient rx buffer (the extra copy the old tcp->uart path made)
+struct ClientRxBuffer {
+    uint8_t buf[1436];
+    size_t len{0}, pos{0};
+    size_t read(Source& s, uint8_t* p, size_t n){
+        if(pos == len){ pos = 0; len = s.read(buf, sizeof buf); }
+        if(n > len - pos) n = len - pos;
+        memcpy(p, &buf[pos], n); copies += n; pos += n;
+        return n;
+    }
+};
+
+//=====================
+// pumps
+//=====================
+
+//original- driver -> stack buf -> socket, 128 bytes max per pass
+static void bounce_uart_to_net(Source& src, Sink& dst)
+{
+    uint8_t buf[128];
+    while(not src.done()){
+        size_t len = src.read(buf, sizeof buf);
+        for(size_t i = 0; i < len; i += dst.write(&buf[i], len - i));
+    }
+}
+//original- socket -> client rx buffer -> stack buf -> uart, 128 max per pass
+static void bounce_net_to_uart(Source& src, Sink& dst)
+{
+    ClientRxBuffer rxb;
+    uint8_t buf[128];
+    while(not src.done() or rxb.pos != rxb.len){
+        size_t len = rxb.read(src, buf, sizeof buf);
+        for(size_t i = 0; i < len; i += dst.write(&buf[i], len - i));
+    }
+}
+//ring- source -> ring span -> sink, span size limited only by each side
+static void ring_pump(Source& src, Sink& dst, ByteRing& ring, size_t chunk)
+{
+    while(not src.done() or ring.used()){
+        size_t len;
+        uint8_t* p = ring.write_span(len);
+        if(len > chunk) len = chunk;
+        if(len) ring.commit(src.read(p, len));
+        p = ring.read_span(len);
+        if(len > chunk) len = chunk;
+        if(len) ring.consume(dst.write(p, len));
+    }
+}
+
+//=====================
+// main
+//=====================
+
+template<typename F>
+static void run(const char* name, size_t n, F f)
+{
+    copies = 0;
+    auto t0 = std::chrono::steady_clock::now();
+    f();
+    double s = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+    //source read + sink write are the driver/stack copies, the rest are ours
+    printf("%-28s %10.1f MB/s  copies/byte %.2f\n", name, n / s / 1e6, (double)copies / n);
+}
+
+int main(int argc, char** argv)
+{
+    size_t n = (argc > 1 ? atoi(argv[1]) : 64) * 1000000;
+
+    {   Source s(n, 4096); Sink d(n, 1460);
+        run("uart->tcp bounce[128]", n, [&]{ bounce_uart_to_net(s, d); }); }
+    {   Source s(n, 4096); Sink d(n, 1460); ByteRing r(4096);
+        run("uart->tcp ring span", n, [&]{ ring_pump(s, d, r, 4096); }); }
+    {   Source s(n, 1460); Sink d(n, 127);
+        run("tcp->uart bounce[128]", n, [&]{ bounce_net_to_uart(s, d); }); }
+    {   Source s(n, 1460); Sink d(n, 127); ByteRing r(2048);
+        run("tcp->uart ring span", n, [&]{ ring_pump(s, d, r, 2048); }); }
+}
@@ -0,0 +1,115 @@
+//host benchmark- telnet protocol engine
+//raw mode vs telnet mode, random payload and 0xFF heavy payload
+//
+//  make && build/bench_telnet [MB]
+//
+//uart -> net is modelled as TelnetServer::pump_uart_to_net does it
+//(plain() spans sent as is, IAC runs escaped), net -> uart as decode() in
+//place on 1460 byte segments, and the decoded output is checked against
+//the original payload
+
+#include "Telnet.hpp"
+#include <chrono>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+
+using bytes_t = std::vector<uint8_t>;
+
+//random payload, ff = percent of bytes that are 0xFF
+static bytes_t payload(size_t n, int ff)
+{
+    bytes_t v(n);
+    for(auto& b : v){
+        b = rand() % 100 < ff ? 0xFF : rand() % 255;
+    }
+    return v;
+}
+
+//uart -> net, appends to out (the 'socket')
+static void encode(Telnet& t, const bytes_t& in, bytes_t& out, bool telnet, size_t chunk)
+{
+    size_t len;
+    for(size_t i = 0; i < in.size(); ){
+        const uint8_t* o = t.out(len);
+        if(len){ out.insert(out.end(), o, o + len); t.sent(len); }
+        len = in.size() - i;
+        if(len > chunk) len = chunk;
+        const uint8_t* p = &in[i];
+        if(telnet){
+            size_t k = t.plain(p, len);
+            if(k == 0){
+                for(; k < len and p[k] == Telnet::IAC and t.escape(); k++);
+                i += k;
+                continue;
+            }
+            len = k;
+        }
+        out.insert(out.end(), p, p + len);
+        i += len;
+    }
+    const uint8_t* o = t.out(len);
+    out.insert(out.end(), o, o + len);
+    t.sent(len);
+}
+
+//net -> uart, decode in place per segment
+static size_t decode(Telnet& t, bytes_t& in, bool telnet, size_t seg)
+{
+    size_t o = 0;
+    for(size_t i = 0; i < in.size(); i += seg){
+        size_t len = in.size() - i < seg ? in.size() - i : seg;
+        size_t n = telnet ? t.decode(&in[i], len) : len;
+        memmove(&in[o], &in[i], n);             //stand in for ring commit
+        o += n;
+    }
+    in.resize(o);
+    return o;
+}
+
+static double secs(std::chrono::steady_clock::time_point t0)
+{
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+}
+
+static void run(const char* name, size_t n, int ff, bool telnet)
+{
+    bytes_t in = payload(n, ff);
+    bytes_t wire;
+    wire.reserve(n * 2 + 64);
+    Telnet tx, rx;
+    if(telnet){
+        tx.start();
+        //negotiate binary both ways, client side acks our requests
+        const uint8_t acks[] = { 255,253,1, 255,253,3, 255,251,3, 255,253,0, 255,251,0 };
+        bytes_t a(acks, acks + sizeof acks);
+        tx.decode(&a[0], a.size());
+        rx.start();
+        a.assign(acks, acks + sizeof acks);
+        rx.decode(&a[0], a.size());
+        size_t len;
+        tx.out(len); tx.sent(len);
+        rx.out(len); rx.sent(len);
+    }
+    auto t0 = std::chrono::steady_clock::now();
+    encode(tx, in, wire, telnet, 4096);
+    double te = secs(t0);
+    size_t wn = wire.size();
+    t0 = std::chrono::steady_clock::now();
+    decode(rx, wire, telnet, 1460);
+    double td = secs(t0);
+    printf("%-8s %-10s  uart->net %8.1f MB/s  net->uart %8.1f MB/s  wire %5.3fx  %s\n",
+        telnet ? "telnet" : "raw", name, n / te / 1e6, n / td / 1e6,
+        (double)wn / n, wire == in ? "ok" : "MISMATCH");
+}
+
+int main(int argc, char** argv)
+{
+    size_t n = (argc > 1 ? atoi(argv[1]) : 32) * 1000000;
+    run("random",   n, 0,  false);
+    run("random",   n, 0,  true);
+    run("ff 1%",    n, 1,  true);
+    run("ff 50%",   n, 50, false);
+    run("ff 50%",   n, 50, true);
+}
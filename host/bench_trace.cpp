@@ -0,0 +1,99 @@
+//host benchmark- Trace
+//cost of one TRACE() against a Serial.printf style formatted line, then a
+//stress run- producer threads trace as fast as they can while the encoder
+//drains, the stream is parsed and checked (no torn records, per thread
+//values in order, records + lost = traced)
+//
+//  make && build/bench_trace [millions]
+//
+//the host ESP.getCycleCount reads a steady clock, so a trace point here
+//costs more than on the esp32 (where it is one rsr ccount)
+
+#include "Trace.hpp"
+#include <atomic>
+#include <chrono>
+#include <thread>
+
+using clk = std::chrono::steady_clock;
+
+static double ns(clk::time_point t0, size_t n)
+{
+    return std::chrono::duration<double, std::nano>(clk::now() - t0).count() / n;
+}
+
+static uint32_t get32(const uint8_t* p)
+{
+    return p[0] | p[1] << 8 | p[2] << 16 | (uint32_t)p[3] << 24;
+}
+
+//trace points for the stress threads (id from file, function, name)
+static void producer(int t, uint32_t n)
+{
+    for(uint32_t i = 0; i < n; i++){
+        if(t == 0) TRACE("thread0", i);
+        else TRACE("thread1", i);
+    }
+}
+
+int main(int argc, char** argv)
+{
+    size_t n = (argc > 1 ? atoi(argv[1]) : 10) * 1000000;
+
+    //cost per call
+    auto t0 = clk::now();
+    for(size_t i = 0; i < n; i++) TRACE("loop", i);
+    double trace_ns = ns(t0, n);
+    char line[64];
+    size_t m = n / 10;
+    t0 = clk::now();
+    for(size_t i = 0; i < m; i++) snprintf(line, sizeof line, ":%08X:%08X\n", 0x12345678u, (unsigned)i);
+    printf("TRACE()          %8.1f ns/call\n", trace_ns);
+    printf("snprintf line    %8.1f ns/call (formatting only, no uart)\n", ns(t0, m));
+
+    //stress- 2 producers, encoder drains and each buffer is parsed (the
+    //encoder only writes whole records)
+    Trace::reset();
+    std::atomic<int> running{2};
+    auto run = [&](int t){ producer(t, n); running--; };
+    std::thread a(run, 0), b(run, 1);
+    uint8_t buf[1024];
+    bool header = true;
+    uint32_t ids[2] = {};
+    uint64_t records = 0, torn = 0;
+    int64_t last[2] = { -1, -1 };
+    for(;;){
+        bool idle = not running;
+        size_t k = Trace::encode(buf, sizeof buf);
+        if(not k and idle) break;
+        size_t i = 0;
+        if(header){ i = 8; header = false; }
+        while(i < k){
+            uint32_t id = get32(&buf[i]);
+            if(id == Trace::META_ID){
+                uint32_t mid = get32(&buf[i + 4]);
+                const char* f = (const char*)&buf[i + 10];
+                const char* fn = f + strlen(f) + 1;
+                const char* nam = fn + strlen(fn) + 1;
+                if(not strcmp(nam, "thread0")) ids[0] = mid;
+                if(not strcmp(nam, "thread1")) ids[1] = mid;
+                i = (const uint8_t*)(nam + strlen(nam) + 1) - buf;
+                continue;
+            }
+            uint32_t v = get32(&buf[i + 8]);
+            i += Trace::REC_SIZE;
+            int t = id == ids[0] ? 0 : id == ids[1] ? 1 : -1;
+            if(t < 0) continue;                 //lost, or "loop" records still in the ring
+            if((int64_t)v <= last[t]) torn++;
+            last[t] = v;
+            records++;
+        }
+    }
+    a.join();
+    b.join();
+    //the "loop" records in the ring at reset are part of the lost count
+    uint64_t lost = Trace::lost();
+    printf("stress           %llu records, %llu lost, %llu traced, %llu out of order\n",
+        (unsigned long long)records, (unsigned long long)lost,
+        (unsigned long long)(2 * n), (unsigned long long)torn);
+    return torn ? 1 : 0;
+}
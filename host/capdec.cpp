@@ -0,0 +1,133 @@
+//host tool- decode a uart capture (Capture.hpp format, from http /uart<n>/capture)
+//
+//  make && build/capdec [-p] uart2.cap [out]
+//      text (default)- one line per record, time from capture start,
+//                      time since the previous record, direction, length,
+//                      then the data as hex and ascii, 16 bytes per line
+//      -p  pcap, link type USER0 (147)- each packet is one direction byte
+//          (0 = rx from target, 1 = tx to target) then the data, packet
+//          time is the esp32 micros() of the record
+//
+//out defaults to stdout
+
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+#include <vector>
+
+using bytes_t = std::vector<uint8_t>;
+
+static uint32_t get32(const uint8_t* p)
+{
+    return p[0] | p[1] << 8 | p[2] << 16 | (uint32_t)p[3] << 24;
+}
+
+//-> false if past end
+static bool varint(const bytes_t& b, size_t& i, uint32_t& v)
+{
+    v = 0;
+    for(int shift = 0; i < b.size() and shift < 35; shift += 7){
+        uint8_t c = b[i++];
+        v |= (uint32_t)(c & 0x7F) << shift;
+        if(not (c & 0x80)) return true;
+    }
+    return false;
+}
+
+static void put32(FILE* f, uint32_t v){ fwrite(&v, 4, 1, f); }   //host order
+static void put16(FILE* f, uint16_t v){ fwrite(&v, 2, 1, f); }
+
+static void text(FILE* f, uint64_t t, uint32_t dt, uint8_t dir, const uint8_t* p, uint32_t len)
+{
+    for(uint32_t i = 0; i < len or i == 0; i += 16){
+        if(i == 0){
+            fprintf(f, "%4u.%06u +%8u %s %5u  ", (unsigned)(t / 1000000), (unsigned)(t % 1000000),
+                dt, dir ? "tx" : "rx", len);
+        } else {
+            fprintf(f, "%32s", "");
+        }
+        char asc[17] = {};
+        for(uint32_t j = 0; j < 16; j++){
+            if(i + j < len){
+                uint8_t c = p[i + j];
+                fprintf(f, "%02x ", c);
+                asc[j] = c >= ' ' and c < 127 ? c : '.';
+            } else {
+                fprintf(f, "   ");
+            }
+        }
+        fprintf(f, " %s\n", asc);
+    }
+}
+
+int main(int argc, char** argv)
+{
+    bool pcap = false;
+    int a = 1;
+    if(a < argc and not strcmp(argv[a], "-p")){ pcap = true; a++; }
+    if(a >= argc){
+        fprintf(stderr, "usage: %s [-p] uart2.cap [out]\n", argv[0]);
+        return 2;
+    }
+    FILE* in = fopen(argv[a], "rb");
+    if(not in){ perror(argv[a]); return 1; }
+    bytes_t b;
+    uint8_t buf[4096];
+    for(size_t n; (n = fread(buf, 1, sizeof buf, in)) > 0;) b.insert(b.end(), buf, buf + n);
+    fclose(in);
+    FILE* out = a + 1 < argc ? fopen(argv[a + 1], pcap ? "wb" : "w") : stdout;
+    if(not out){ perror(argv[a + 1]); return 1; }
+
+    if(b.size() < 16 or memcmp(&b[0], "U2CP", 4) or b[4] != 1){
+        fprintf(stderr, "not a uart capture (version 1)\n");
+        return 1;
+    }
+    uint32_t baud = get32(&b[8]);
+    uint32_t start = get32(&b[12]);
+
+    if(pcap){
+        put32(out, 0xA1B2C3D4);
+        put16(out, 2);
+        put16(out, 4);
+        put32(out, 0);                          //gmt offset
+        put32(out, 0);                          //accuracy
+        put32(out, 65536);                      //snap length
+        put32(out, 147);                        //LINKTYPE_USER0
+    } else {
+        fprintf(out, "# uart capture, %u baud\n", baud);
+        fprintf(out, "#  time (s)       +us dir   len  data\n");
+    }
+
+    uint64_t t = 0;                             //us from start
+    size_t i = 16;
+    unsigned records = 0;
+    uint32_t bytes[2] = {};
+    while(i < b.size()){
+        uint8_t dir = b[i++];
+        uint32_t dt, len;
+        if(dir > 1 or not varint(b, i, dt) or not varint(b, i, len) or i + len > b.size()){
+            fprintf(stderr, "bad record at offset %zu\n", i);
+            break;
+        }
+        t += dt;
+        const uint8_t* p = &b[i];
+        i += len;
+        records++;
+        bytes[dir] += len;
+        if(pcap){
+            uint64_t us = start + t;
+            put32(out, us / 1000000);
+            put32(out, us % 1000000);
+            put32(out, len + 1);
+            put32(out, len + 1);
+            fwrite(&dir, 1, 1, out);
+            fwrite(p, 1, len, out);
+        } else {
+            text(out, t, dt, dir, p, len);
+        }
+    }
+    fprintf(stderr, "%u records, rx %u bytes, tx %u bytes, %.6f s\n",
+        records, bytes[0], bytes[1], t / 1e6);
+    if(out != stdout) fclose(out);
+    return 0;
+}
@@ -0,0 +1,125 @@
+//host tool- telnet client for a bridge port with compression (Lz.hpp)
+//
+//  make && build/lzcat [host [port]]        (default localhost 2302)
+//
+//asks for the private LZ option (IAC DO 88), then decodes the stream-
+//telnet commands are dropped, IAC IAC unescaped, data after the server's
+//WILL LZ is lz tokens (plain again after WONT LZ), uart data goes to
+//stdout, stdin is sent to the uart (IAC escaped)
+//
+//on exit (eof/ctrl-c) the bytes received and the ratio go to stderr
+
+#include "Lz.hpp"
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <netdb.h>
+#include <poll.h>
+#include <unistd.h>
+#include <vector>
+#include <sys/socket.h>
+
+enum : uint8_t { SE = 240, SB = 250, WILL = 251, WONT = 252, DO = 253, DONT = 254, IAC = 255 };
+static const uint8_t LZ = 88;
+
+static size_t net_bytes, lz_bytes, uart_bytes;
+
+static void done(int)
+{
+    fprintf(stderr, "\n%zu bytes received, %zu lz -> %zu uart bytes", net_bytes, lz_bytes, uart_bytes);
+    if(lz_bytes) fprintf(stderr, " (%.2f:1)", (double)uart_bytes / lz_bytes);
+    fprintf(stderr, "\n");
+    exit(0);
+}
+
+static int tcp_connect(const char* host, const char* port)
+{
+    addrinfo hints{}, *res;
+    hints.ai_socktype = SOCK_STREAM;
+    if(getaddrinfo(host, port, &hints, &res)){ fprintf(stderr, "%s: unknown host\n", host); exit(1); }
+    int fd = socket(res->ai_family, res->ai_socktype, res->ai_protocol);
+    if(fd < 0 or connect(fd, res->ai_addr, res->ai_addrlen)){ perror("connect"); exit(1); }
+    freeaddrinfo(res);
+    return fd;
+}
+
+int main(int argc, char** argv)
+{
+    int fd = tcp_connect(argc > 1 ? argv[1] : "localhost", argc > 2 ? argv[2] : "2302");
+    signal(SIGINT, done);
+    const uint8_t ask[] = { IAC, DO, LZ };
+    send(fd, ask, sizeof ask, MSG_NOSIGNAL);
+
+    enum { DATA, CMD, OPT, SUB, SUBIAC } state = DATA;
+    uint8_t cmd = 0;
+    bool lz = false;
+    LzDecoder dec;
+    std::vector<uint8_t> data, out;
+    pollfd pf[2] = { { fd, POLLIN, 0 }, { 0, POLLIN, 0 } };
+    uint8_t buf[4096];
+    for(;;){
+        if(poll(pf, pf[1].fd < 0 ? 1 : 2, -1) <= 0) break;
+        if(pf[1].revents){
+            ssize_t r = read(0, buf, sizeof buf);
+            if(r <= 0){ pf[1].fd = -1; continue; }
+            std::vector<uint8_t> tx;
+            for(ssize_t i = 0; i < r; i++){
+                tx.push_back(buf[i]);
+                if(buf[i] == IAC) tx.push_back(IAC);
+            }
+            send(fd, tx.data(), tx.size(), MSG_NOSIGNAL);
+        }
+        if(not pf[0].revents) continue;
+        ssize_t r = recv(fd, buf, sizeof buf, 0);
+        if(r <= 0) break;
+        net_bytes += r;
+        //telnet- data runs between commands, decoded (lz) as they end
+        data.clear();
+        auto flush = [&]{
+            if(data.empty()) return;
+            if(lz){
+                out.resize(LzDecoder::bound(data.size()));
+                size_t n = dec.decode(data.data(), data.size(), out.data());
+                lz_bytes += data.size();
+                uart_bytes += n;
+                fwrite(out.data(), 1, n, stdout);
+            } else {
+                uart_bytes += data.size();
+                fwrite(data.data(), 1, data.size(), stdout);
+            }
+            data.clear();
+        };
+        for(ssize_t i = 0; i < r; i++){
+            uint8_t c = buf[i];
+            switch(state){
+                case DATA:
+                    if(c == IAC) state = CMD;
+                    else data.push_back(c);
+                    break;
+                case CMD:
+                    if(c == IAC){ data.push_back(c); state = DATA; }
+                    else if(c == SB) state = SUB;
+                    else if(c >= WILL){ cmd = c; state = OPT; }
+                    else state = DATA;
+                    break;
+                case OPT:
+                    state = DATA;
+                    if(c != LZ) break;
+                    flush();                    //data before the switch
+                    if(cmd == WILL and not lz){ lz = true; dec.start(); }
+                    if(cmd == WONT) lz = false;
+                    break;
+                case SUB:
+                    if(c == IAC) state = SUBIAC;
+                    break;
+                case SUBIAC:
+                    state = c == SE ? DATA : SUB;
+                    break;
+            }
+        }
+        flush();
+        fflush(stdout);
+    }
+    done(0);
+}
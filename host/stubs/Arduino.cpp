@@ -0,0 +1,101 @@
+#include "Arduino.h"
+#include "esp_timer.h"
+#include <chrono>
+#include <thread>
+#include <signal.h>
+#include <unistd.h>
+
+HardwareSerial Serial(0);
+HardwareSerial Serial1(1);
+HardwareSerial Serial2(2);
+EspClass ESP;
+
+//=====================
+// local functions
+//=====================
+
+using clk = std::chrono::steady_clock;
+static const clk::time_point t0 = clk::now();
+
+//lwip has no SIGPIPE, a send to a closed socket just fails
+static struct Init { Init(){ signal(SIGPIPE, SIG_IGN); } } init;
+
+//=====================
+// time, pins, timers
+//=====================
+
+uint32_t millis()
+{
+    return std::chrono::duration_cast<std::chrono::milliseconds>(clk::now() - t0).count();
+}
+uint32_t micros()
+{
+    return std::chrono::duration_cast<std::chrono::microseconds>(clk::now() - t0).count();
+}
+int64_t esp_timer_get_time()
+{
+    return std::chrono::duration_cast<std::chrono::microseconds>(clk::now() - t0).count();
+}
+void delay(uint32_t ms){ std::this_thread::sleep_for(std::chrono::milliseconds(ms)); }
+void delayMicroseconds(uint32_t us){ std::this_thread::sleep_for(std::chrono::microseconds(us)); }
+
+void pinMode(uint8_t, uint8_t){}
+void digitalWrite(uint8_t, uint8_t){}
+int digitalRead(uint8_t){ return HIGH; }
+void attachInterrupt(uint8_t, void (*)(), int){}
+
+hw_timer_t* timerBegin(uint8_t, uint16_t, bool){ return nullptr; }
+void timerAttachInterrupt(hw_timer_t*, void (*)(), bool){}
+void timerAlarmWrite(hw_timer_t*, uint64_t, bool){}
+void timerAlarmEnable(hw_timer_t*){}
+
+//=====================
+// Print, Stream
+//=====================
+
+size_t Print::printf(const char* fmt, ...)
+{
+    char buf[256];
+    char* p = buf;
+    va_list ap;
+    va_start(ap, fmt);
+    int n = vsnprintf(buf, sizeof buf, fmt, ap);
+    va_end(ap);
+    if(n < 0) return 0;
+    if(n >= (int)sizeof buf){                   //too big for stack buffer
+        p = (char*)malloc(n + 1);
+        va_start(ap, fmt);
+        vsnprintf(p, n + 1, fmt, ap);
+        va_end(ap);
+    }
+    n = write((const uint8_t*)p, n);
+    if(p != buf) free(p);
+    return n;
+}
+
+size_t Stream::readBytes(uint8_t* p, size_t n)
+{
+    size_t i = 0;
+    uint32_t t = millis();
+    while(i < n){
+        int c = read();
+        if(c >= 0){ p[i++] = c; continue; }
+        if(millis() - t >= m_timeout) break;
+    }
+    return i;
+}
+
+//=====================
+// ESP
+//=====================
+
+void EspClass::restart()
+{
+    printf("ESP.restart()\n");
+    exit(0);
+}
+
+uint32_t EspClass::getCycleCount()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(clk::now() - t0).count() * 240 / 1000;
+}
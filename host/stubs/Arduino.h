@@ -0,0 +1,194 @@
+#pragma once
+
+//host stand-in for the esp32 arduino core
+//only what the sketch sources use- String, Print/Stream, HardwareSerial
+//(stdout), time, pins, timers, ESP
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <stdarg.h>
+#include <string>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+#define IRAM_ATTR
+
+#define INPUT           0x01
+#define OUTPUT          0x02
+#define INPUT_PULLUP    0x05
+#define LOW             0
+#define HIGH            1
+
+//esp32-hal-uart.h config values
+#define SERIAL_5N1 0x8000010
+#define SERIAL_6N1 0x8000014
+#define SERIAL_7N1 0x8000018
+#define SERIAL_8N1 0x800001c
+#define SERIAL_8N2 0x800003c
+#define SERIAL_8E1 0x800001e
+#define SERIAL_8O1 0x800001f
+
+//time
+uint32_t    millis          ();
+uint32_t    micros          ();
+void        delay           (uint32_t);
+void        delayMicroseconds(uint32_t);
+
+//pins (no hardware, inputs read high = button up)
+void        pinMode         (uint8_t, uint8_t);
+void        digitalWrite    (uint8_t, uint8_t);
+int         digitalRead     (uint8_t);
+#define CHANGE          0x03
+void        attachInterrupt (uint8_t, void (*)(), int);     //never fires
+
+//timers (never fire)
+typedef struct hw_timer_s hw_timer_t;
+hw_timer_t* timerBegin              (uint8_t, uint16_t, bool);
+void        timerAttachInterrupt    (hw_timer_t*, void (*)(), bool);
+void        timerAlarmWrite         (hw_timer_t*, uint64_t, bool);
+void        timerAlarmEnable        (hw_timer_t*);
+
+//=====================
+// String
+//=====================
+
+class String {
+    public:
+    String              (const char* s = "") : m_s(s ? s : "") {}
+    String              (const std::string& s) : m_s(s) {}
+    String              (char c) : m_s(1, c) {}
+    String              (int v) : m_s(std::to_string(v)) {}
+    String              (unsigned v) : m_s(std::to_string(v)) {}
+    String              (long v) : m_s(std::to_string(v)) {}
+    String              (unsigned long v) : m_s(std::to_string(v)) {}
+
+    const char* c_str   () const { return m_s.c_str(); }
+    unsigned    length  () const { return m_s.size(); }
+    char        operator[] (unsigned i) const { return i < m_s.size() ? m_s[i] : 0; }
+    char&       operator[] (unsigned i) { static char z; return i < m_s.size() ? m_s[i] : (z = 0); }
+
+    String&     operator+= (const String& s) { m_s += s.m_s; return *this; }
+    String&     operator+= (const char* s) { m_s += s; return *this; }
+    String&     operator+= (char c) { m_s += c; return *this; }
+    friend String operator+ (const String& a, const String& b) { return a.m_s + b.m_s; }
+    friend String operator+ (const char* a, const String& b) { return a + b.m_s; }
+    friend String operator+ (const String& a, const char* b) { return a.m_s + b; }
+
+    bool        operator== (const String& s) const { return m_s == s.m_s; }
+    bool        operator== (const char* s) const { return m_s == s; }
+    bool        operator!= (const String& s) const { return m_s != s.m_s; }
+    bool        operator!= (const char* s) const { return m_s != s; }
+    bool        equals  (const String& s) const { return m_s == s.m_s; }
+
+    bool        startsWith (const String& s) const { return m_s.compare(0, s.m_s.size(), s.m_s) == 0; }
+    bool        endsWith (const String& s) const {
+        return m_s.size() >= s.m_s.size() and m_s.compare(m_s.size() - s.m_s.size(), s.m_s.size(), s.m_s) == 0;
+    }
+    int         indexOf (const String& s, unsigned from = 0) const {
+        auto i = m_s.find(s.m_s, from); return i == std::string::npos ? -1 : (int)i;
+    }
+    int         indexOf (char c, unsigned from = 0) const {
+        auto i = m_s.find(c, from); return i == std::string::npos ? -1 : (int)i;
+    }
+    String      substring (unsigned from, unsigned to = ~0u) const {
+        if(from > m_s.size()) return String();
+        if(to > m_s.size()) to = m_s.size();
+        return to > from ? m_s.substr(from, to - from) : std::string();
+    }
+    void        replace (const String& f, const String& r) {
+        if(f.m_s.empty()) return;
+        for(size_t i = 0; (i = m_s.find(f.m_s, i)) != std::string::npos; i += r.m_s.size()){
+            m_s.replace(i, f.m_s.size(), r.m_s);
+        }
+    }
+    void        trim    () {
+        const char* ws = " \t\r\n\v\f";
+        m_s.erase(m_s.find_last_not_of(ws) + 1);
+        m_s.erase(0, m_s.find_first_not_of(ws));
+    }
+    long        toInt   () const { return atol(m_s.c_str()); }
+
+    private:
+    std::string m_s;
+};
+
+//=====================
+// Print, Stream
+//=====================
+
+class Print {
+    public:
+    virtual ~Print      () {}
+    virtual size_t write(uint8_t) = 0;
+    virtual size_t write(const uint8_t* p, size_t n) {
+        size_t i = 0;
+        for(; i < n and write(p[i]); i++);
+        return i;
+    }
+    size_t      write   (const char* s) { return write((const uint8_t*)s, strlen(s)); }
+    size_t      printf  (const char*, ...) __attribute__((format(printf, 2, 3)));
+    size_t      print   (const char* s) { return write(s); }
+    size_t      print   (const String& s) { return write(s.c_str()); }
+    size_t      println (const char* s = "") { return write(s) + write("\r\n"); }
+    size_t      println (const String& s) { return println(s.c_str()); }
+};
+
+class Stream : public Print {
+    public:
+    virtual int available() = 0;
+    virtual int read    () = 0;
+    virtual int peek    () = 0;
+    virtual void flush  () = 0;
+    void        setTimeout (unsigned long ms) { m_timeout = ms; }
+    size_t      readBytes (uint8_t*, size_t);
+    size_t      readBytes (char* p, size_t n) { return readBytes((uint8_t*)p, n); }
+    protected:
+    unsigned long m_timeout{1000};
+};
+
+//=====================
+// HardwareSerial
+//=====================
+
+//the debug console- writes go to stdout, nothing is read (the bridges use
+//UartPort, PtyUart on the host)
+class HardwareSerial : public Stream {
+    public:
+    HardwareSerial      (int) {}
+    void        begin   (unsigned long baud, uint32_t = SERIAL_8N1, int8_t = -1, int8_t = -1, bool = false)
+                        { m_baud = baud; }
+    void        end     () {}
+    void        updateBaudRate (unsigned long baud) { m_baud = baud; }
+    uint32_t    baudRate() { return m_baud; }
+    int         available () override { return 0; }
+    int         availableForWrite () { return 0x7F; }
+    int         read    () override { return -1; }
+    int         peek    () override { return -1; }
+    void        flush   () override { fflush(stdout); }
+    size_t      write   (uint8_t c) override { return write(&c, 1); }
+    size_t      write   (const uint8_t* p, size_t n) override { return fwrite(p, 1, n, stdout); }
+    using Print::write;
+    operator    bool    () const { return true; }
+
+    private:
+    unsigned long m_baud{115200};
+};
+
+extern HardwareSerial Serial;
+extern HardwareSerial Serial1;
+extern HardwareSerial Serial2;
+
+//=====================
+// ESP
+//=====================
+
+struct EspClass {
+    void        restart     ();         //exits
+    void        deepSleep   (uint64_t) {}
+    uint32_t    getFreeHeap () { return 0; }
+    uint32_t    getCycleCount ();       //240MHz equivalent from a steady clock
+};
+extern EspClass ESP;
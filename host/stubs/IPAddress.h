@@ -0,0 +1,19 @@
+#pragma once
+
+#include "Arduino.h"
+
+class IPAddress {
+    public:
+    IPAddress           () {}
+    IPAddress           (uint8_t a, uint8_t b, uint8_t c, uint8_t d) : m_ip(a | b << 8 | c << 16 | (uint32_t)d << 24) {}
+    IPAddress           (uint32_t ip) : m_ip(ip) {}
+    operator uint32_t   () const { return m_ip; }
+    uint8_t operator[]  (int i) const { return m_ip >> (i * 8); }
+    String  toString    () const {
+        char s[16];
+        snprintf(s, sizeof s, "%u.%u.%u.%u", (*this)[0], (*this)[1], (*this)[2], (*this)[3]);
+        return s;
+    }
+    private:
+    uint32_t m_ip{0};                   //network order, as lwip
+};
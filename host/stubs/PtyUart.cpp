@@ -0,0 +1,211 @@
+#include "PtyUart.hpp"
+#include <chrono>
+#include <fcntl.h>
+#include <poll.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <termios.h>
+#include <unistd.h>
+#include <sys/ioctl.h>
+
+//=====================
+// local functions
+//=====================
+
+static PtyUart ports[3] = { {0}, {1}, {2} };
+
+//kick pipe, read end polled by wait
+static int kick_fd[2] = { -1, -1 };
+static struct Init {
+    Init(){
+        if(pipe(kick_fd)) return;
+        fcntl(kick_fd[0], F_SETFL, O_NONBLOCK);
+        fcntl(kick_fd[1], F_SETFL, O_NONBLOCK);
+    }
+} init;
+
+//=====================
+// UartPort
+//=====================
+
+UartPort& UartPort::get(uint8_t n){ return ports[n < 3 ? n : 0]; }
+
+void UartPort::wait(uint32_t ms)
+{
+    double now = PtyUart::now_us();
+    double until = now + ms * 1000.0;
+    pollfd pf[4] = { { kick_fd[0], POLLIN, 0 } };
+    nfds_t n = 1;
+    for(auto& p : ports){
+        double t = p.wake_us();
+        if(t > 0 and t < until) until = t;
+        else if(t == 0 and p.fd() >= 0) pf[n++] = { p.fd(), POLLIN, 0 };
+    }
+    double us = until - now;
+    if(us < 0) us = 0;
+    timespec ts{ (time_t)(us / 1e6), (long)((us - (time_t)(us / 1e6) * 1e6) * 1000) };
+    ppoll(pf, n, &ts, nullptr);
+    if(pf[0].revents){
+        uint8_t b[64];
+        while(::read(kick_fd[0], b, sizeof b) > 0);
+    }
+    now = PtyUart::now_us();
+    for(auto& p : ports) p.woke(now);
+}
+
+void UartPort::kick()
+{
+    uint8_t b = 0;
+    if(::write(kick_fd[1], &b, 1)){}
+}
+
+//=====================
+// class functions
+//=====================
+
+PtyUart::PtyUart(uint8_t nr) : m_nr(nr)
+{
+}
+
+double PtyUart::now_us()
+{
+    using clk = std::chrono::steady_clock;
+    static const clk::time_point t0 = clk::now();
+    return std::chrono::duration<double, std::micro>(clk::now() - t0).count();
+}
+
+//the pty pair is made on the first begin and kept (same path for a test
+//to stay connected to across a reopen), framing/pins/invert are ignored
+bool PtyUart::begin(uint32_t baud, uint32_t, int8_t, int8_t, bool, const opts_t& o)
+{
+    m_baud = baud ? baud : 1;
+    m_opts = o;
+    m_rx_us = m_tx_us = now_us();
+    m_stop_us = 0;
+    m_over = false;
+    if(m_fd >= 0) return true;
+    int fd = posix_openpt(O_RDWR | O_NOCTTY | O_NONBLOCK);
+    if(fd < 0 or grantpt(fd) or unlockpt(fd)){ if(fd >= 0) close(fd); return false; }
+    snprintf(m_pty, sizeof m_pty, "%s", ptsname(fd));
+    //raw slave, no echo or line editing
+    m_slave = open(m_pty, O_RDWR | O_NOCTTY);
+    termios t;
+    tcgetattr(m_slave, &t);
+    cfmakeraw(&t);
+    tcsetattr(m_slave, TCSANOW, &t);
+    m_fd = fd;
+    return true;
+}
+
+//kept open (see begin), nothing is read or written until begun again
+void PtyUart::end()
+{
+}
+
+void PtyUart::baud(uint32_t v){ m_baud = v ? v : 1; }
+const char* PtyUart::pty(){ return m_fd >= 0 ? m_pty : nullptr; }
+int PtyUart::fd(){ return m_fd; }
+uint32_t PtyUart::overruns(){ return m_overruns; }
+
+size_t PtyUart::pending()
+{
+    int n = 0;
+    if(m_fd < 0 or ioctl(m_fd, FIONREAD, &n)) return 0;
+    return n;
+}
+
+//chars the wire could have moved since t (when credit was 0), up to max
+size_t PtyUart::credit(std::atomic<double>& t, size_t max)
+{
+    double now = now_us();
+    double us = 10e6 / m_baud;                  //per char
+    if(now - t > max * us) t = now - max * us;
+    return now > t ? (now - t) / us : 0;
+}
+
+void PtyUart::spend(std::atomic<double>& t, size_t n)
+{
+    t = t + n * 10e6 / m_baud;
+}
+
+//nothing arrives after the xoff got to the sender
+size_t PtyUart::rx_credit()
+{
+    size_t c = credit(m_rx_us, m_opts.rx_ring);
+    double stop = m_stop_us;
+    if(stop <= 0) return c;
+    double n = (stop - m_rx_us) * m_baud / 10e6;
+    return n < 0 ? 0 : n < c ? n : c;
+}
+
+//an empty pty is an idle line- the next char starts arriving now
+size_t PtyUart::available()
+{
+    size_t n = pending();
+    if(not n){ m_rx_us = now_us(); m_over = false; return 0; }
+    size_t c = rx_credit();
+    if(n > c and c == m_opts.rx_ring and m_opts.flow != FLOW_RTS){
+        if(not m_over) m_overruns++;
+        m_over = true;
+    } else {
+        m_over = false;
+    }
+    return n < c ? n : c;
+}
+
+size_t PtyUart::read(uint8_t* p, size_t n)
+{
+    if(m_fd < 0) return 0;
+    size_t c = rx_credit();
+    ssize_t r = ::read(m_fd, p, n < c ? n : c);
+    if(r <= 0) return 0;
+    spend(m_rx_us, r);
+    return r;
+}
+
+size_t PtyUart::write(const uint8_t* p, size_t n)
+{
+    if(m_fd < 0) return 0;
+    size_t c = credit(m_tx_us, FIFO - 1);
+    ssize_t r = ::write(m_fd, p, n < c ? n : c);
+    if(r <= 0) return 0;
+    spend(m_tx_us, r);
+    if(m_opts.flow != FLOW_XOFF) return r;
+    double out = m_tx_us + (FIFO - 1) * 10e6 / m_baud;  //written chars sent by then
+    for(ssize_t i = r - 1; i >= 0; i--){       //last xon/xoff wins
+        if(p[i] == XOFF){ if(m_stop_us <= 0) m_stop_us = out; break; }
+        if(p[i] == XON){
+            double stop = m_stop_us;
+            if(stop > 0 and out > stop) m_rx_us = m_rx_us + (out - stop); //not sent meanwhile
+            m_stop_us = 0;
+            break;
+        }
+    }
+    return r;
+}
+
+bool PtyUart::tx_done()
+{
+    return credit(m_tx_us, FIFO - 1) == FIFO - 1u;
+}
+
+//rx_full chars arrived, or all arrived and rx_idle char times since the
+//last- a wake already given for the same point is not given again (the
+//task could not take the data, it waits for its timeout as on the esp32)
+double PtyUart::wake_us()
+{
+    size_t n = pending();
+    if(not n) return 0;
+    if(m_stop_us > 0) return -1;                //sender stopped, the task sends xon
+    double us = 10e6 / m_baud;
+    size_t k = n + m_opts.rx_idle;
+    if(k > m_opts.rx_full) k = m_opts.rx_full;
+    double t = m_rx_us + k * us;
+    return t > m_woke_us ? t : -1;
+}
+
+void PtyUart::woke(double now)
+{
+    double t = wake_us();
+    if(t > 0 and t <= now) m_woke_us = now;
+}
@@ -0,0 +1,65 @@
+#pragma once
+
+#include "UartPort.hpp"
+#include <atomic>
+
+//UartPort on a pty pair (host build)- the bridge has the master side,
+//pty() is the slave path a test connects to
+//
+//the pty is paced to the baud rate (10 bits per char)- rx chars arrive one
+//char time apart from when the pty had data, the driver rx ring holds
+//rx_ring of them (more waiting counts as an overrun, the pty keeps them),
+//the tx fifo takes FIFO chars and empties at the baud rate
+//
+//flow control is modelled at the sender- FLOW_RTS, the sender waits while
+//the driver rx ring is full (no overrun), FLOW_XOFF, the sender stops once
+//an XOFF written to tx has gone out, and starts again at XON
+//
+//wait() works out when the esp32 would interrupt- rx_full chars arrived,
+//or the last char rx_idle char times ago- and sleeps in ppoll() until the
+//first of those, data arriving on an idle pty, a kick, or the timeout
+
+struct PtyUart : UartPort {
+
+    PtyUart             (uint8_t);
+
+    bool        begin       (uint32_t, uint32_t, int8_t, int8_t, bool, const opts_t&) override;
+    void        end         () override;
+    void        baud        (uint32_t) override;
+    size_t      available   () override;
+    size_t      read        (uint8_t*, size_t) override;
+    size_t      write       (const uint8_t*, size_t) override;
+    bool        tx_done     () override;
+    uint32_t    overruns    () override;
+
+    const char* pty         ();             //-> slave path, nullptr if not begun
+
+    //wait (all ports)- when this port would interrupt (us, clock of now_us),
+    //0 if no rx pending (wait on the fd)
+    double      wake_us     ();
+    int         fd          ();
+    void        woke        (double);       //wait returned at us
+
+    static double now_us    ();
+
+    private:
+
+    size_t      pending     ();             //chars in the pty
+    size_t      credit      (std::atomic<double>&, size_t); //chars the line moved since t, up to max
+    size_t      rx_credit   ();             //rx chars arrived (to the ring, the xoff)
+    void        spend       (std::atomic<double>&, size_t);
+
+    uint8_t             m_nr;
+    std::atomic<int>    m_fd{-1};           //pty master
+    int                 m_slave{-1};        //kept open so master never sees EIO
+    char                m_pty[64]{};
+    std::atomic<uint32_t> m_baud{115200};
+    opts_t              m_opts{RX_RING_DEF, RX_FULL_DEF, RX_IDLE_DEF, FLOW_NONE, -1, -1};
+    std::atomic<double> m_rx_us{0};         //time rx credit was 0
+    std::atomic<double> m_tx_us{0};         //time tx credit was 0
+    std::atomic<double> m_stop_us{0};       //xoff reaches the sender (0 = not stopped)
+    double              m_woke_us{0};       //last wake for this port's data
+    bool                m_over{false};      //in an overrun (counted once)
+    std::atomic<uint32_t> m_overruns{0};
+
+};
@@ -0,0 +1,158 @@
+#include "WiFi.h"
+#include "lwip/sockets.h"
+
+WiFiClass WiFi;
+
+//=====================
+// WiFiClient
+//=====================
+
+WiFiClient::Socket::~Socket(){ if(fd >= 0) ::close(fd); }
+
+WiFiClient::WiFiClient(int fd) : m_sock(new Socket{fd}) {}
+
+int WiFiClient::fd() const { return m_sock ? m_sock->fd : -1; }
+
+int WiFiClient::connect(IPAddress ip, uint16_t port)
+{
+    stop();
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    sockaddr_in a{};
+    a.sin_family = AF_INET;
+    a.sin_port = htons(port);
+    a.sin_addr.s_addr = (uint32_t)ip;
+    if(::connect(fd, (sockaddr*)&a, sizeof a)){ ::close(fd); return 0; }
+    m_sock.reset(new Socket{fd});
+    return 1;
+}
+
+void WiFiClient::stop()
+{
+    if(m_sock and m_sock->fd >= 0){
+        ::close(m_sock->fd);
+        m_sock->fd = -1;                        //all copies see it closed
+    }
+    m_sock.reset();
+}
+
+//peer closed = readable with 0 bytes
+uint8_t WiFiClient::connected()
+{
+    if(fd() < 0) return 0;
+    uint8_t c;
+    ssize_t r = recv(fd(), &c, 1, MSG_PEEK | MSG_DONTWAIT);
+    if(r == 0 or (r < 0 and errno != EAGAIN and errno != EWOULDBLOCK)) return 0;
+    return 1;
+}
+
+int WiFiClient::available()
+{
+    int n = 0;
+    if(fd() < 0 or ioctl(fd(), FIONREAD, &n)) return 0;
+    return n;
+}
+
+int WiFiClient::read()
+{
+    uint8_t c;
+    return read(&c, 1) == 1 ? c : -1;
+}
+
+int WiFiClient::read(uint8_t* p, size_t n)
+{
+    if(fd() < 0) return -1;
+    ssize_t r = recv(fd(), p, n, MSG_DONTWAIT);
+    return r > 0 ? r : -1;
+}
+
+int WiFiClient::peek()
+{
+    uint8_t c;
+    if(fd() < 0) return -1;
+    return recv(fd(), &c, 1, MSG_PEEK | MSG_DONTWAIT) == 1 ? c : -1;
+}
+
+//blocking, as esp32 WiFiClient::write
+size_t WiFiClient::write(const uint8_t* p, size_t n)
+{
+    size_t i = 0;
+    while(fd() >= 0 and i < n){
+        ssize_t r = send(fd(), p + i, n - i, MSG_NOSIGNAL);
+        if(r <= 0) break;
+        i += r;
+    }
+    return i;
+}
+
+IPAddress WiFiClient::remoteIP() const
+{
+    sockaddr_in a{};
+    socklen_t len = sizeof a;
+    if(fd() < 0 or getpeername(fd(), (sockaddr*)&a, &len)) return IPAddress();
+    return IPAddress(a.sin_addr.s_addr);
+}
+
+uint16_t WiFiClient::remotePort() const
+{
+    sockaddr_in a{};
+    socklen_t len = sizeof a;
+    if(fd() < 0 or getpeername(fd(), (sockaddr*)&a, &len)) return 0;
+    return ntohs(a.sin_port);
+}
+
+int WiFiClient::setNoDelay(bool nd)
+{
+    int v = nd;
+    return setsockopt(fd(), IPPROTO_TCP, TCP_NODELAY, &v, sizeof v);
+}
+
+//=====================
+// WiFiServer
+//=====================
+
+void WiFiServer::begin(uint16_t port)
+{
+    if(port) m_port = port;
+    if(m_fd >= 0) return;
+    m_fd = socket(AF_INET, SOCK_STREAM, 0);
+    int v = 1;
+    setsockopt(m_fd, SOL_SOCKET, SO_REUSEADDR, &v, sizeof v);
+    sockaddr_in a{};
+    a.sin_family = AF_INET;
+    a.sin_port = htons(m_port);
+    a.sin_addr.s_addr = INADDR_ANY;
+    if(bind(m_fd, (sockaddr*)&a, sizeof a) or listen(m_fd, m_max)){
+        perror("WiFiServer::begin");
+        ::close(m_fd);
+        m_fd = -1;
+        return;
+    }
+    fcntl(m_fd, F_SETFL, O_NONBLOCK);
+}
+
+void WiFiServer::end()
+{
+    if(m_pending >= 0) ::close(m_pending);
+    if(m_fd >= 0) ::close(m_fd);
+    m_fd = m_pending = -1;
+}
+
+bool WiFiServer::hasClient()
+{
+    if(m_pending < 0 and m_fd >= 0) m_pending = accept(m_fd, nullptr, nullptr);
+    return m_pending >= 0;
+}
+
+WiFiClient WiFiServer::available()
+{
+    if(not hasClient()) return WiFiClient();
+    int fd = m_pending;
+    m_pending = -1;
+    int sb = 5744;                              //lwip TCP_SND_BUF (esp32 core)
+    setsockopt(fd, SOL_SOCKET, SO_SNDBUF, &sb, sizeof sb);
+    if(m_nodelay){
+        int v = 1;
+        setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &v, sizeof v);
+    }
+    return WiFiClient(fd);
+}
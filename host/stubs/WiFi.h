@@ -0,0 +1,119 @@
+#pragma once
+
+//host stand-in for the esp32 WiFi library
+//WiFiServer/WiFiClient are real tcp sockets (all interfaces), the station
+//is connected with ip 127.0.0.1 once begin() is called, unless a bench
+//takes the link down (WiFi.link- status, scans and events follow it, the
+//sockets still work)
+
+#include "Arduino.h"
+#include "IPAddress.h"
+#include <atomic>
+#include <memory>
+
+typedef enum {
+    WL_IDLE_STATUS = 0, WL_NO_SSID_AVAIL = 1, WL_SCAN_COMPLETED = 2, WL_CONNECTED = 3,
+    WL_CONNECT_FAILED = 4, WL_CONNECTION_LOST = 5, WL_DISCONNECTED = 6
+} wl_status_t;
+
+typedef enum { WIFI_OFF = 0, WIFI_STA = 1, WIFI_AP = 2, WIFI_AP_STA = 3 } wifi_mode_t;
+
+typedef enum {
+    SYSTEM_EVENT_WIFI_READY = 0, SYSTEM_EVENT_SCAN_DONE, SYSTEM_EVENT_STA_START, SYSTEM_EVENT_STA_STOP,
+    SYSTEM_EVENT_STA_CONNECTED, SYSTEM_EVENT_STA_DISCONNECTED, SYSTEM_EVENT_STA_AUTHMODE_CHANGE,
+    SYSTEM_EVENT_STA_GOT_IP, SYSTEM_EVENT_STA_LOST_IP, SYSTEM_EVENT_MAX = 29
+} system_event_id_t;
+typedef void (*WiFiEventCb)(system_event_id_t);
+
+#define WIFI_SCAN_RUNNING   (-1)
+#define WIFI_SCAN_FAILED    (-2)
+
+class WiFiClient : public Stream {
+    public:
+    WiFiClient          () {}
+    WiFiClient          (int fd);           //takes ownership of socket
+    int         connect (IPAddress, uint16_t);
+    size_t      write   (uint8_t c) override { return write(&c, 1); }
+    size_t      write   (const uint8_t*, size_t) override;
+    using Print::write;
+    int         available () override;
+    int         read    () override;
+    int         read    (uint8_t*, size_t);
+    int         peek    () override;
+    void        flush   () override {}
+    void        stop    ();
+    uint8_t     connected ();
+    operator    bool    () { return connected(); }
+    int         fd      () const;
+    IPAddress   remoteIP () const;
+    uint16_t    remotePort () const;
+    int         setNoDelay (bool);
+
+    private:
+    struct Socket { int fd; ~Socket(); };
+    std::shared_ptr<Socket> m_sock;         //copies share the socket, as esp32
+};
+
+class WiFiServer {
+    public:
+    WiFiServer          (uint16_t port = 80, uint8_t max_clients = 4) : m_port(port), m_max(max_clients) {}
+    ~WiFiServer         () { end(); }
+    void        begin   (uint16_t port = 0);
+    void        end     ();
+    bool        hasClient ();
+    WiFiClient  available ();
+    void        setNoDelay (bool nd) { m_nodelay = nd; }
+    bool        getNoDelay () { return m_nodelay; }
+    operator    bool    () { return m_fd >= 0; }
+    int         fd      () const { return m_fd; } //listening socket (core change, see modified_arduino_sources.txt)
+
+    private:
+    uint16_t    m_port;
+    uint8_t     m_max;
+    int         m_fd{-1};
+    int         m_pending{-1};              //accepted by hasClient()
+    bool        m_nodelay{false};
+};
+
+struct WiFiClass {
+    IPAddress   localIP     () { return IPAddress(127, 0, 0, 1); }
+    IPAddress   gatewayIP   () { return IPAddress(127, 0, 0, 1); }
+    IPAddress   subnetMask  () { return IPAddress(255, 0, 0, 0); }
+    IPAddress   dnsIP       (uint8_t = 0) { return IPAddress(127, 0, 0, 1); }
+    IPAddress   softAPIP    () { return IPAddress(127, 0, 0, 1); }
+    String      SSID        () { return isConnected() ? "host" : ""; }
+    String      macAddress  () { return "00:00:00:00:00:00"; }
+    uint8_t*    BSSID       () { static uint8_t b[6]; return b; }
+    int32_t     channel     () { return 1; }
+    int32_t     RSSI        () { return -40; }
+    bool        setHostname (const char*) { return true; }
+    bool        softAP      (const char*, const char* = nullptr) { return true; }
+    bool        mode        (wifi_mode_t) { return true; }
+    bool        config      (IPAddress, IPAddress, IPAddress, IPAddress = IPAddress(), IPAddress = IPAddress()) { return true; }
+    wl_status_t begin       (const char*, const char* = nullptr, int32_t = 0, const uint8_t* = nullptr, bool = true) { m_joined = true; return status(); }
+    wl_status_t status      () { return m_up and m_joined ? WL_CONNECTED : WL_DISCONNECTED; }
+    bool        isConnected () { return status() == WL_CONNECTED; }
+    bool        reconnect   () { return isConnected(); }
+    bool        disconnect  (bool = false) { m_joined = false; return true; }
+    int         onEvent     (WiFiEventCb cb, system_event_id_t = SYSTEM_EVENT_MAX) { m_cb = cb; return 1; }
+    //scan finds the one network "host" while the link is up
+    int16_t     scanNetworks(bool = false, bool = false, bool = false, uint32_t = 300) { m_scan = m_up; return WIFI_SCAN_RUNNING; }
+    int16_t     scanComplete() { return m_scan; }
+    void        scanDelete  () { m_scan = WIFI_SCAN_FAILED; }
+    String      SSID        (uint8_t i) { return i < m_scan ? "host" : ""; }
+    int32_t     RSSI        (uint8_t i) { return i < m_scan ? -40 : 0; }
+
+    //host only- link up/down, with the event the esp32 would send
+    void        link        (bool up)
+    {
+        m_up = up;
+        if(m_cb) m_cb(up ? SYSTEM_EVENT_STA_GOT_IP : SYSTEM_EVENT_STA_DISCONNECTED);
+    }
+
+    private:
+    std::atomic<bool> m_up{true};
+    std::atomic<bool> m_joined{false};
+    int16_t     m_scan{WIFI_SCAN_FAILED};
+    WiFiEventCb m_cb{nullptr};
+};
+extern WiFiClass WiFi;
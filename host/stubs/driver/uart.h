@@ -0,0 +1,64 @@
+#pragma once
+
+//host stand-in for the esp-idf uart driver- declarations only, so
+//EspUart.cpp can be checked (make check), the host build uses PtyUart
+
+#include <stddef.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/queue.h"
+
+typedef int esp_err_t;
+#define ESP_OK                  0
+
+typedef enum { UART_NUM_0, UART_NUM_1, UART_NUM_2 } uart_port_t;
+typedef enum { UART_DATA_5_BITS, UART_DATA_6_BITS, UART_DATA_7_BITS, UART_DATA_8_BITS } uart_word_length_t;
+typedef enum { UART_PARITY_DISABLE = 0, UART_PARITY_EVEN = 2, UART_PARITY_ODD = 3 } uart_parity_t;
+typedef enum { UART_STOP_BITS_1 = 1, UART_STOP_BITS_1_5, UART_STOP_BITS_2 } uart_stop_bits_t;
+typedef enum { UART_HW_FLOWCTRL_DISABLE = 0, UART_HW_FLOWCTRL_RTS, UART_HW_FLOWCTRL_CTS,
+               UART_HW_FLOWCTRL_CTS_RTS } uart_hw_flowcontrol_t;
+typedef enum { UART_DATA, UART_BREAK, UART_BUFFER_FULL, UART_FIFO_OVF, UART_FRAME_ERR,
+               UART_PARITY_ERR } uart_event_type_t;
+
+typedef struct {
+    int                     baud_rate;
+    uart_word_length_t      data_bits;
+    uart_parity_t           parity;
+    uart_stop_bits_t        stop_bits;
+    uart_hw_flowcontrol_t   flow_ctrl;
+    uint8_t                 rx_flow_ctrl_thresh;
+    bool                    use_ref_tick;
+} uart_config_t;
+
+typedef struct {
+    uint32_t    intr_enable_mask;
+    uint8_t     rx_timeout_thresh;
+    uint8_t     txfifo_empty_intr_thresh;
+    uint8_t     rxfifo_full_thresh;
+} uart_intr_config_t;
+
+typedef struct {
+    uart_event_type_t   type;
+    size_t              size;
+} uart_event_t;
+
+#define UART_PIN_NO_CHANGE          (-1)
+#define UART_INVERSE_RXD            (1 << 19)
+#define UART_INVERSE_TXD            (1 << 22)
+#define UART_RXFIFO_FULL_INT_ENA_M  (1 << 0)
+#define UART_FRM_ERR_INT_ENA_M      (1 << 3)
+#define UART_RXFIFO_OVF_INT_ENA_M   (1 << 4)
+#define UART_PARITY_ERR_INT_ENA_M   (1 << 2)
+#define UART_RXFIFO_TOUT_INT_ENA_M  (1 << 8)
+
+esp_err_t   uart_param_config           (uart_port_t, const uart_config_t*);
+esp_err_t   uart_driver_install         (uart_port_t, int, int, int, QueueHandle_t*, int);
+esp_err_t   uart_driver_delete          (uart_port_t);
+esp_err_t   uart_set_pin                (uart_port_t, int, int, int, int);
+esp_err_t   uart_set_line_inverse       (uart_port_t, uint32_t);
+esp_err_t   uart_intr_config            (uart_port_t, const uart_intr_config_t*);
+esp_err_t   uart_disable_rx_intr        (uart_port_t);
+esp_err_t   uart_set_baudrate           (uart_port_t, uint32_t);
+esp_err_t   uart_get_buffered_data_len  (uart_port_t, size_t*);
+int         uart_read_bytes             (uart_port_t, uint8_t*, uint32_t, TickType_t);
+int         uart_tx_chars               (uart_port_t, const char*, uint32_t);
+esp_err_t   uart_wait_tx_done           (uart_port_t, TickType_t);
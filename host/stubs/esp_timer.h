@@ -0,0 +1,6 @@
+#pragma once
+
+#include <stdint.h>
+
+//host stand-in- microseconds since start, 64 bits (never wraps)
+int64_t     esp_timer_get_time();
@@ -0,0 +1,76 @@
+#include "freertos/task.h"
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+//=====================
+// local
+//=====================
+
+//task handle- notification count for ulTaskNotifyTake/xTaskNotifyGive
+struct Task {
+    std::mutex              mtx;
+    std::condition_variable cv;
+    uint32_t                count{0};
+};
+
+static thread_local Task* current;
+static Task main_task;                          //for the loop() thread
+
+//=====================
+// tasks
+//=====================
+
+BaseType_t xTaskCreatePinnedToCore(void (*fn)(void*), const char*, uint32_t, void* arg,
+                                   UBaseType_t, TaskHandle_t* handle, BaseType_t)
+{
+    Task* t = new Task;                         //tasks are never deleted
+    if(handle) *handle = t;
+    std::thread([=]{ current = t; fn(arg); }).detach();
+    return pdPASS;
+}
+
+void vTaskDelay(TickType_t ticks)
+{
+    std::this_thread::sleep_for(std::chrono::milliseconds(ticks));
+}
+
+TickType_t xTaskGetTickCount()
+{
+    using namespace std::chrono;
+    static const steady_clock::time_point t0 = steady_clock::now();
+    return duration_cast<milliseconds>(steady_clock::now() - t0).count();
+}
+
+void taskYIELD()
+{
+    std::this_thread::yield();
+}
+
+TaskHandle_t xTaskGetCurrentTaskHandle()
+{
+    return current ? current : &main_task;
+}
+
+uint32_t ulTaskNotifyTake(BaseType_t clear, TickType_t ticks)
+{
+    Task* t = (Task*)xTaskGetCurrentTaskHandle();
+    std::unique_lock<std::mutex> lk(t->mtx);
+    auto ready = [t]{ return t->count != 0; };
+    if(ticks == portMAX_DELAY) t->cv.wait(lk, ready);
+    else t->cv.wait_for(lk, std::chrono::milliseconds(ticks), ready);
+    uint32_t n = t->count;
+    if(n) t->count = clear ? 0 : n - 1;
+    return n;
+}
+
+void xTaskNotifyGive(TaskHandle_t h)
+{
+    Task* t = (Task*)h;
+    {
+        std::lock_guard<std::mutex> lk(t->mtx);
+        t->count++;
+    }
+    t->cv.notify_one();
+}
@@ -0,0 +1,18 @@
+#pragma once
+
+//host stand-in for freertos- tasks are threads, 1 tick = 1ms
+
+#include <stdint.h>
+
+typedef void*       TaskHandle_t;
+typedef uint32_t    TickType_t;
+typedef int         BaseType_t;
+typedef unsigned    UBaseType_t;
+
+#define pdTRUE              1
+#define pdFALSE             0
+#define pdPASS              1
+#define portMAX_DELAY       0xFFFFFFFF
+#define portTICK_PERIOD_MS  1
+#define pdMS_TO_TICKS(ms)   (ms)
+#define portYIELD_FROM_ISR()
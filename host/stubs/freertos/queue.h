@@ -0,0 +1,14 @@
+#pragma once
+
+#include "FreeRTOS.h"
+
+//declarations only (EspUart.cpp check), queues are not used by host code
+typedef void*       QueueHandle_t;
+typedef void*       QueueSetHandle_t;
+typedef void*       QueueSetMemberHandle_t;
+
+QueueSetHandle_t    xQueueCreateSet         (UBaseType_t);
+BaseType_t          xQueueAddToSet          (QueueSetMemberHandle_t, QueueSetHandle_t);
+BaseType_t          xQueueRemoveFromSet     (QueueSetMemberHandle_t, QueueSetHandle_t);
+QueueSetMemberHandle_t xQueueSelectFromSet  (QueueSetHandle_t, TickType_t);
+BaseType_t          xQueueReceive           (QueueHandle_t, void*, TickType_t);
@@ -0,0 +1,10 @@
+#pragma once
+
+#include "queue.h"
+
+//declarations only (EspUart.cpp check)
+typedef QueueHandle_t SemaphoreHandle_t;
+
+SemaphoreHandle_t   xSemaphoreCreateBinary  ();
+BaseType_t          xSemaphoreGive          (SemaphoreHandle_t);
+BaseType_t          xSemaphoreTake          (SemaphoreHandle_t, TickType_t);
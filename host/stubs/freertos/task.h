@@ -0,0 +1,15 @@
+#pragma once
+
+#include "FreeRTOS.h"
+
+//core and priority are ignored, the task runs as a detached thread
+BaseType_t  xTaskCreatePinnedToCore (void (*)(void*), const char*, uint32_t, void*,
+                                     UBaseType_t, TaskHandle_t*, BaseType_t);
+void        vTaskDelay              (TickType_t);
+TickType_t  xTaskGetTickCount       ();
+void        taskYIELD               ();
+
+//direct to task notifications
+uint32_t    ulTaskNotifyTake        (BaseType_t, TickType_t);
+void        xTaskNotifyGive         (TaskHandle_t);
+TaskHandle_t xTaskGetCurrentTaskHandle ();
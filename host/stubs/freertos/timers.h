@@ -0,0 +1,12 @@
+#pragma once
+
+#include "FreeRTOS.h"
+
+//no timer task- a pended function runs at once (there are no isrs here)
+typedef void (*PendedFunction_t)(void*, uint32_t);
+inline BaseType_t xTimerPendFunctionCallFromISR(PendedFunction_t fn, void* p1, uint32_t p2, BaseType_t* woken)
+{
+    fn(p1, p2);
+    if(woken) *woken = pdFALSE;
+    return pdPASS;
+}
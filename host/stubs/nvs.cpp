@@ -0,0 +1,163 @@
+#include "nvs.h"
+#include <fstream>
+#include <map>
+#include <string>
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+
+//=====================
+// local
+//=====================
+
+//values stored as text (blobs as hex)
+struct Handle {
+    std::string file;
+    std::map<std::string, std::string> kv;
+};
+
+static std::map<nvs_handle, Handle> handles;
+static nvs_handle next_handle = 1;
+
+static Handle* get(nvs_handle h)
+{
+    auto i = handles.find(h);
+    return i == handles.end() ? nullptr : &i->second;
+}
+
+//=====================
+// nvs
+//=====================
+
+esp_err_t nvs_open(const char* ns, nvs_open_mode, nvs_handle* h)
+{
+    Handle& n = handles[next_handle];
+    n.file = std::string("nvs_") + ns + ".txt";
+    std::ifstream f(n.file);
+    std::string line;
+    while(std::getline(f, line)){
+        auto i = line.find('=');
+        if(i != std::string::npos) n.kv[line.substr(0, i)] = line.substr(i + 1);
+    }
+    *h = next_handle++;
+    return ESP_OK;
+}
+
+void nvs_close(nvs_handle h)
+{
+    handles.erase(h);
+}
+
+esp_err_t nvs_commit(nvs_handle h)
+{
+    Handle* n = get(h);
+    if(not n) return ESP_FAIL;
+    std::ofstream f(n->file, std::ios::trunc);
+    for(auto& kv : n->kv) f << kv.first << '=' << kv.second << '\n';
+    return ESP_OK;
+}
+
+esp_err_t nvs_erase_all(nvs_handle h)
+{
+    Handle* n = get(h);
+    if(not n) return ESP_FAIL;
+    n->kv.clear();
+    return ESP_OK;
+}
+
+esp_err_t nvs_get_str(nvs_handle h, const char* k, char* p, size_t* len)
+{
+    Handle* n = get(h);
+    if(not n or not n->kv.count(k)) return ESP_ERR_NVS_NOT_FOUND;
+    const std::string& v = n->kv[k];
+    if(p and *len < v.size() + 1) return ESP_ERR_NVS_INVALID_LENGTH;
+    *len = v.size() + 1;
+    if(p) memcpy(p, v.c_str(), v.size() + 1);
+    return ESP_OK;
+}
+
+esp_err_t nvs_get_u32(nvs_handle h, const char* k, uint32_t* v)
+{
+    Handle* n = get(h);
+    if(not n or not n->kv.count(k)) return ESP_ERR_NVS_NOT_FOUND;
+    *v = strtoul(n->kv[k].c_str(), nullptr, 10);
+    return ESP_OK;
+}
+
+esp_err_t nvs_get_u8(nvs_handle h, const char* k, uint8_t* v)
+{
+    uint32_t u;
+    esp_err_t err = nvs_get_u32(h, k, &u);
+    if(err == ESP_OK) *v = u;
+    return err;
+}
+
+esp_err_t nvs_get_u16(nvs_handle h, const char* k, uint16_t* v)
+{
+    uint32_t u;
+    esp_err_t err = nvs_get_u32(h, k, &u);
+    if(err == ESP_OK) *v = u;
+    return err;
+}
+
+esp_err_t nvs_get_i8(nvs_handle h, const char* k, int8_t* v)
+{
+    uint32_t u;
+    esp_err_t err = nvs_get_u32(h, k, &u);
+    if(err == ESP_OK) *v = u;
+    return err;
+}
+
+esp_err_t nvs_set_str(nvs_handle h, const char* k, const char* v)
+{
+    Handle* n = get(h);
+    if(not n) return ESP_FAIL;
+    n->kv[k] = v;
+    return ESP_OK;
+}
+
+esp_err_t nvs_set_u32(nvs_handle h, const char* k, uint32_t v)
+{
+    Handle* n = get(h);
+    if(not n) return ESP_FAIL;
+    n->kv[k] = std::to_string(v);
+    return ESP_OK;
+}
+
+esp_err_t nvs_set_u8(nvs_handle h, const char* k, uint8_t v)
+{
+    return nvs_set_u32(h, k, v);
+}
+
+esp_err_t nvs_set_u16(nvs_handle h, const char* k, uint16_t v)
+{
+    return nvs_set_u32(h, k, v);
+}
+
+esp_err_t nvs_set_i8(nvs_handle h, const char* k, int8_t v)
+{
+    return nvs_set_u32(h, k, (uint8_t)v);
+}
+
+esp_err_t nvs_get_blob(nvs_handle h, const char* k, void* p, size_t* len)
+{
+    Handle* n = get(h);
+    if(not n or not n->kv.count(k)) return ESP_ERR_NVS_NOT_FOUND;
+    const std::string& v = n->kv[k];
+    size_t size = v.size() / 2;
+    if(p and *len < size) return ESP_ERR_NVS_INVALID_LENGTH;
+    *len = size;
+    for(size_t i = 0; p and i < size; i++) ((uint8_t*)p)[i] = strtoul(v.substr(i * 2, 2).c_str(), nullptr, 16);
+    return ESP_OK;
+}
+
+esp_err_t nvs_set_blob(nvs_handle h, const char* k, const void* p, size_t len)
+{
+    Handle* n = get(h);
+    if(not n) return ESP_FAIL;
+    std::string v;
+    char x[3];
+    for(size_t i = 0; i < len; i++){ snprintf(x, sizeof x, "%02x", ((const uint8_t*)p)[i]); v += x; }
+    n->kv[k] = v;
+    return ESP_OK;
+}
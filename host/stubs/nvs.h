@@ -0,0 +1,35 @@
+#pragma once
+
+//host stand-in for the esp-idf nvs api- one file per namespace
+//(nvs_<namespace>.txt in the working directory, key=value lines), sets are
+//held per handle until nvs_commit writes the file
+
+#include <stdint.h>
+#include <stddef.h>
+
+typedef int32_t     esp_err_t;
+typedef uint32_t    nvs_handle;
+
+#define ESP_OK                      0
+#define ESP_FAIL                    -1
+#define ESP_ERR_NVS_NOT_FOUND       0x1102
+#define ESP_ERR_NVS_INVALID_LENGTH  0x110c
+
+typedef enum { NVS_READONLY, NVS_READWRITE } nvs_open_mode;
+
+esp_err_t   nvs_open        (const char*, nvs_open_mode, nvs_handle*);
+void        nvs_close       (nvs_handle);
+esp_err_t   nvs_commit      (nvs_handle);
+esp_err_t   nvs_erase_all   (nvs_handle);
+esp_err_t   nvs_get_str     (nvs_handle, const char*, char*, size_t*);
+esp_err_t   nvs_get_u32     (nvs_handle, const char*, uint32_t*);
+esp_err_t   nvs_get_u16     (nvs_handle, const char*, uint16_t*);
+esp_err_t   nvs_get_u8      (nvs_handle, const char*, uint8_t*);
+esp_err_t   nvs_get_i8      (nvs_handle, const char*, int8_t*);
+esp_err_t   nvs_get_blob    (nvs_handle, const char*, void*, size_t*);
+esp_err_t   nvs_set_str     (nvs_handle, const char*, const char*);
+esp_err_t   nvs_set_u32     (nvs_handle, const char*, uint32_t);
+esp_err_t   nvs_set_u16     (nvs_handle, const char*, uint16_t);
+esp_err_t   nvs_set_u8      (nvs_handle, const char*, uint8_t);
+esp_err_t   nvs_set_i8      (nvs_handle, const char*, int8_t);
+esp_err_t   nvs_set_blob    (nvs_handle, const char*, const void*, size_t);
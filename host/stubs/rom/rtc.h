@@ -0,0 +1,7 @@
+#pragma once
+
+//host stand-in- always reports a power on reset
+#define POWERON_RESET   1
+#define DEEPSLEEP_RESET 5
+#define SW_CPU_RESET    12
+static inline int rtc_get_reset_reason(int){ return POWERON_RESET; }
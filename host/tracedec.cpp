@@ -0,0 +1,102 @@
+//host tool- decode a trace stream (Trace.hpp format, from telnet port 2303)
+//
+//  make && nc esp32 2303 | build/tracedec
+//  build/tracedec trace.bin [out]
+//
+//one line per record- time from the first record (us, from the cycle
+//count), time since the previous record, then file:line function name and
+//the value (decimal and hex), records of a trace point with no metadata
+//show its id
+//
+//the cycle count is 32 bits (wraps every ~18s at 240MHz), records are read
+//often enough that each delta is within one wrap- a delta is taken as
+//signed, since two tasks can store records slightly out of cycle order
+
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+#include <map>
+#include <string>
+
+using meta_t = struct {
+    std::string     file;
+    std::string     func;
+    std::string     name;
+    uint16_t        line;
+};
+
+static bool get(FILE* f, void* p, size_t n){ return fread(p, 1, n, f) == n; }
+
+static bool get32(FILE* f, uint32_t& v)
+{
+    uint8_t b[4];
+    if(not get(f, b, 4)) return false;
+    v = b[0] | b[1] << 8 | b[2] << 16 | (uint32_t)b[3] << 24;
+    return true;
+}
+
+static bool getstr(FILE* f, std::string& s)
+{
+    s.clear();
+    for(int c; (c = fgetc(f)) != EOF;){
+        if(not c) return true;
+        s += (char)c;
+    }
+    return false;
+}
+
+int main(int argc, char** argv)
+{
+    FILE* in = argc > 1 and strcmp(argv[1], "-") ? fopen(argv[1], "rb") : stdin;
+    if(not in){ perror(argv[1]); return 1; }
+    FILE* out = argc > 2 ? fopen(argv[2], "w") : stdout;
+    if(not out){ perror(argv[2]); return 1; }
+
+    char magic[4];
+    uint32_t mhz;
+    if(not get(in, magic, 4) or memcmp(magic, "TRC1", 4) or not get32(in, mhz) or not mhz){
+        fprintf(stderr, "not a trace stream (version 1)\n");
+        return 1;
+    }
+    fprintf(out, "# trace, %u cycles/us\n", mhz);
+    fprintf(out, "#      time (us)     +us  trace point = value\n");
+
+    std::map<uint32_t, meta_t> metas;
+    bool first = true;
+    uint32_t last = 0;
+    int64_t t = 0;                              //cycles from first record
+    unsigned records = 0, lost = 0;
+    for(uint32_t id, cycles, value; get32(in, id);){
+        if(id == 0){                            //metadata
+            meta_t m;
+            uint8_t l[2];
+            if(not get32(in, id) or not get(in, l, 2) or not getstr(in, m.file)
+                or not getstr(in, m.func) or not getstr(in, m.name)) break;
+            m.line = l[0] | l[1] << 8;
+            metas[id] = m;
+            continue;
+        }
+        if(not get32(in, cycles) or not get32(in, value)) break;
+        if(id == 1){                            //lost
+            fprintf(out, "# %u records lost\n", value);
+            lost += value;
+            continue;
+        }
+        int32_t dt = first ? 0 : (int32_t)(cycles - last);
+        first = false;
+        last = cycles;
+        t += dt;
+        records++;
+        fprintf(out, "%16.3f %+8.3f  ", t / (double)mhz, dt / (double)mhz);
+        auto m = metas.find(id);
+        if(m == metas.end()) fprintf(out, "[%08x]", id);
+        else fprintf(out, "%s:%u %s %s", m->second.file.c_str(), m->second.line,
+            m->second.func.c_str(), m->second.name.c_str());
+        fprintf(out, " = %d (0x%08x)\n", (int32_t)value, value);
+        fflush(out);
+    }
+    fprintf(stderr, "%u records, %u lost, %u trace points, %.6f s\n",
+        records, lost, (unsigned)metas.size(), t / (mhz * 1e6));
+    if(out != stdout) fclose(out);
+    return 0;
+}
@@ -16,20 +16,37 @@
   connections-
     uart0 - 3pin connector (used for esp32 programming, debug output)
     uart2 - programming connector
+    (uart1 has no default pins- set uart1 pins before enabling)
 
 
   initial setup- (initial firmware loaded)
         power on
             delay 5 seconds in deep sleep (give time for SNAP to enumerate)
+            (not after a software restart- sys reboot, bootAP, wifi reboot)
+            (time of each boot phase up to the first byte bridged- sys timeline)
 
             if boot flag on OR no wifi credentials stored-
                 start access point mode with telnet info port 2300 enabled
                 boot flag is cleared
 
             try to connect to available wifi access points using stored credentials
-                if unable, keep trying for a period of time, then reset
+                (the last good one first by bssid/channel, no scan- wifi fast)
+                if unable, or the connection is lost, keep trying (backing off
+                up to 32 sec) while the servers run- the uart bridges keep
+                capturing, clients get what was held once the link is back
+                (reboot only if wifi reboot=<seconds down> is set, see WifiLink.hpp)
                 telnet port 2300 = info
-                telnet port 2302 = uart2
+                telnet port 2302 = uart2 (uart always running, what the target prints
+                while no client is connected is kept in a backlog- uart2 backlog/replay)
+                telnet port 2303 = trace stream (binary, see Trace.hpp, host/tracedec)
+                telnet port 2304 = event log (connects, closes... see EventLog.hpp),
+                    also on uart0 (sys log)
+                uart0/uart1 bridges when enabled (uart<n> enable/port/pins/...),
+                    default ports 2310/2301
+                uart<n> compress=1 lets a telnet client ask for lz compressed
+                    output (host/lzcat)
+                http port 80 = console commands, /uart<n> browser terminal (websocket),
+                    /uart<n>/capture capture download (see uart<n> capture)
 
             if boot switch pressed >3 sec, reboot to access point mode
                 after releasing switch, the esp will reboot
@@ -47,14 +64,19 @@
 
 */
 #include <WiFi.h>
-#include <WiFiMulti.h>
 #include <rom/rtc.h> //reset reason
 
 
 #include "TelnetServer.hpp"
+#include "Bridges.hpp"
 #include "NvsSettings.hpp"
 #include "Commander.hpp"
 #include "WebServer.hpp"
+#include "Trace.hpp"
+#include "EventLog.hpp"
+#include "Reactor.hpp"
+#include "WifiLink.hpp"
+#include "BootTime.hpp"
 
 
 //sw_boot (IO0) long press = run wifi access point
@@ -66,46 +88,14 @@ Button sw_boot(0);
 LedStatus led_wifi(23);
 
 
-WiFiMulti wifiMulti;
-
-//create telnet servers
+//create telnet servers (uart bridges are in Bridges, from settings)
 TelnetServer telnet_info(2300, "info", TelnetServer::INFO);
-TelnetServer telnet_uart2(2302, "uart2", TelnetServer::SERIAL2);
-
-
-//restart whenever wifi connect problem
-void restart()
-{
-    Serial.printf("wifi connect failed, restarting in 10 seconds...\n\n");
-    delay(10000);
-    ESP.restart(); //just reboot and start over
-}
-
-//wifi connect, n attempts (n seconds)
-//if cannot connect, reset
-void wifi_connect(int n)
-{
-    //set hostname
-    //(setHostname code modified, so can set any time)
-    //(any reconnect will get latest hostname from settings,
-    // so will see new setting if disconnect/reconnect)
-    NvsSettings settings;
-    WiFi.setHostname(settings.hostname().c_str());
+TelnetServer telnet_trace(2303, "trace", TelnetServer::TRACE);
+TelnetServer telnet_log(2304, "log", TelnetServer::LOG);
 
-    led_wifi.slow();
+//web server- commands, and /uart<n> websockets to the bridges
+WebServer web_server(80, "http");
 
-    for(; ; delay(1000), n--){
-        if(n == 0) restart();
-        Serial.printf("connecting wifi...%d\n", n);
-        if(wifiMulti.run() == WL_CONNECTED){
-            Serial.printf("connected to SSID: %s\nclient IP: %s\nhostname: %s\n\n",
-                WiFi.SSID().c_str(), WiFi.localIP().toString().c_str(), settings.hostname().c_str()
-            );
-            break;
-        }
-    }
-    led_wifi.on();
-}
 
 //start access point if no wifi settings, or boot mode set
 //start telnet info server port 2300
@@ -123,20 +113,23 @@ void ap_mode(){
     NvsSettings settings;
     //back to STA for next boot
     settings.boot_to_AP(false);
+    NvsSettings::flush();
     WiFi.softAP(settings.APname().c_str());
     Serial.printf("access point ip address: %s\n\n",WiFi.softAPIP().toString().c_str());
 
     delay(2000);
 
     TelnetServer telnet_ap(2300, "info", TelnetServer::INFO);
-    WebServer web_server(80, "http");
+    WebServer web_ap(80, "http");
 
     telnet_ap.start();
-    web_server.start();
+    web_ap.start();
 
     for(;;){
         telnet_ap.check();
-        web_server.check();
+        web_ap.check();
+        NvsSettings::check();
+        Reactor::wait();
     }
 
     //to exit AP mode
@@ -151,93 +144,99 @@ void setup()
 {
     //delay a little before starting (5 sec)
     //(keep power down while usb enumerating when powered by SNAP)
-    //deepSleep any time we didn't just wake from deepSleep
-    //(any reset cause except deepSleep)
-    if(rtc_get_reset_reason(0) !=  DEEPSLEEP_RESET) ESP.deepSleep(5 * 1000000);
+    //deepSleep any time we didn't just wake from deepSleep, or restart
+    //ourselves (sys reboot, bootAP, wifi reboot- power is already up)
+    int reset = rtc_get_reset_reason(0);
+    if(reset != DEEPSLEEP_RESET and reset != SW_CPU_RESET) ESP.deepSleep(5 * 1000000);
+
+    //boot timeline (sys timeline)
+    BootTime::mark(BootTime::SETUP);
 
     //debug ouput
     Serial.begin(115200);
+    BootTime::mark(BootTime::SERIAL_UP);
 
     //led initially on (to show alive)
-    //wifi_connect() will take care of the rest
-    //(but will end up in wifi_connect() soon, so probably not worht it)
+    //(blinks slow while wifi is not connected, see loop())
     led_wifi.on();
 
-    //if boot mode set to AP, run access point
+    //server events to uart0 (log task), and telnet port 2304
     NvsSettings settings;
+    EventLog::start(settings.logout());
+    BootTime::mark(BootTime::SETTINGS);
+
+    //if boot mode set to AP, run access point
     if(settings.boot_to_AP()) ap_mode();
 
     //STA mode
     Serial.printf("\n== starting station mode ==\n");
 
-    //add stored wifi credentials, if none found goto AP mode
-    uint8_t maxn = settings.wifimaxn();
-    for( uint8_t i = 0, n = 0; i < maxn; ){
-        if(wifiMulti.addAP(settings.ssid(i).c_str(), settings.pass(i).c_str())){
-            Serial.printf("added wifi credentials [%d] from nvs storage\n", i);
-            n++;
-        }
-        if(++i == maxn and n == 0){
-            Serial.printf("no wifi credentials found, switching to AP mode\n");
-            ap_mode();
-        }
+    //stored wifi credentials, if none found goto AP mode
+    //(one line- uart0 output waits on the fifo)
+    uint8_t n = 0;
+    for(uint8_t i = 0; i < settings.wifimaxn(); i++) n += settings.ssid(i).length() > 0;
+    if(n == 0){
+        Serial.printf("no wifi credentials found, switching to AP mode\n");
+        ap_mode();
     }
+    Serial.printf("wifi credentials in nvs storage: %u\n", n);
 
-    //10 attempts
-    wifi_connect(10);
-
-    //telnet servers report address as 0.0.0.0 sometimes even though they
-    //are correct ip (obtained via dhcp), a little delay may help- now seems ok so far
-    delay(2000);
+    //connect in the background (WifiLink::check from loop), the servers
+    //listen on any address so start now- the bridges capture from boot
+    //(the event log shows the address once connected)
+    WifiLink::start();
+    led_wifi.slow();
 
     //start the servers
     telnet_info.start();
-    telnet_uart2.start();
-
-
-    /*
-    //just quickly testing some code for debugging output
-    //
-    static bool _init;
-    static uint32_t hash;
-    uint32_t myvar = 0x12345678;
-    //one time- give receiver a hash and other info associated with var
-    if(not _init){
-        std::string s = __FILE__; s += __FUNCTION__;
-        _hash = std::hash<std::string>{}(s);
-        Serial.printf(":%08X:%s:%s:%u:%s\n",hash,__FILE__,__FUNCTION__,__LINE__,"myvar");
-    }
-    //use hash to identify var, send out info
-    //receiver will know which var by the hash
-    Serial.printf(":%08X:%08X\n",hash,myvar);
-    //this could be binary to reduce size
-    //<hash><cp0count><uint32_t>
-    */
+    telnet_trace.start();
+    telnet_log.start();
+    Bridges::start();
+    web_server.start();
+    BootTime::mark(BootTime::SERVERS);
+
+    //trace points (Trace.hpp)- this one marks each boot in the trace stream
+    TRACE("boot", rtc_get_reset_reason(0));
 }
 
 
 
-//main loop
+//main loop- each source is checked, then the loop sleeps until one of them
+//has something to do (Reactor- sockets, uart rx, button, due times)
 void loop()
 {
-    //check if connection lost
-    if(wifiMulti.run() != WL_CONNECTED){
-        Serial.printf("wifi connection lost, attempting to reconnect...\n");
-        //try for 20 times (1 second interval), if failed just reset esp
-        wifi_connect(20);
+    BootTime::mark(BootTime::LOOP);
+
+    //wifi connect/reconnect (never waits), led on when connected
+    static bool was_up;
+    bool up = WifiLink::check();
+    if(up != was_up){
+        if(up) led_wifi.on();
+        else led_wifi.slow();
+        was_up = up;
     }
 
     //let each server check client connections/data
     telnet_info.check();
-    telnet_uart2.check();
+    telnet_trace.check();
+    telnet_log.check();
+    Bridges::check();
+    web_server.check();
+
+    //write changed settings once they stop changing
+    NvsSettings::check();
 
     //check switch - long press to go into AP mode
     if(sw_boot.long_press()){
         Serial.printf("BOOT switch long press, booting into AP mode...\n");
         telnet_info.stop();
-        telnet_uart2.stop();
+        telnet_trace.stop();
+        telnet_log.stop();
+        Bridges::stop();
+        web_server.stop();
         NvsSettings settings;
         settings.boot_to_AP(true);
+        NvsSettings::flush();
         //led blink fast 2sec, then off 2sec
         //wait for release so sw is not pressed when rebooted
         //which would then boot into bootloader
@@ -251,4 +250,7 @@ void loop()
         delay(100); //debounce time up
         ESP.restart();
     }
+    sw_boot.arm();
+
+    Reactor::wait();
 }